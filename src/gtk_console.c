@@ -594,7 +594,7 @@ static gboolean sleep_run(void *Data) {
 	return FALSE;
 }
 
-ML_FUNCTIONX(MLSleep) {
+ML_FUNCTIONX(ConsoleSleep) {
 //@sleep
 	ML_CHECKX_ARG_COUNT(1);
 	ML_CHECKX_ARG_TYPE(0, MLNumberT);
@@ -773,7 +773,7 @@ console_t *console_new(ml_context_t *Context, ml_getter_t GlobalGet, void *Globa
 
 #ifdef ML_SCHEDULER
 	ml_compiler_define(Console->Compiler, "schedule", ml_cfunctionx(Console, (ml_callbackx_t)console_schedule));
-	ml_compiler_define(Console->Compiler, "sleep", (ml_value_t *)MLSleep);
+	ml_compiler_define(Console->Compiler, "sleep", (ml_value_t *)ConsoleSleep);
 #endif
 
 	if (g_key_file_has_key(Console->Config, "gtk-console", "font", NULL)) {
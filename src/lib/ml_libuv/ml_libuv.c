@@ -1,40 +1,208 @@
 #include "ml_libuv.h"
+#include <stdio.h>
+#ifdef ML_THREADSAFE
+#include <pthread.h>
+#endif
 
-uv_loop_t *Loop;
-static uv_idle_t Idle[1];
+// Each thread running minilang code under libuv has its own loop, scheduler queue, idle handle and counter.
+// The thread that loads the library uses uv_default_loop(), uv::thread() starts further threads each with a new loop.
+// Handles belong to the loop of the thread that created them, values (and detached sockets) are passed between
+// loops with thread channels and semaphores, which resume parked states through the receiving loop's async handle.
 
-static unsigned int MLUVCounter = 100;
+typedef struct {
+	uv_loop_t *Loop;
+	uv_idle_t Idle[1];
+#ifdef ML_THREADSAFE
+	uv_async_t Async[1];
+	int Threads;
+#endif
+	unsigned int Counter;
+	int Preempting;
+} ml_uv_loop_t;
+
+#ifdef ML_THREADSAFE
+static __thread ml_uv_loop_t *CurrentLoop = NULL;
+#else
+static ml_uv_loop_t *CurrentLoop = NULL;
+#endif
+
+// Running states are preempted by time rather than by instruction count.
+#define ML_UV_TIME_SLICE 1000
+
+#ifdef ML_THREADSAFE
+static void ml_uv_keepalive(ml_uv_loop_t *UVLoop);
+#endif
 
 static void ml_uv_resume(uv_idle_t *Idle) {
+	ml_uv_loop_t *UVLoop = (ml_uv_loop_t *)Idle->data;
 	ml_queued_state_t QueuedState = ml_scheduler_queue_next();
 	if (QueuedState.State) {
-		MLUVCounter = 100;
+		UVLoop->Counter = UINT_MAX;
 		QueuedState.State->run(QueuedState.State, QueuedState.Value);
 	} else {
 		uv_idle_stop(Idle);
+#ifdef ML_THREADSAFE
+		ml_uv_keepalive(UVLoop);
+#endif
 	}
 }
 
-static void ml_uv_swap(ml_state_t *State, ml_value_t *Value) {
+void ml_uv_queue_add(ml_state_t *State, ml_value_t *Value) {
 	if (ml_scheduler_queue_add(State, Value) == 1) {
-		uv_idle_start(Idle, ml_uv_resume);
+		uv_idle_start(CurrentLoop->Idle, ml_uv_resume);
 	}
 }
 
+static void ml_uv_swap(ml_state_t *State, ml_value_t *Value) {
+	return ml_uv_queue_add(State, Value);
+}
+
+#ifdef ML_THREADSAFE
+
+// States resumed from other threads are signalled through an async handle.
+// The handle is unreferenced so that it does not keep the loop running by itself, except while threads started from this loop are running
+// or states are parked waiting for other threads (such as receivers on a thread channel).
+
+static void ml_uv_signalled(uv_async_t *Async) {
+	ml_uv_loop_t *UVLoop = (ml_uv_loop_t *)Async->data;
+	uv_idle_start(UVLoop->Idle, ml_uv_resume);
+}
+
+static void ml_uv_keepalive(ml_uv_loop_t *UVLoop) {
+	if (UVLoop->Threads || ml_scheduler_queue_parked()) {
+		uv_ref((uv_handle_t *)UVLoop->Async);
+	} else {
+		uv_unref((uv_handle_t *)UVLoop->Async);
+	}
+}
+
+#endif
+
 static ml_schedule_t ml_uv_scheduler(ml_context_t *Context) {
-	return (ml_schedule_t){&MLUVCounter, ml_uv_swap};
+	return (ml_schedule_t){&CurrentLoop->Counter, ml_uv_swap};
+}
+
+static ml_uv_loop_t *ml_uv_loop_new(uv_loop_t *Loop) {
+	// Loops started by uv::thread() are freed when their thread exits, after the counter is removed from the preemption timer.
+	ml_uv_loop_t *UVLoop = GC_MALLOC_UNCOLLECTABLE(sizeof(ml_uv_loop_t));
+	UVLoop->Loop = Loop;
+	UVLoop->Counter = UINT_MAX;
+	uv_idle_init(Loop, UVLoop->Idle);
+	UVLoop->Idle->data = UVLoop;
+#ifdef ML_THREADSAFE
+	uv_async_init(Loop, UVLoop->Async, ml_uv_signalled);
+	UVLoop->Async->data = UVLoop;
+	uv_unref((uv_handle_t *)UVLoop->Async);
+	ml_scheduler_queue_wakeup((void *)uv_async_send, UVLoop->Async);
+#endif
+	return CurrentLoop = UVLoop;
+}
+
+static void ml_uv_run(ml_state_t *Caller, ml_value_t *Function, int Count, ml_value_t **Args) {
+	ml_uv_loop_t *UVLoop = CurrentLoop;
+	if (!UVLoop->Preempting) {
+		UVLoop->Preempting = 1;
+		ml_scheduler_preempt(&UVLoop->Counter, ML_UV_TIME_SLICE);
+	}
+	ml_state_t *State = ml_state_new(Caller);
+	ml_context_set(State->Context, ML_SCHEDULER_INDEX, ml_uv_scheduler);
+	ml_call(State, Function, Count, Args);
+#ifdef ML_THREADSAFE
+	ml_uv_keepalive(UVLoop);
+#endif
+	uv_run(UVLoop->Loop, UV_RUN_DEFAULT);
 }
 
 ML_FUNCTIONX(Run) {
+//@uv::run
+//<Function
+// Calls :mini:`Function()` using the libuv scheduler and runs the event loop of the current thread until it has no more active handles.
 	ML_CHECKX_ARG_COUNT(1);
 	ML_CHECKX_ARG_TYPE(0, MLFunctionT);
-	ml_state_t *State = ml_state_new(Caller);
-	ml_context_set(State->Context, ML_SCHEDULER_INDEX, ml_uv_scheduler);
-	ml_value_t *Function = Args[0];
-	ml_call(State, Function, 0, NULL);
+	if (!CurrentLoop) ML_ERROR("LoopError", "No libuv loop on this thread");
+	return ml_uv_run(Caller, Args[0], 0, NULL);
+}
+
+#ifdef ML_THREADSAFE
+
+typedef struct {
+	ml_state_t Base;
+	ml_uv_loop_t *Origin;
+	ml_scheduler_queue_t *Queue;
+	ml_context_t *Context;
+	ml_value_t *Function;
+	ml_value_t **Args;
+	int Count;
+} ml_uv_thread_t;
+
+static void ml_uv_thread_done(ml_uv_thread_t *Thread, ml_value_t *Value) {
+	// Runs on the thread that called uv::thread().
+	ml_uv_loop_t *UVLoop = Thread->Origin;
+	if (!--UVLoop->Threads) uv_unref((uv_handle_t *)UVLoop->Async);
+	ml_state_t *Caller = Thread->Base.Caller;
+	ML_RETURN(Value);
+}
+
+static void *ml_uv_thread_start(void *Data) {
+	ml_uv_thread_t *Thread = (ml_uv_thread_t *)Data;
+	uv_loop_t *Loop = new(uv_loop_t);
+	uv_loop_init(Loop);
+	ml_scheduler_queue_init(4);
+	ml_uv_loop_new(Loop);
+	ml_result_state_t *State = ml_result_state_new(Thread->Context);
+	State->Value = NULL;
+	ml_uv_run((ml_state_t *)State, Thread->Function, Thread->Count, Thread->Args);
+	ml_value_t *Result = State->Value ?: ml_error("ThreadError", "Function did not complete before its loop stopped");
+	ml_uv_loop_t *UVLoop = CurrentLoop;
+	ml_scheduler_queue_wakeup(NULL, NULL);
+	uv_close((uv_handle_t *)UVLoop->Idle, NULL);
+	uv_close((uv_handle_t *)UVLoop->Async, NULL);
 	uv_run(Loop, UV_RUN_DEFAULT);
+	uv_loop_close(Loop);
+	if (UVLoop->Preempting) ml_scheduler_preempt_remove(&UVLoop->Counter, ML_UV_TIME_SLICE);
+	CurrentLoop = NULL;
+	GC_free(UVLoop);
+	ml_scheduler_queue_add_signal(Thread->Queue, (ml_state_t *)Thread, Result);
+	return NULL;
 }
 
+ML_FUNCTIONX(Thread) {
+//@uv::thread
+//<Function
+//<Args...
+//>any
+// Starts a new thread with its own libuv loop and scheduler and calls :mini:`Function(Args...)` in it.
+// The current state is suspended (while the current loop keeps running) until the new loop has no more active handles, then returns the result of :mini:`Function`.
+// Handles can only be used on the loop that created them, use :mini:`channel::threads` or :mini:`semaphore::threads` to pass values between loops
+// and :mini:`Stream:detach` with :mini:`tcp(Fd)` to move a connection to another loop.
+	ML_CHECKX_ARG_COUNT(1);
+	if (!CurrentLoop) ML_ERROR("LoopError", "No libuv loop on this thread");
+	ml_uv_thread_t *Thread = new(ml_uv_thread_t);
+	Thread->Base.Caller = Caller;
+	Thread->Base.Context = Caller->Context;
+	Thread->Base.run = (ml_state_fn)ml_uv_thread_done;
+	// The new thread runs in its own child context so that it never changes the slots of the caller's context.
+	Thread->Context = ml_context_new(Caller->Context);
+	Thread->Origin = CurrentLoop;
+	Thread->Function = ml_deref(Args[0]);
+	Thread->Count = Count - 1;
+	Thread->Args = anew(ml_value_t *, Count - 1);
+	for (int I = 1; I < Count; ++I) Thread->Args[I - 1] = ml_deref(Args[I]);
+	Thread->Queue = ml_scheduler_queue_park();
+	if (!Thread->Queue) ML_ERROR("LoopError", "No scheduler queue on this thread");
+	if (!CurrentLoop->Threads++) uv_ref((uv_handle_t *)CurrentLoop->Async);
+	pthread_t Handle;
+	if (pthread_create(&Handle, NULL, ml_uv_thread_start, Thread)) {
+		if (!--CurrentLoop->Threads) uv_unref((uv_handle_t *)CurrentLoop->Async);
+		// The parked state must still be signalled exactly once.
+		ml_scheduler_queue_add_signal(Thread->Queue, (ml_state_t *)Thread, ml_error("ThreadError", "Error starting thread"));
+		return;
+	}
+	pthread_detach(Handle);
+}
+
+#endif
+
 void *ml_calloc(size_t Count, size_t Size) {
 	return GC_malloc(Count * Size);
 }
@@ -50,13 +218,12 @@ extern void ml_libuv_pipe_init(stringmap_t *Globals);
 extern void ml_libuv_tcp_init(stringmap_t *Globals);
 
 uv_loop_t *ml_libuv_loop() {
-	return Loop;
+	return CurrentLoop->Loop;
 }
 
 void ml_library_entry(ml_value_t *Module, ml_getter_t GlobalGet, void *Globals) {
 	uv_replace_allocator(GC_malloc, GC_realloc, ml_calloc, ml_free);
-	Loop = uv_default_loop();
-	uv_idle_init(Loop, Idle);
+	ml_uv_loop_new(uv_default_loop());
 #include "ml_libuv_init.c"
 	ml_libuv_file_init(((ml_module_t *)Module)->Exports);
 	ml_libuv_process_init(((ml_module_t *)Module)->Exports);
@@ -65,5 +232,7 @@ void ml_library_entry(ml_value_t *Module, ml_getter_t GlobalGet, void *Globals)
 	ml_libuv_pipe_init(((ml_module_t *)Module)->Exports);
 	ml_libuv_tcp_init(((ml_module_t *)Module)->Exports);
 	ml_module_export(Module, "run", (ml_value_t *)Run);
+#ifdef ML_THREADSAFE
+	ml_module_export(Module, "thread", (ml_value_t *)Thread);
+#endif
 }
-
@@ -24,6 +24,10 @@ extern ml_type_t UVStreamT[];
 extern ml_type_t UVPipeT[];
 extern ml_type_t UVTcpT[];
 
-extern uv_loop_t *Loop;
+// Returns the libuv loop of the current thread.
+uv_loop_t *ml_libuv_loop();
+
+// Queues State to run with Value on the current thread's loop, used to resume states from libuv callbacks.
+void ml_uv_queue_add(ml_state_t *State, ml_value_t *Value);
 
 #endif
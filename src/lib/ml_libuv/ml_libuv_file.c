@@ -11,7 +11,7 @@ static void ml_uv_fs_open_cb(uv_fs_t *Request) {
 		Result = ml_error("OpenError", "error opening file %s", Request->path);
 	}
 	uv_fs_req_cleanup(Request);
-	ml_scheduler_queue_add(Caller, Result);
+	ml_uv_queue_add(Caller, Result);
 }
 
 ML_FUNCTIONX(UVFileOpen) {
@@ -28,7 +28,7 @@ ML_FUNCTIONX(UVFileOpen) {
 	int Mode = ml_integer_value(Args[2]);
 	uv_fs_t *Request = new(uv_fs_t);
 	Request->data = Caller;
-	uv_fs_open(Loop, Request, Path, Flags, Mode, ml_uv_fs_open_cb);
+	uv_fs_open(ml_libuv_loop(), Request, Path, Flags, Mode, ml_uv_fs_open_cb);
 }
 
 ML_TYPE(UVFileT, (), "uv-file",
@@ -45,14 +45,14 @@ static ml_value_t *ml_uv_file_new(ssize_t Handle) {
 static void ml_uv_fs_close_cb(uv_fs_t *Request) {
 	ml_state_t *Caller = (ml_state_t *)Request->data;
 	uv_fs_req_cleanup(Request);
-	ml_scheduler_queue_add(Caller, MLNil);
+	ml_uv_queue_add(Caller, MLNil);
 }
 
 ML_METHODX("close", UVFileT) {
 	ml_uv_file_t *File = (ml_uv_file_t *)Args[0];
 	uv_fs_t *Request = new(uv_fs_t);
 	Request->data = Caller;
-	uv_fs_close(Loop, Request, File->Handle, ml_uv_fs_close_cb);
+	uv_fs_close(ml_libuv_loop(), Request, File->Handle, ml_uv_fs_close_cb);
 }
 
 typedef struct ml_uv_fs_buf_t {
@@ -69,7 +69,7 @@ static void ml_uv_fs_read_cb(ml_uv_fs_buf_t *Request) {
 		Result = ml_error("ReadError", "error reading from file");
 	}
 	uv_fs_req_cleanup((uv_fs_t *)Request);
-	ml_scheduler_queue_add(Caller, Result);
+	ml_uv_queue_add(Caller, Result);
 }
 
 ML_METHODX("read", UVFileT, MLIntegerT) {
@@ -79,7 +79,7 @@ ML_METHODX("read", UVFileT, MLIntegerT) {
 	Request->Base.data = Caller;
 	Request->IOV[0].base = GC_MALLOC_ATOMIC(Length);
 	Request->IOV[0].len = Length;
-	uv_fs_read(Loop, (uv_fs_t *)Request, File->Handle, Request->IOV, 1, -1, (uv_fs_cb)ml_uv_fs_read_cb);
+	uv_fs_read(ml_libuv_loop(), (uv_fs_t *)Request, File->Handle, Request->IOV, 1, -1, (uv_fs_cb)ml_uv_fs_read_cb);
 }
 
 static void ml_uv_fs_write_cb(ml_uv_fs_buf_t *Request) {
@@ -91,7 +91,7 @@ static void ml_uv_fs_write_cb(ml_uv_fs_buf_t *Request) {
 		Result = ml_error("WriteError", "error writing to file");
 	}
 	uv_fs_req_cleanup((uv_fs_t *)Request);
-	ml_scheduler_queue_add(Caller, Result);
+	ml_uv_queue_add(Caller, Result);
 }
 
 ML_METHODX("write", UVFileT, MLAddressT) {
@@ -100,7 +100,7 @@ ML_METHODX("write", UVFileT, MLAddressT) {
 	Request->Base.data = Caller;
 	Request->IOV[0].base = (char *)ml_address_value(Args[1]);
 	Request->IOV[0].len = ml_address_length(Args[1]);
-	uv_fs_write(Loop, (uv_fs_t *)Request, File->Handle, Request->IOV, 1, -1, (uv_fs_cb)ml_uv_fs_write_cb);
+	uv_fs_write(ml_libuv_loop(), (uv_fs_t *)Request, File->Handle, Request->IOV, 1, -1, (uv_fs_cb)ml_uv_fs_write_cb);
 }
 
 static void ml_uv_fs_operation_cb(uv_fs_t *Request) {
@@ -110,7 +110,7 @@ static void ml_uv_fs_operation_cb(uv_fs_t *Request) {
 		Result = ml_error("FSError", "%s", uv_strerror(Request->result));
 	}
 	uv_fs_req_cleanup(Request);
-	ml_scheduler_queue_add(Caller, Result);
+	ml_uv_queue_add(Caller, Result);
 }
 
 ML_FUNCTIONX(UVUnlink) {
@@ -118,7 +118,7 @@ ML_FUNCTIONX(UVUnlink) {
 	ML_CHECKX_ARG_TYPE(0, MLStringT);
 	const char *Path = ml_string_value(Args[0]);
 	uv_fs_t *Request = new(uv_fs_t);
-	uv_fs_unlink(Loop, Request, Path, ml_uv_fs_operation_cb);
+	uv_fs_unlink(ml_libuv_loop(), Request, Path, ml_uv_fs_operation_cb);
 }
 
 ML_FUNCTIONX(UVCopyFile) {
@@ -128,7 +128,7 @@ ML_FUNCTIONX(UVCopyFile) {
 	const char *Path = ml_string_value(Args[0]);
 	const char *NewPath = ml_string_value(Args[1]);
 	uv_fs_t *Request = new(uv_fs_t);
-	uv_fs_copyfile(Loop, Request, Path, NewPath, 0, ml_uv_fs_operation_cb);
+	uv_fs_copyfile(ml_libuv_loop(), Request, Path, NewPath, 0, ml_uv_fs_operation_cb);
 }
 
 void ml_libuv_file_init(stringmap_t *Globals) {
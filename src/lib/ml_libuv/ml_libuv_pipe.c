@@ -5,7 +5,7 @@ ML_TYPE(UVPipeT, (UVStreamT), "uv-pipe");
 ML_METHOD(UVPipeT) {
 	ml_uv_handle_t *S = new(ml_uv_handle_t);
 	S->Type = UVPipeT;
-	uv_pipe_init(Loop, &S->Handle.pipe, 0);
+	uv_pipe_init(ml_libuv_loop(), &S->Handle.pipe, 0);
 	S->Handle.pipe.data = S;
 	return (ml_value_t *)S;
 }
@@ -13,7 +13,7 @@ ML_METHOD(UVPipeT) {
 ML_METHOD(UVPipeT, MLBooleanT) {
 	ml_uv_handle_t *S = new(ml_uv_handle_t);
 	S->Type = UVPipeT;
-	uv_pipe_init(Loop, &S->Handle.pipe, Args[0] == (ml_value_t *)MLTrue);
+	uv_pipe_init(ml_libuv_loop(), &S->Handle.pipe, Args[0] == (ml_value_t *)MLTrue);
 	S->Handle.pipe.data = S;
 	return (ml_value_t *)S;
 }
@@ -34,7 +34,7 @@ ML_METHOD("bind", UVPipeT, MLStringT) {
 
 static void ml_uv_pipe_connect_cb(uv_connect_t *Request, int Status) {
 	ml_state_t *Caller = (ml_state_t *)Request->data;
-	ml_scheduler_queue_add(Caller, MLNil);
+	ml_uv_queue_add(Caller, MLNil);
 }
 
 ML_METHODX("connect", UVPipeT, MLStringT) {
@@ -9,7 +9,7 @@ static stringmap_t UVProcessOptions[1] = {STRINGMAP_INIT};
 static void ml_uv_process_exit_cb(uv_process_t *Request, int64_t Status, int Signal) {
 	ml_state_t *Caller = (ml_state_t *)Request->data;
 	uv_close((uv_handle_t *)Request, NULL);
-	ml_scheduler_queue_add(Caller, ml_integer(Status));
+	ml_uv_queue_add(Caller, ml_integer(Status));
 }
 
 ML_METHODX(UVSpawnMethod, MLStringT, MLListT) {
@@ -25,7 +25,7 @@ ML_METHODX(UVSpawnMethod, MLStringT, MLListT) {
 	Options->exit_cb = ml_uv_process_exit_cb;
 	uv_process_t *Request = new(uv_process_t);
 	Request->data = Caller;
-	int Result = uv_spawn(Loop, Request, Options);
+	int Result = uv_spawn(ml_libuv_loop(), Request, Options);
 	if (Result) ML_ERROR("SpawnError", "%s", uv_strerror(Result));
 }
 
@@ -49,7 +49,7 @@ ML_METHODVX(UVSpawnMethod, MLStringT, MLListT, MLNamesT) {
 	}
 	uv_process_t *Request = new(uv_process_t);
 	Request->data = Caller;
-	uv_spawn(Loop, Request, Options);
+	uv_spawn(ml_libuv_loop(), Request, Options);
 }
 
 ML_METHODVX(UVSpawnMethod, MLStringT, MLNamesT) {
@@ -66,7 +66,7 @@ ML_METHODVX(UVSpawnMethod, MLStringT, MLNamesT) {
 	}
 	uv_process_t *Request = new(uv_process_t);
 	Request->data = Caller;
-	uv_spawn(Loop, Request, Options);
+	uv_spawn(ml_libuv_loop(), Request, Options);
 }
 
 static ml_value_t *ml_uv_process_option_cwd(uv_process_options_t *Options, ml_value_t *Value) {
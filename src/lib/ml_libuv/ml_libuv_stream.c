@@ -1,6 +1,8 @@
 #include "ml_libuv.h"
 #include <stdio.h>
 #include <string.h>
+#include <errno.h>
+#include <unistd.h>
 #include <gc/gc_typed.h>
 
 ML_TYPE(UVStreamT, (UVHandleT), "uv-stream");
@@ -10,12 +12,12 @@ static void ml_uv_connection_cb(uv_stream_t *Server, int Status) {
 	switch (Server->type) {
 	case UV_NAMED_PIPE: {
 		C->Type = UVPipeT;
-		uv_pipe_init(Loop, &C->Handle.pipe, ((uv_pipe_t *)Server)->ipc);
+		uv_pipe_init(ml_libuv_loop(), &C->Handle.pipe, ((uv_pipe_t *)Server)->ipc);
 		break;
 	}
 	case UV_TCP: {
 		C->Type = UVTcpT;
-		uv_tcp_init(Loop, &C->Handle.tcp);
+		uv_tcp_init(ml_libuv_loop(), &C->Handle.tcp);
 		break;
 	}
 	default: {
@@ -50,7 +52,11 @@ struct ml_uv_buffer_t {
 };
 
 static GC_descr BufferDesc = 0;
+#ifdef ML_THREADSAFE
+static __thread ml_uv_buffer_t *CachedBuffers = 0;
+#else
 static ml_uv_buffer_t *CachedBuffers = 0;
+#endif
 
 static void ml_uv_alloc_cb(uv_handle_t *Handle, size_t Size, uv_buf_t *Buffer) {
 	ml_uv_buffer_t *Cached = CachedBuffers;
@@ -110,7 +116,7 @@ static void ml_uv_write_cb(ml_uv_write_t *Request, int Status) {
 	} else {
 		Result = MLNil;
 	}
-	ml_scheduler_queue_add(Caller, Result);
+	ml_uv_queue_add(Caller, Result);
 }
 
 ML_METHODX("write", UVStreamT, MLAddressT) {
@@ -122,6 +128,22 @@ ML_METHODX("write", UVStreamT, MLAddressT) {
 	uv_write((uv_write_t *)Request, &S->Handle.stream, Request->IOV, 1, (uv_write_cb)ml_uv_write_cb);
 }
 
+ML_METHOD("detach", UVStreamT) {
+//<Stream
+//>integer
+// Closes :mini:`Stream` on the current loop and returns a duplicate of its file descriptor.
+// The descriptor can be sent to another thread (e.g. through :mini:`channel::threads`) and opened there with :mini:`tcp(Fd)`.
+	ml_uv_handle_t *S = (ml_uv_handle_t *)Args[0];
+	uv_os_fd_t Fd;
+	int Status = uv_fileno(&S->Handle.handle, &Fd);
+	if (Status) return ml_error("StreamError", "%s", uv_strerror(Status));
+	int Copy = dup(Fd);
+	if (Copy < 0) return ml_error("StreamError", "%s", strerror(errno));
+	uv_read_stop(&S->Handle.stream);
+	uv_close(&S->Handle.handle, NULL);
+	return ml_integer(Copy);
+}
+
 void ml_libuv_stream_init(stringmap_t *Globals) {
 	GC_word BufferLayout[] = {1};
 	BufferDesc = GC_make_descriptor(BufferLayout, 1);
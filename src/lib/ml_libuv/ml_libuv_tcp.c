@@ -1,15 +1,77 @@
 #include "ml_libuv.h"
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
 
 ML_TYPE(UVTcpT, (UVStreamT), "uv-tcp");
 
 ML_METHOD(UVTcpT) {
 	ml_uv_handle_t *S = new(ml_uv_handle_t);
 	S->Type = UVTcpT;
-	uv_tcp_init(Loop, &S->Handle.tcp);
+	uv_tcp_init(ml_libuv_loop(), &S->Handle.tcp);
 	S->Handle.tcp.data = S;
 	return (ml_value_t *)S;
 }
 
+ML_METHOD(UVTcpT, MLIntegerT) {
+//<Fd
+//>uv-tcp
+// Returns a tcp handle on the current thread's loop for the existing socket :mini:`Fd`, e.g. one returned by :mini:`Stream:detach` on another loop.
+	ml_uv_handle_t *S = new(ml_uv_handle_t);
+	S->Type = UVTcpT;
+	uv_tcp_init(ml_libuv_loop(), &S->Handle.tcp);
+	S->Handle.tcp.data = S;
+	int Status = uv_tcp_open(&S->Handle.tcp, ml_integer_value(Args[0]));
+	if (Status) return ml_error("TcpError", "%s", uv_strerror(Status));
+	return (ml_value_t *)S;
+}
+
+static ml_value_t *ml_uv_tcp_bind(ml_uv_handle_t *S, const char *Host, int Port, int Shared) {
+	struct sockaddr_in Address;
+	int Status = uv_ip4_addr(Host, Port, &Address);
+	if (Status) return ml_error("TcpError", "%s", uv_strerror(Status));
+	if (Shared) {
+		// Each loop can bind its own listening socket to the same port and the kernel balances connections between them.
+		int Fd = socket(AF_INET, SOCK_STREAM, 0);
+		if (Fd < 0) return ml_error("TcpError", "%s", strerror(errno));
+		int Enable = 1;
+		if (setsockopt(Fd, SOL_SOCKET, SO_REUSEPORT, &Enable, sizeof(Enable))) {
+			close(Fd);
+			return ml_error("TcpError", "%s", strerror(errno));
+		}
+		Status = uv_tcp_open(&S->Handle.tcp, Fd);
+		if (Status) {
+			close(Fd);
+			return ml_error("TcpError", "%s", uv_strerror(Status));
+		}
+	}
+	Status = uv_tcp_bind(&S->Handle.tcp, (const struct sockaddr *)&Address, 0);
+	if (Status) return ml_error("TcpError", "%s", uv_strerror(Status));
+	return (ml_value_t *)S;
+}
+
+ML_METHOD("bind", UVTcpT, MLStringT, MLIntegerT) {
+//<Tcp
+//<Host
+//<Port
+//>uv-tcp
+// Binds :mini:`Tcp` to :mini:`Host` and :mini:`Port`.
+	return ml_uv_tcp_bind((ml_uv_handle_t *)Args[0], ml_string_value(Args[1]), ml_integer_value(Args[2]), 0);
+}
+
+ML_METHOD("bind", UVTcpT, MLStringT, MLIntegerT, MLBooleanT) {
+//<Tcp
+//<Host
+//<Port
+//<Shared
+//>uv-tcp
+// Binds :mini:`Tcp` to :mini:`Host` and :mini:`Port`. If :mini:`Shared` is :mini:`true`, the socket is created with :c:macro:`SO_REUSEPORT`
+// so that a listener on each loop (see :mini:`uv::thread`) can bind the same port.
+	return ml_uv_tcp_bind((ml_uv_handle_t *)Args[0], ml_string_value(Args[1]), ml_integer_value(Args[2]), Args[3] == (ml_value_t *)MLTrue);
+}
+
 void ml_libuv_tcp_init(stringmap_t *Globals) {
 #include "ml_libuv_tcp_init.c"
 	if (Globals) {
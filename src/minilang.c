@@ -14,6 +14,7 @@
 #ifdef ML_MATH
 #include "ml_math.h"
 #include "ml_array.h"
+#include "ml_sparse.h"
 #endif
 
 #ifdef ML_IO
@@ -250,13 +251,16 @@ ML_FUNCTION(Unload) {
 
 #ifdef ML_SCHEDULER
 
-static unsigned int SliceSize = 0, Counter;
+static unsigned int SliceSize = 0, TimeSlice = 0, Counter;
 
 static void simple_queue_run() {
 	ml_queued_state_t QueuedState;
 	for (;;) {
 		QueuedState = ml_scheduler_queue_next();
-		if (!QueuedState.State) break;
+		if (!QueuedState.State) {
+			if (ml_scheduler_queue_wait()) continue;
+			break;
+		}
 		Counter = SliceSize;
 		QueuedState.State->run(QueuedState.State, QueuedState.Value);
 	}
@@ -303,6 +307,14 @@ int main(int Argc, const char *Argv[]) {
 	stringmap_insert(Globals, "channel", MLChannelT);
 	stringmap_insert(Globals, "semaphore", MLSemaphoreT);
 	stringmap_insert(Globals, "context", MLContextKeyT);
+	stringmap_insert(Globals, "cancel", MLCancelT);
+	stringmap_insert(Globals, "deadline", MLDeadline);
+#ifdef ML_SCHEDULER
+	stringmap_insert(Globals, "sleep", MLSleep);
+	stringmap_insert(Globals, "timeout", MLTimeout);
+	stringmap_insert(Globals, "priority", MLPriority);
+	stringmap_insert(Globals, "quota", MLQuotaT);
+#endif
 	stringmap_insert(Globals, "parser", MLParserT);
 	stringmap_insert(Globals, "compiler", MLCompilerT);
 	stringmap_insert(Globals, "macro", MLMacroT);
@@ -321,6 +333,7 @@ int main(int Argc, const char *Argv[]) {
 #ifdef ML_MATH
 	ml_math_init(Globals);
 	ml_array_init(Globals);
+	ml_sparse_init(Globals);
 #endif
 #ifdef ML_IO
 	ml_io_init(Globals);
@@ -386,6 +399,14 @@ int main(int Argc, const char *Argv[]) {
 				}
 				SliceSize = atoi(Argv[I]);
 			break;
+			case 't':
+				if (++I >= Argc) {
+					printf("Error: time slice required\n");
+					exit(-1);
+				}
+				TimeSlice = atoi(Argv[I]);
+				SliceSize = UINT_MAX;
+			break;
 #endif
 			case 'z': GC_disable(); break;
 #ifdef ML_GTK_CONSOLE
@@ -402,10 +423,11 @@ int main(int Argc, const char *Argv[]) {
 		}
 	}
 #ifdef ML_SCHEDULER
+	ml_scheduler_queue_init(4);
 	if (SliceSize) {
 		Counter = SliceSize;
-		ml_scheduler_queue_init(4);
 		ml_context_set(&MLRootContext, ML_SCHEDULER_INDEX, simple_scheduler);
+		if (TimeSlice) ml_scheduler_preempt(&Counter, TimeSlice);
 	}
 #endif
 	if (FileName) {
@@ -421,7 +443,7 @@ int main(int Argc, const char *Argv[]) {
 		}
 #endif
 #ifdef ML_SCHEDULER
-		if (SliceSize) simple_queue_run();
+		simple_queue_run();
 #endif
 #ifdef ML_GTK_CONSOLE
 	} else if (GtkConsole) {
@@ -2,6 +2,7 @@
 #include "ml_macros.h"
 #include "ml_math.h"
 #include <stdint.h>
+#include <limits.h>
 #include <string.h>
 #include <stdarg.h>
 #include <math.h>
@@ -100,12 +101,12 @@ ml_array_t *ml_array(ml_array_format_t Format, int Degree, ...) {
 	int DataSize = MLArraySizes[Format];
 	va_list Sizes;
 	va_start(Sizes, Degree);
+	for (int I = 0; I < Degree; ++I) Array->Dimensions[I].Size = va_arg(Sizes, int);
+	va_end(Sizes);
 	for (int I = Degree; --I >= 0;) {
 		Array->Dimensions[I].Stride = DataSize;
-		int Size = Array->Dimensions[I].Size = va_arg(Sizes, int);
-		DataSize *= Size;
+		DataSize *= Array->Dimensions[I].Size;
 	}
-	va_end(Sizes);
 	Array->Base.Value = GC_MALLOC_ATOMIC(DataSize);
 	Array->Base.Length = DataSize;
 	return Array;
@@ -121,6 +122,22 @@ int ml_array_size(ml_value_t *Value, int Dim) {
 	return Array->Dimensions[Dim].Size;
 }
 
+static int array_is_contiguous(ml_array_t *Array) {
+	int64_t Stride = MLArraySizes[Array->Format];
+	for (int I = Array->Degree; --I >= 0;) {
+		if (Array->Dimensions[I].Indices) return 0;
+		if (Array->Dimensions[I].Stride != Stride) return 0;
+		Stride *= Array->Dimensions[I].Size;
+	}
+	return 1;
+}
+
+static size_t array_count(ml_array_t *Array) {
+	size_t Count = 1;
+	for (int I = 0; I < Array->Degree; ++I) Count *= Array->Dimensions[I].Size;
+	return Count;
+}
+
 typedef struct ml_array_init_state_t {
 	ml_state_t Base;
 	char *Address;
@@ -619,10 +636,16 @@ ml_value_t *ml_array_index(ml_array_t *Source, int Count, ml_value_t **Indices)
 			if (IndexArray->Degree != 1) return ml_error("IndexError", "Index array must have degree 1");
 			int Size = TargetDimension->Size = IndexArray->Dimensions[0].Size;
 			if (!Size) return ml_error("IndexError", "Empty dimension");
+			if (IndexArray->Format != ML_ARRAY_FORMAT_I64 || !array_is_contiguous(IndexArray)) {
+				ml_array_t *Copy = ml_array_new(ML_ARRAY_FORMAT_I64, 1);
+				array_copy(Copy, IndexArray);
+				IndexArray = Copy;
+			}
+			int64_t *IndexValues = (int64_t *)IndexArray->Base.Value;
 			int *Indices = TargetDimension->Indices = (int *)GC_MALLOC_ATOMIC(Size * sizeof(int));
 			int *IndexPtr = Indices;
 			for (int I = 0; I < Size; ++I) {
-				int IndexValue = ml_array_get_int32_t(IndexArray, I);
+				int IndexValue = IndexValues[I];
 				if (IndexValue <= 0) IndexValue += SourceDimension->Size + 1;
 				if (--IndexValue < 0) return MLNil;
 				if (IndexValue >= SourceDimension->Size) return MLNil;
@@ -704,6 +727,70 @@ ML_METHOD("[]", MLArrayT, MLMapT) {
 	return ml_array_index(Source, Degree, Indices);
 }
 
+static size_t ml_array_mask_select(int Degree, ml_array_dimension_t *Dimension, int64_t Offset, ml_array_dimension_t *MaskDimension, char *Mask, int64_t *Offsets) {
+	int Size = Dimension->Size;
+	int Stride = Dimension->Stride, MaskStride = MaskDimension->Stride;
+	int *SourceIndices = Dimension->Indices, *MaskIndices = MaskDimension->Indices;
+	size_t Count = 0;
+	if (Degree == 1) {
+		for (int I = 0; I < Size; ++I) {
+			if (*(int8_t *)(Mask + (int64_t)(MaskIndices ? MaskIndices[I] : I) * MaskStride)) {
+				if (Offsets) Offsets[Count] = Offset + (int64_t)(SourceIndices ? SourceIndices[I] : I) * Stride;
+				++Count;
+			}
+		}
+	} else {
+		for (int I = 0; I < Size; ++I) {
+			Count += ml_array_mask_select(Degree - 1, Dimension + 1,
+				Offset + (int64_t)(SourceIndices ? SourceIndices[I] : I) * Stride,
+				MaskDimension + 1, Mask + (int64_t)(MaskIndices ? MaskIndices[I] : I) * MaskStride,
+				Offsets ? Offsets + Count : NULL
+			);
+		}
+	}
+	return Count;
+}
+
+ML_METHOD("mask", MLArrayT, MLArrayInt8T) {
+//<Array
+//<Mask
+//>array
+// Returns a one dimensional sub-array of :mini:`Array` sharing the underlying data, containing the values where :mini:`Mask` is non-zero.
+// :mini:`Mask` must have the same shape as :mini:`Array`, e.g. the result of comparing :mini:`Array` to a value.
+// Assigning to the returned array updates the selected values of :mini:`Array`, e.g. :mini:`A:mask(A < 0) := 0`.
+	ml_array_t *Source = (ml_array_t *)Args[0];
+	ml_array_t *Mask = (ml_array_t *)Args[1];
+	int Degree = Source->Degree;
+	if (!Degree) return ml_error("ShapeError", "Array must have degree at least 1");
+	if (Mask->Degree != Degree) return ml_error("ShapeError", "Mask must have the same shape as array");
+	for (int I = 0; I < Degree; ++I) {
+		if (Source->Dimensions[I].Size != Mask->Dimensions[I].Size) return ml_error("ShapeError", "Mask must have the same shape as array");
+	}
+	int ItemSize = MLArraySizes[Source->Format];
+	for (int I = 0; I < Degree; ++I) {
+		if (Source->Dimensions[I].Stride % ItemSize) ItemSize = 1;
+	}
+	size_t Selected = ml_array_mask_select(Degree, Source->Dimensions, 0, Mask->Dimensions, Mask->Base.Value, NULL);
+	if (Selected > INT_MAX) return ml_error("ShapeError", "Too many values selected");
+	ml_array_t *Target = ml_array_new(Source->Format, 1);
+	Target->Dimensions[0].Size = Selected;
+	Target->Dimensions[0].Stride = ItemSize;
+	Target->Base.Value = Source->Base.Value;
+	if (Selected) {
+		int64_t *Offsets = (int64_t *)GC_MALLOC_ATOMIC(Selected * sizeof(int64_t));
+		ml_array_mask_select(Degree, Source->Dimensions, 0, Mask->Dimensions, Mask->Base.Value, Offsets);
+		int64_t First = Offsets[0];
+		int *Indices = Target->Dimensions[0].Indices = (int *)GC_MALLOC_ATOMIC(Selected * sizeof(int));
+		for (size_t I = 0; I < Selected; ++I) {
+			int64_t Index = (Offsets[I] - First) / ItemSize;
+			if (Index < INT_MIN || Index > INT_MAX) return ml_error("ShapeError", "Selected values are too far apart");
+			Indices[I] = Index;
+		}
+		Target->Base.Value += First;
+	}
+	return (ml_value_t *)Target;
+}
+
 static char *ml_array_indexv(ml_array_t *Array, va_list Indices) {
 	ml_array_dimension_t *Dimension = Array->Dimensions;
 	char *Address = Array->Base.Value;
@@ -799,56 +886,48 @@ static void ML_TYPED_FN(ml_iter_key, MLArrayIteratorT, ml_state_t *Caller, ml_ar
 	ML_RETURN(Tuple);
 }
 
-static void ML_TYPED_FN(ml_iterate, MLArrayT, ml_state_t *Caller, ml_array_t *Array) {
-	ml_array_iterator_t *Iterator = xnew(ml_array_iterator_t, Array->Degree, ml_array_iter_dim_t);
-	Iterator->Type = MLArrayIteratorT;
-	Iterator->Address = Array->Base.Value;
-	Iterator->Degree = Array->Degree;
-	switch (Array->Format) {
+static ml_array_iter_val_t array_iter_val_fn(ml_array_format_t Format) {
+	switch (Format) {
 	case ML_ARRAY_FORMAT_I8:
-		Iterator->ToVal = ml_array_iter_val_int8_t;
-		break;
+		return ml_array_iter_val_int8_t;
 	case ML_ARRAY_FORMAT_U8:
-		Iterator->ToVal = ml_array_iter_val_uint8_t;
-		break;
+		return ml_array_iter_val_uint8_t;
 	case ML_ARRAY_FORMAT_I16:
-		Iterator->ToVal = ml_array_iter_val_int16_t;
-		break;
+		return ml_array_iter_val_int16_t;
 	case ML_ARRAY_FORMAT_U16:
-		Iterator->ToVal = ml_array_iter_val_uint16_t;
-		break;
+		return ml_array_iter_val_uint16_t;
 	case ML_ARRAY_FORMAT_I32:
-		Iterator->ToVal = ml_array_iter_val_int32_t;
-		break;
+		return ml_array_iter_val_int32_t;
 	case ML_ARRAY_FORMAT_U32:
-		Iterator->ToVal = ml_array_iter_val_uint32_t;
-		break;
+		return ml_array_iter_val_uint32_t;
 	case ML_ARRAY_FORMAT_I64:
-		Iterator->ToVal = ml_array_iter_val_int64_t;
-		break;
+		return ml_array_iter_val_int64_t;
 	case ML_ARRAY_FORMAT_U64:
-		Iterator->ToVal = ml_array_iter_val_uint64_t;
-		break;
+		return ml_array_iter_val_uint64_t;
 	case ML_ARRAY_FORMAT_F32:
-		Iterator->ToVal = ml_array_iter_val_float;
-		break;
+		return ml_array_iter_val_float;
 	case ML_ARRAY_FORMAT_F64:
-		Iterator->ToVal = ml_array_iter_val_double;
-		break;
+		return ml_array_iter_val_double;
 #ifdef ML_COMPLEX
 	case ML_ARRAY_FORMAT_C32:
-		Iterator->ToVal = ml_array_iter_val_complex_float;
-		break;
+		return ml_array_iter_val_complex_float;
 	case ML_ARRAY_FORMAT_C64:
-		Iterator->ToVal = ml_array_iter_val_complex_double;
-		break;
+		return ml_array_iter_val_complex_double;
 #endif
 	case ML_ARRAY_FORMAT_ANY:
-		Iterator->ToVal = ml_array_iter_val_any;
-		break;
+		return ml_array_iter_val_any;
 	default:
-		ML_ERROR("TypeError", "Invalid array type for iteration");
+		return NULL;
 	}
+}
+
+static void ML_TYPED_FN(ml_iterate, MLArrayT, ml_state_t *Caller, ml_array_t *Array) {
+	ml_array_iterator_t *Iterator = xnew(ml_array_iterator_t, Array->Degree, ml_array_iter_dim_t);
+	Iterator->Type = MLArrayIteratorT;
+	Iterator->Address = Array->Base.Value;
+	Iterator->Degree = Array->Degree;
+	Iterator->ToVal = array_iter_val_fn(Array->Format);
+	if (!Iterator->ToVal) ML_ERROR("TypeError", "Invalid array type for iteration");
 	for (int I = 0; I < Array->Degree; ++I) {
 		Iterator->Dimensions[I].Size = Array->Dimensions[I].Size;
 		Iterator->Dimensions[I].Stride = Array->Dimensions[I].Stride;
@@ -859,6 +938,39 @@ static void ML_TYPED_FN(ml_iterate, MLArrayT, ml_state_t *Caller, ml_array_t *Ar
 	ML_RETURN(Iterator);
 }
 
+static int ML_TYPED_FN(ml_iter_block, MLArrayT, ml_array_t *Array, ml_iter_cursor_t *Cursor, ml_value_t **Keys, ml_value_t **Values, int Size) {
+	ml_array_iter_val_t ToVal = array_iter_val_fn(Array->Format);
+	if (!ToVal) return -1;
+	long Index = Cursor->Index;
+	long Total = array_count(Array);
+	int Count = Total - Index;
+	if (Count > Size) Count = Size;
+	int Degree = Array->Degree;
+	for (int I = 0; I < Count; ++I) {
+		long Linear = Index + I;
+		char *Address = Array->Base.Value;
+		ml_value_t *Key = Keys && Degree ? ml_tuple(Degree) : NULL;
+		for (int J = Degree; --J >= 0;) {
+			ml_array_dimension_t *Dimension = Array->Dimensions + J;
+			int Offset = Linear % Dimension->Size;
+			Linear /= Dimension->Size;
+			if (Key) ml_tuple_set(Key, J + 1, ml_integer(Offset + 1));
+			Address += (Dimension->Indices ? Dimension->Indices[Offset] : Offset) * Dimension->Stride;
+		}
+		if (Keys) Keys[I] = Key ?: ml_tuple(0);
+		if (Values) Values[I] = ToVal(Address);
+	}
+	Cursor->Index = Index + Count;
+	return Count;
+}
+
+static long ML_TYPED_FN(ml_iter_seek, MLArrayT, ml_array_t *Array, ml_iter_cursor_t *Cursor, long Index) {
+	if (!array_iter_val_fn(Array->Format)) return -1;
+	long Total = array_count(Array);
+	Cursor->Index = Index < Total ? Index : Total;
+	return Total;
+}
+
 #include "array/update_decl.h"
 
 #define UPDATE_ROW_ENTRY(INDEX, NAME, TARGET, SOURCE) \
@@ -1269,7 +1381,7 @@ static long srotl(long X, unsigned int N) {
 #define ARRAY_DECL(PREFIX, ATYPE, CTYPE, APPEND, PRINTF, FROM_VAL, TO_VAL, FROM_NUM, TO_NUM, FORMAT, HASH) \
 \
 static ml_value_t *ML_TYPED_FN(ml_array_value, ATYPE, ml_array_t *Array, char *Address) { \
-	return TO_VAL(*(CTYPE *)Array->Base.Value); \
+	return TO_VAL(*(CTYPE *)Address); \
 } \
 \
 static void append_array_ ## CTYPE(ml_stringbuffer_t *Buffer, int Degree, ml_array_dimension_t *Dimension, char *Address) { \
@@ -1815,9 +1927,13 @@ static char *array_flatten_to(char *Target, int Size, int Degree, int FlatDegree
 
 static char *array_flatten(ml_array_t *Source) {
 	size_t Size = MLArraySizes[Source->Format];
-	int FlatDegree = Source->Degree;
+	int FlatDegree = Source->Degree, Flat = 1;
 	for (int I = Source->Degree; --I >= 0;) {
-		if (Size == Source->Dimensions[I].Stride) FlatDegree = I;
+		if (!Flat || Source->Dimensions[I].Indices || Size != Source->Dimensions[I].Stride) {
+			Flat = 0;
+		} else {
+			FlatDegree = I;
+		}
 		Size *= Source->Dimensions[I].Size;
 	}
 	FlatDegree = Source->Degree - FlatDegree;
@@ -1845,6 +1961,12 @@ static int array_copy(ml_array_t *Target, ml_array_t *Source) {
 	return DataSize;
 }
 
+ml_array_t *ml_array_copy(ml_array_t *Source, ml_array_format_t Format) {
+	ml_array_t *Target = ml_array_new(Format, Source->Degree);
+	array_copy(Target, Source);
+	return Target;
+}
+
 ML_METHOD("reshape", MLArrayT, MLListT) {
 	int TargetDegree = ml_list_length(Args[1]);
 	size_t TargetCount = 1;
@@ -2201,6 +2323,868 @@ ML_METHOD("prod", MLArrayT, MLIntegerT) {
 	return (ml_value_t *)Target;
 }
 
+#define ROW_OFFSET(I) ((int64_t)(Indices ? Indices[I] : (I)) * Stride)
+
+// Contiguous rows are reduced into REDUCE_LANES independent accumulators which are combined at the end.
+// This removes the loop carried dependency on a single accumulator so the compiler can keep the lanes in one vector register.
+// Lanes start from the first value and use the same comparisons as the scalar loop, so NaN handling is unchanged.
+
+#define REDUCE_LANES 4
+
+#define REDUCE_FUNCTIONS(CTYPE) \
+\
+static CTYPE reduce_min_lanes_ ## CTYPE(size_t Size, CTYPE *Values) { \
+	CTYPE Min[REDUCE_LANES]; \
+	for (int J = 0; J < REDUCE_LANES; ++J) Min[J] = Values[0]; \
+	size_t I = 1; \
+	for (; I + REDUCE_LANES <= Size; I += REDUCE_LANES) { \
+		for (int J = 0; J < REDUCE_LANES; ++J) Min[J] = Values[I + J] < Min[J] ? Values[I + J] : Min[J]; \
+	} \
+	for (; I < Size; ++I) Min[0] = Values[I] < Min[0] ? Values[I] : Min[0]; \
+	for (int J = 1; J < REDUCE_LANES; ++J) Min[0] = Min[J] < Min[0] ? Min[J] : Min[0]; \
+	return Min[0]; \
+} \
+\
+static CTYPE reduce_max_lanes_ ## CTYPE(size_t Size, CTYPE *Values) { \
+	CTYPE Max[REDUCE_LANES]; \
+	for (int J = 0; J < REDUCE_LANES; ++J) Max[J] = Values[0]; \
+	size_t I = 1; \
+	for (; I + REDUCE_LANES <= Size; I += REDUCE_LANES) { \
+		for (int J = 0; J < REDUCE_LANES; ++J) Max[J] = Values[I + J] > Max[J] ? Values[I + J] : Max[J]; \
+	} \
+	for (; I < Size; ++I) Max[0] = Values[I] > Max[0] ? Values[I] : Max[0]; \
+	for (int J = 1; J < REDUCE_LANES; ++J) Max[0] = Max[J] > Max[0] ? Max[J] : Max[0]; \
+	return Max[0]; \
+} \
+\
+static void reduce_min_ ## CTYPE(size_t Size, int Stride, int *Indices, char *Address, char *Target) { \
+	if (!Indices && Stride == sizeof(CTYPE)) { \
+		*(CTYPE *)Target = reduce_min_lanes_ ## CTYPE(Size, (CTYPE *)Address); \
+		return; \
+	} \
+	CTYPE Min = *(CTYPE *)(Address + ROW_OFFSET(0)); \
+	for (size_t I = 1; I < Size; ++I) { \
+		CTYPE Value = *(CTYPE *)(Address + ROW_OFFSET(I)); \
+		Min = Value < Min ? Value : Min; \
+	} \
+	*(CTYPE *)Target = Min; \
+} \
+\
+static void reduce_max_ ## CTYPE(size_t Size, int Stride, int *Indices, char *Address, char *Target) { \
+	if (!Indices && Stride == sizeof(CTYPE)) { \
+		*(CTYPE *)Target = reduce_max_lanes_ ## CTYPE(Size, (CTYPE *)Address); \
+		return; \
+	} \
+	CTYPE Max = *(CTYPE *)(Address + ROW_OFFSET(0)); \
+	for (size_t I = 1; I < Size; ++I) { \
+		CTYPE Value = *(CTYPE *)(Address + ROW_OFFSET(I)); \
+		Max = Value > Max ? Value : Max; \
+	} \
+	*(CTYPE *)Target = Max; \
+} \
+\
+static void reduce_argmin_ ## CTYPE(size_t Size, int Stride, int *Indices, char *Address, char *Target) { \
+	if (!Indices && Stride == sizeof(CTYPE)) { \
+		/* Find the minimum with the lane kernel, then the first value equal to it. */ \
+		CTYPE *Values = (CTYPE *)Address; \
+		CTYPE Min = reduce_min_lanes_ ## CTYPE(Size, Values); \
+		size_t Index = 0; \
+		if (Min == Min) while (Values[Index] != Min) ++Index; \
+		*(int64_t *)Target = Index + 1; \
+		return; \
+	} \
+	CTYPE Min = *(CTYPE *)(Address + ROW_OFFSET(0)); \
+	size_t Index = 0; \
+	for (size_t I = 1; I < Size; ++I) { \
+		CTYPE Value = *(CTYPE *)(Address + ROW_OFFSET(I)); \
+		if (Value < Min) { \
+			Min = Value; \
+			Index = I; \
+		} \
+	} \
+	*(int64_t *)Target = Index + 1; \
+} \
+\
+static void reduce_argmax_ ## CTYPE(size_t Size, int Stride, int *Indices, char *Address, char *Target) { \
+	if (!Indices && Stride == sizeof(CTYPE)) { \
+		CTYPE *Values = (CTYPE *)Address; \
+		CTYPE Max = reduce_max_lanes_ ## CTYPE(Size, Values); \
+		size_t Index = 0; \
+		if (Max == Max) while (Values[Index] != Max) ++Index; \
+		*(int64_t *)Target = Index + 1; \
+		return; \
+	} \
+	CTYPE Max = *(CTYPE *)(Address + ROW_OFFSET(0)); \
+	size_t Index = 0; \
+	for (size_t I = 1; I < Size; ++I) { \
+		CTYPE Value = *(CTYPE *)(Address + ROW_OFFSET(I)); \
+		if (Value > Max) { \
+			Max = Value; \
+			Index = I; \
+		} \
+	} \
+	*(int64_t *)Target = Index + 1; \
+} \
+\
+static double reduce_sum_ ## CTYPE(size_t Size, int Stride, int *Indices, char *Address) { \
+	if (!Indices && Stride == sizeof(CTYPE)) { \
+		CTYPE *Values = (CTYPE *)Address; \
+		double Sum[REDUCE_LANES] = {0}; \
+		size_t I = 0; \
+		for (; I + REDUCE_LANES <= Size; I += REDUCE_LANES) { \
+			for (int J = 0; J < REDUCE_LANES; ++J) Sum[J] += Values[I + J]; \
+		} \
+		for (; I < Size; ++I) Sum[0] += Values[I]; \
+		return (Sum[0] + Sum[1]) + (Sum[2] + Sum[3]); \
+	} \
+	double Sum = 0; \
+	for (size_t I = 0; I < Size; ++I) Sum += *(CTYPE *)(Address + ROW_OFFSET(I)); \
+	return Sum; \
+} \
+\
+static void reduce_mean_ ## CTYPE(size_t Size, int Stride, int *Indices, char *Address, char *Target) { \
+	*(double *)Target = reduce_sum_ ## CTYPE(Size, Stride, Indices, Address) / Size; \
+} \
+\
+static void reduce_variance_ ## CTYPE(size_t Size, int Stride, int *Indices, char *Address, char *Target) { \
+	double Mean = reduce_sum_ ## CTYPE(Size, Stride, Indices, Address) / Size; \
+	if (!Indices && Stride == sizeof(CTYPE)) { \
+		CTYPE *Values = (CTYPE *)Address; \
+		double Sum[REDUCE_LANES] = {0}; \
+		size_t I = 0; \
+		for (; I + REDUCE_LANES <= Size; I += REDUCE_LANES) { \
+			for (int J = 0; J < REDUCE_LANES; ++J) { \
+				double Delta = Values[I + J] - Mean; \
+				Sum[J] += Delta * Delta; \
+			} \
+		} \
+		for (; I < Size; ++I) { \
+			double Delta = Values[I] - Mean; \
+			Sum[0] += Delta * Delta; \
+		} \
+		*(double *)Target = ((Sum[0] + Sum[1]) + (Sum[2] + Sum[3])) / Size; \
+		return; \
+	} \
+	double Sum = 0; \
+	for (size_t I = 0; I < Size; ++I) { \
+		double Delta = *(CTYPE *)(Address + ROW_OFFSET(I)) - Mean; \
+		Sum += Delta * Delta; \
+	} \
+	*(double *)Target = Sum / Size; \
+} \
+\
+/* Column kernels reduce Count consecutive rows of Inner contiguous values into Inner results, */ \
+/* so every pass reads and writes contiguous memory instead of striding down each column. */ \
+\
+static void reduce_min_cols_ ## CTYPE(size_t Count, size_t Inner, char *Address, char *Target, char *Work) { \
+	CTYPE *Values = (CTYPE *)Address, *Min = (CTYPE *)Target; \
+	memcpy(Min, Values, Inner * sizeof(CTYPE)); \
+	for (size_t I = 1; I < Count; ++I) { \
+		Values += Inner; \
+		for (size_t J = 0; J < Inner; ++J) Min[J] = Values[J] < Min[J] ? Values[J] : Min[J]; \
+	} \
+} \
+\
+static void reduce_max_cols_ ## CTYPE(size_t Count, size_t Inner, char *Address, char *Target, char *Work) { \
+	CTYPE *Values = (CTYPE *)Address, *Max = (CTYPE *)Target; \
+	memcpy(Max, Values, Inner * sizeof(CTYPE)); \
+	for (size_t I = 1; I < Count; ++I) { \
+		Values += Inner; \
+		for (size_t J = 0; J < Inner; ++J) Max[J] = Values[J] > Max[J] ? Values[J] : Max[J]; \
+	} \
+} \
+\
+static void reduce_argmin_cols_ ## CTYPE(size_t Count, size_t Inner, char *Address, char *Target, char *Work) { \
+	CTYPE *Values = (CTYPE *)Address, *Min = (CTYPE *)Work; \
+	int64_t *Index = (int64_t *)Target; \
+	memcpy(Min, Values, Inner * sizeof(CTYPE)); \
+	for (size_t J = 0; J < Inner; ++J) Index[J] = 1; \
+	for (size_t I = 1; I < Count; ++I) { \
+		Values += Inner; \
+		for (size_t J = 0; J < Inner; ++J) { \
+			int Less = Values[J] < Min[J]; \
+			Min[J] = Less ? Values[J] : Min[J]; \
+			Index[J] = Less ? I + 1 : Index[J]; \
+		} \
+	} \
+} \
+\
+static void reduce_argmax_cols_ ## CTYPE(size_t Count, size_t Inner, char *Address, char *Target, char *Work) { \
+	CTYPE *Values = (CTYPE *)Address, *Max = (CTYPE *)Work; \
+	int64_t *Index = (int64_t *)Target; \
+	memcpy(Max, Values, Inner * sizeof(CTYPE)); \
+	for (size_t J = 0; J < Inner; ++J) Index[J] = 1; \
+	for (size_t I = 1; I < Count; ++I) { \
+		Values += Inner; \
+		for (size_t J = 0; J < Inner; ++J) { \
+			int Greater = Values[J] > Max[J]; \
+			Max[J] = Greater ? Values[J] : Max[J]; \
+			Index[J] = Greater ? I + 1 : Index[J]; \
+		} \
+	} \
+} \
+\
+static void reduce_sum_cols_ ## CTYPE(size_t Count, size_t Inner, CTYPE *Values, double *Sum) { \
+	for (size_t J = 0; J < Inner; ++J) Sum[J] = 0; \
+	for (size_t I = 0; I < Count; ++I, Values += Inner) { \
+		for (size_t J = 0; J < Inner; ++J) Sum[J] += Values[J]; \
+	} \
+} \
+\
+static void reduce_mean_cols_ ## CTYPE(size_t Count, size_t Inner, char *Address, char *Target, char *Work) { \
+	double *Mean = (double *)Target; \
+	reduce_sum_cols_ ## CTYPE(Count, Inner, (CTYPE *)Address, Mean); \
+	for (size_t J = 0; J < Inner; ++J) Mean[J] /= Count; \
+} \
+\
+static void reduce_variance_cols_ ## CTYPE(size_t Count, size_t Inner, char *Address, char *Target, char *Work) { \
+	CTYPE *Values = (CTYPE *)Address; \
+	double *Mean = (double *)Work, *Sum = (double *)Target; \
+	reduce_sum_cols_ ## CTYPE(Count, Inner, Values, Mean); \
+	for (size_t J = 0; J < Inner; ++J) { \
+		Mean[J] /= Count; \
+		Sum[J] = 0; \
+	} \
+	for (size_t I = 0; I < Count; ++I, Values += Inner) { \
+		for (size_t J = 0; J < Inner; ++J) { \
+			double Delta = Values[J] - Mean[J]; \
+			Sum[J] += Delta * Delta; \
+		} \
+	} \
+	for (size_t J = 0; J < Inner; ++J) Sum[J] /= Count; \
+}
+
+REDUCE_FUNCTIONS(int8_t);
+REDUCE_FUNCTIONS(uint8_t);
+REDUCE_FUNCTIONS(int16_t);
+REDUCE_FUNCTIONS(uint16_t);
+REDUCE_FUNCTIONS(int32_t);
+REDUCE_FUNCTIONS(uint32_t);
+REDUCE_FUNCTIONS(int64_t);
+REDUCE_FUNCTIONS(uint64_t);
+REDUCE_FUNCTIONS(float);
+REDUCE_FUNCTIONS(double);
+
+typedef enum {
+	REDUCE_MIN, REDUCE_MAX,
+	REDUCE_ARGMIN, REDUCE_ARGMAX,
+	REDUCE_MEAN, REDUCE_VARIANCE
+} reduce_op_t;
+
+typedef void (*reduce_row_fn_t)(size_t Size, int Stride, int *Indices, char *Address, char *Target);
+
+#define REDUCE_ENTRIES(OP, NAME) \
+	[MAX_FORMATS * (OP) + ML_ARRAY_FORMAT_I8] = reduce_ ## NAME ## _int8_t, \
+	[MAX_FORMATS * (OP) + ML_ARRAY_FORMAT_U8] = reduce_ ## NAME ## _uint8_t, \
+	[MAX_FORMATS * (OP) + ML_ARRAY_FORMAT_I16] = reduce_ ## NAME ## _int16_t, \
+	[MAX_FORMATS * (OP) + ML_ARRAY_FORMAT_U16] = reduce_ ## NAME ## _uint16_t, \
+	[MAX_FORMATS * (OP) + ML_ARRAY_FORMAT_I32] = reduce_ ## NAME ## _int32_t, \
+	[MAX_FORMATS * (OP) + ML_ARRAY_FORMAT_U32] = reduce_ ## NAME ## _uint32_t, \
+	[MAX_FORMATS * (OP) + ML_ARRAY_FORMAT_I64] = reduce_ ## NAME ## _int64_t, \
+	[MAX_FORMATS * (OP) + ML_ARRAY_FORMAT_U64] = reduce_ ## NAME ## _uint64_t, \
+	[MAX_FORMATS * (OP) + ML_ARRAY_FORMAT_F32] = reduce_ ## NAME ## _float, \
+	[MAX_FORMATS * (OP) + ML_ARRAY_FORMAT_F64] = reduce_ ## NAME ## _double
+
+static reduce_row_fn_t ReduceRowFns[MAX_FORMATS * (REDUCE_VARIANCE + 1)] = {
+	REDUCE_ENTRIES(REDUCE_MIN, min),
+	REDUCE_ENTRIES(REDUCE_MAX, max),
+	REDUCE_ENTRIES(REDUCE_ARGMIN, argmin),
+	REDUCE_ENTRIES(REDUCE_ARGMAX, argmax),
+	REDUCE_ENTRIES(REDUCE_MEAN, mean),
+	REDUCE_ENTRIES(REDUCE_VARIANCE, variance)
+};
+
+typedef void (*reduce_cols_fn_t)(size_t Count, size_t Inner, char *Address, char *Target, char *Work);
+
+static reduce_cols_fn_t ReduceColsFns[MAX_FORMATS * (REDUCE_VARIANCE + 1)] = {
+	REDUCE_ENTRIES(REDUCE_MIN, min_cols),
+	REDUCE_ENTRIES(REDUCE_MAX, max_cols),
+	REDUCE_ENTRIES(REDUCE_ARGMIN, argmin_cols),
+	REDUCE_ENTRIES(REDUCE_ARGMAX, argmax_cols),
+	REDUCE_ENTRIES(REDUCE_MEAN, mean_cols),
+	REDUCE_ENTRIES(REDUCE_VARIANCE, variance_cols)
+};
+
+static char *reduce_axis(reduce_row_fn_t Fn, int Degree, ml_array_dimension_t *Dimension, char *Address, ml_array_dimension_t *Row, char *Target, int TargetSize) {
+	if (Degree == 0) {
+		Fn(Row->Size, Row->Stride, Row->Indices, Address, Target);
+		return Target + TargetSize;
+	}
+	int Stride = Dimension->Stride;
+	if (Dimension->Indices) {
+		int *Indices = Dimension->Indices;
+		for (int I = 0; I < Dimension->Size; ++I) {
+			Target = reduce_axis(Fn, Degree - 1, Dimension + 1, Address + Indices[I] * Stride, Row, Target, TargetSize);
+		}
+	} else {
+		for (int I = Dimension->Size; --I >= 0;) {
+			Target = reduce_axis(Fn, Degree - 1, Dimension + 1, Address, Row, Target, TargetSize);
+			Address += Stride;
+		}
+	}
+	return Target;
+}
+
+static ml_value_t *array_reduce(ml_array_t *Source, reduce_op_t Op) {
+	reduce_row_fn_t Fn = ReduceRowFns[MAX_FORMATS * Op + Source->Format];
+	if (!Fn) return ml_error("ArrayError", "Invalid array format");
+	size_t Total = array_count(Source);
+	if (!Total) return MLNil;
+	char *Address = array_is_contiguous(Source) ? Source->Base.Value : array_flatten(Source);
+	union { int64_t Index; double Real; char Value[16]; } Result;
+	Fn(Total, MLArraySizes[Source->Format], NULL, Address, (char *)&Result);
+	switch (Op) {
+	case REDUCE_MIN:
+	case REDUCE_MAX:
+		return ml_array_value(Source, Result.Value);
+	case REDUCE_ARGMIN:
+	case REDUCE_ARGMAX: {
+		ml_value_t *Indices = ml_list();
+		size_t Index = Result.Index - 1;
+		for (int I = Source->Degree; --I >= 0;) {
+			int Size = Source->Dimensions[I].Size;
+			ml_list_push(Indices, ml_integer(Index % Size + 1));
+			Index /= Size;
+		}
+		return Indices;
+	}
+	default:
+		return ml_real(Result.Real);
+	}
+}
+
+static ml_value_t *array_reduce_axis(ml_array_t *Source, reduce_op_t Op, int Index) {
+	reduce_row_fn_t Fn = ReduceRowFns[MAX_FORMATS * Op + Source->Format];
+	if (!Fn) return ml_error("ArrayError", "Invalid array format");
+	if (Index <= 0) Index += Source->Degree + 1;
+	if (Index < 1 || Index > Source->Degree) return ml_error("ArrayError", "Dimension index invalid");
+	ml_array_dimension_t *Row = Source->Dimensions + (Index - 1);
+	if (!Row->Size) return ml_error("ArrayError", "Empty dimension");
+	ml_array_format_t Format;
+	switch (Op) {
+	case REDUCE_MIN:
+	case REDUCE_MAX:
+		Format = Source->Format;
+		break;
+	case REDUCE_ARGMIN:
+	case REDUCE_ARGMAX:
+		Format = ML_ARRAY_FORMAT_I64;
+		break;
+	default:
+		Format = ML_ARRAY_FORMAT_F64;
+		break;
+	}
+	int Degree = Source->Degree - 1;
+	ml_array_t *Target = ml_array_new(Format, Degree);
+	ml_array_dimension_t Dimensions[Degree + 1];
+	for (int I = 0, J = 0; I < Source->Degree; ++I) {
+		if (I != Index - 1) Dimensions[J++] = Source->Dimensions[I];
+	}
+	int DataSize = MLArraySizes[Format];
+	for (int I = Degree; --I >= 0;) {
+		Target->Dimensions[I].Stride = DataSize;
+		int Size = Target->Dimensions[I].Size = Dimensions[I].Size;
+		DataSize *= Size;
+	}
+	Target->Base.Value = GC_MALLOC_ATOMIC(DataSize);
+	Target->Base.Length = DataSize;
+	if (Index < Source->Degree && array_is_contiguous(Source)) {
+		// Reduce whole rows of the dimensions after Index at a time instead of striding down each column.
+		size_t Outer = 1, Inner = 1;
+		for (int I = 0; I < Index - 1; ++I) Outer *= Source->Dimensions[I].Size;
+		for (int I = Index; I < Source->Degree; ++I) Inner *= Source->Dimensions[I].Size;
+		reduce_cols_fn_t ColsFn = ReduceColsFns[MAX_FORMATS * Op + Source->Format];
+		char *Work = GC_MALLOC_ATOMIC(Inner * sizeof(double));
+		size_t BlockSize = Row->Size * Inner * MLArraySizes[Source->Format];
+		size_t TargetSize = Inner * MLArraySizes[Format];
+		char *Address = Source->Base.Value, *Result = Target->Base.Value;
+		for (size_t I = 0; I < Outer; ++I, Address += BlockSize, Result += TargetSize) {
+			ColsFn(Row->Size, Inner, Address, Result, Work);
+		}
+		return (ml_value_t *)Target;
+	}
+	reduce_axis(Fn, Degree, Dimensions, Source->Base.Value, Row, Target->Base.Value, MLArraySizes[Format]);
+	return (ml_value_t *)Target;
+}
+
+ML_METHOD("min", MLArrayT) {
+//<Array
+//>number|nil
+// Returns the minimum of the values in :mini:`Array`, or :mini:`nil` if :mini:`Array` is empty.
+	return array_reduce((ml_array_t *)Args[0], REDUCE_MIN);
+}
+
+ML_METHOD("min", MLArrayT, MLIntegerT) {
+//<Array
+//<Index
+//>array
+// Returns a new array with the minimums of :mini:`Array` along the :mini:`Index`-th dimension.
+	return array_reduce_axis((ml_array_t *)Args[0], REDUCE_MIN, ml_integer_value(Args[1]));
+}
+
+ML_METHOD("max", MLArrayT) {
+//<Array
+//>number|nil
+// Returns the maximum of the values in :mini:`Array`, or :mini:`nil` if :mini:`Array` is empty.
+	return array_reduce((ml_array_t *)Args[0], REDUCE_MAX);
+}
+
+ML_METHOD("max", MLArrayT, MLIntegerT) {
+//<Array
+//<Index
+//>array
+// Returns a new array with the maximums of :mini:`Array` along the :mini:`Index`-th dimension.
+	return array_reduce_axis((ml_array_t *)Args[0], REDUCE_MAX, ml_integer_value(Args[1]));
+}
+
+ML_METHOD("argmin", MLArrayT) {
+//<Array
+//>list|nil
+// Returns the indices of the (first) minimum value in :mini:`Array`, or :mini:`nil` if :mini:`Array` is empty.
+	return array_reduce((ml_array_t *)Args[0], REDUCE_ARGMIN);
+}
+
+ML_METHOD("argmin", MLArrayT, MLIntegerT) {
+//<Array
+//<Index
+//>array
+// Returns a new array with the positions of the minimums of :mini:`Array` along the :mini:`Index`-th dimension.
+	return array_reduce_axis((ml_array_t *)Args[0], REDUCE_ARGMIN, ml_integer_value(Args[1]));
+}
+
+ML_METHOD("argmax", MLArrayT) {
+//<Array
+//>list|nil
+// Returns the indices of the (first) maximum value in :mini:`Array`, or :mini:`nil` if :mini:`Array` is empty.
+	return array_reduce((ml_array_t *)Args[0], REDUCE_ARGMAX);
+}
+
+ML_METHOD("argmax", MLArrayT, MLIntegerT) {
+//<Array
+//<Index
+//>array
+// Returns a new array with the positions of the maximums of :mini:`Array` along the :mini:`Index`-th dimension.
+	return array_reduce_axis((ml_array_t *)Args[0], REDUCE_ARGMAX, ml_integer_value(Args[1]));
+}
+
+ML_METHOD("mean", MLArrayT) {
+//<Array
+//>real|nil
+// Returns the mean of the values in :mini:`Array`, or :mini:`nil` if :mini:`Array` is empty.
+	return array_reduce((ml_array_t *)Args[0], REDUCE_MEAN);
+}
+
+ML_METHOD("mean", MLArrayT, MLIntegerT) {
+//<Array
+//<Index
+//>array
+// Returns a new array with the means of :mini:`Array` along the :mini:`Index`-th dimension.
+	return array_reduce_axis((ml_array_t *)Args[0], REDUCE_MEAN, ml_integer_value(Args[1]));
+}
+
+ML_METHOD("variance", MLArrayT) {
+//<Array
+//>real|nil
+// Returns the (population) variance of the values in :mini:`Array`, or :mini:`nil` if :mini:`Array` is empty.
+	return array_reduce((ml_array_t *)Args[0], REDUCE_VARIANCE);
+}
+
+ML_METHOD("variance", MLArrayT, MLIntegerT) {
+//<Array
+//<Index
+//>array
+// Returns a new array with the (population) variances of :mini:`Array` along the :mini:`Index`-th dimension.
+	return array_reduce_axis((ml_array_t *)Args[0], REDUCE_VARIANCE, ml_integer_value(Args[1]));
+}
+
+#define SEARCHSORTED_BODY(CTYPE, NTYPE) \
+	int Stride = Row->Stride, *Indices = Row->Indices; \
+	for (int I = 0; I < Count; ++I) { \
+		NTYPE Needle = ((NTYPE *)Needles)[I]; \
+		int Min = 0, Max = Row->Size; \
+		if ((CTYPE)-1 > (CTYPE)0 && Needle < 0) Max = 0; \
+		while (Min < Max) { \
+			int Mid = Min + (Max - Min) / 2; \
+			if (*(CTYPE *)(Address + ROW_OFFSET(Mid)) < Needle) { \
+				Min = Mid + 1; \
+			} else { \
+				Max = Mid; \
+			} \
+		} \
+		Target[I] = Min + 1; \
+	}
+
+#define SORT_FUNCTIONS(CTYPE) \
+\
+static void sort_heap_ ## CTYPE(CTYPE *Values, ptrdiff_t Count) { \
+	for (ptrdiff_t Start = Count / 2; --Start >= 0;) { \
+		for (ptrdiff_t Root = Start;;) { \
+			ptrdiff_t Child = 2 * Root + 1; \
+			if (Child >= Count) break; \
+			if (Child + 1 < Count && Values[Child] < Values[Child + 1]) ++Child; \
+			if (!(Values[Root] < Values[Child])) break; \
+			CTYPE Temp = Values[Root]; Values[Root] = Values[Child]; Values[Child] = Temp; \
+			Root = Child; \
+		} \
+	} \
+	for (ptrdiff_t End = Count; --End > 0;) { \
+		CTYPE Temp = Values[0]; Values[0] = Values[End]; Values[End] = Temp; \
+		for (ptrdiff_t Root = 0;;) { \
+			ptrdiff_t Child = 2 * Root + 1; \
+			if (Child >= End) break; \
+			if (Child + 1 < End && Values[Child] < Values[Child + 1]) ++Child; \
+			if (!(Values[Root] < Values[Child])) break; \
+			CTYPE Temp = Values[Root]; Values[Root] = Values[Child]; Values[Child] = Temp; \
+			Root = Child; \
+		} \
+	} \
+} \
+\
+static void sort_values_ ## CTYPE(CTYPE *Values, ptrdiff_t Count, int Depth) { \
+	while (Count > 16) { \
+		if (--Depth < 0) return sort_heap_ ## CTYPE(Values, Count); \
+		CTYPE *A = Values, *B = Values + Count / 2, *C = Values + Count - 1, *M; \
+		if (*A < *B) { \
+			M = (*B < *C) ? B : (*A < *C) ? C : A; \
+		} else { \
+			M = (*A < *C) ? A : (*B < *C) ? C : B; \
+		} \
+		CTYPE Pivot = *M; *M = Values[0]; Values[0] = Pivot; \
+		ptrdiff_t I = -1, J = Count; \
+		for (;;) { \
+			do ++I; while (Values[I] < Pivot); \
+			do --J; while (Pivot < Values[J]); \
+			if (I >= J) break; \
+			CTYPE Temp = Values[I]; Values[I] = Values[J]; Values[J] = Temp; \
+		} \
+		++J; \
+		if (J < Count - J) { \
+			sort_values_ ## CTYPE(Values, J, Depth); \
+			Values += J; \
+			Count -= J; \
+		} else { \
+			sort_values_ ## CTYPE(Values + J, Count - J, Depth); \
+			Count = J; \
+		} \
+	} \
+	for (ptrdiff_t I = 1; I < Count; ++I) { \
+		CTYPE Value = Values[I]; \
+		ptrdiff_t J = I; \
+		while (J > 0 && Value < Values[J - 1]) { \
+			Values[J] = Values[J - 1]; \
+			--J; \
+		} \
+		Values[J] = Value; \
+	} \
+} \
+\
+static void sort_ ## CTYPE(char *Values, size_t Count) { \
+	int Depth = 2; \
+	for (size_t N = Count; N > 1; N >>= 1) Depth += 2; \
+	sort_values_ ## CTYPE((CTYPE *)Values, Count, Depth); \
+} \
+\
+static void argsort_merge_ ## CTYPE(CTYPE *Values, int64_t *Indices, int64_t *Temp, int Count) { \
+	if (Count <= 16) { \
+		for (int I = 1; I < Count; ++I) { \
+			int64_t Index = Indices[I]; \
+			int J = I; \
+			while (J > 0 && Values[Index] < Values[Indices[J - 1]]) { \
+				Indices[J] = Indices[J - 1]; \
+				--J; \
+			} \
+			Indices[J] = Index; \
+		} \
+		return; \
+	} \
+	int Half = Count / 2; \
+	argsort_merge_ ## CTYPE(Values, Indices, Temp, Half); \
+	argsort_merge_ ## CTYPE(Values, Indices + Half, Temp, Count - Half); \
+	if (!(Values[Indices[Half]] < Values[Indices[Half - 1]])) return; \
+	memcpy(Temp, Indices, Half * sizeof(int64_t)); \
+	int64_t *P = Temp, *PLimit = Temp + Half; \
+	int64_t *Q = Indices + Half, *QLimit = Indices + Count; \
+	int64_t *Target = Indices; \
+	while (P < PLimit && Q < QLimit) { \
+		if (Values[*Q] < Values[*P]) { \
+			*Target++ = *Q++; \
+		} else { \
+			*Target++ = *P++; \
+		} \
+	} \
+	while (P < PLimit) *Target++ = *P++; \
+} \
+\
+static void argsort_ ## CTYPE(char *Values, int64_t *Indices, int64_t *Temp, int Count) { \
+	argsort_merge_ ## CTYPE((CTYPE *)Values, Indices, Temp, Count); \
+} \
+\
+static size_t unique_ ## CTYPE(char *Values, size_t Count) { \
+	CTYPE *Source = (CTYPE *)Values, *Target = Source; \
+	for (size_t I = 1; I < Count; ++I) { \
+		if (*Target < Source[I]) *++Target = Source[I]; \
+	} \
+	return (Target - Source) + 1; \
+} \
+\
+static void searchsorted_ ## CTYPE ## _int64_t(ml_array_dimension_t *Row, char *Address, int Count, char *Needles, int64_t *Target) { \
+	SEARCHSORTED_BODY(CTYPE, int64_t) \
+} \
+\
+static void searchsorted_ ## CTYPE ## _double(ml_array_dimension_t *Row, char *Address, int Count, char *Needles, int64_t *Target) { \
+	SEARCHSORTED_BODY(CTYPE, double) \
+}
+
+SORT_FUNCTIONS(int8_t);
+SORT_FUNCTIONS(uint8_t);
+SORT_FUNCTIONS(int16_t);
+SORT_FUNCTIONS(uint16_t);
+SORT_FUNCTIONS(int32_t);
+SORT_FUNCTIONS(uint32_t);
+SORT_FUNCTIONS(int64_t);
+SORT_FUNCTIONS(uint64_t);
+SORT_FUNCTIONS(float);
+SORT_FUNCTIONS(double);
+
+typedef struct {
+	void (*sort)(char *Values, size_t Count);
+	void (*argsort)(char *Values, int64_t *Indices, int64_t *Temp, int Count);
+	size_t (*unique)(char *Values, size_t Count);
+	void (*searchsorted_integer)(ml_array_dimension_t *Row, char *Address, int Count, char *Needles, int64_t *Target);
+	void (*searchsorted_real)(ml_array_dimension_t *Row, char *Address, int Count, char *Needles, int64_t *Target);
+} array_sort_fns_t;
+
+#define SORT_ENTRY(FORMAT, CTYPE) \
+	[FORMAT] = {sort_ ## CTYPE, argsort_ ## CTYPE, unique_ ## CTYPE, searchsorted_ ## CTYPE ## _int64_t, searchsorted_ ## CTYPE ## _double}
+
+static array_sort_fns_t ArraySortFns[MAX_FORMATS] = {
+	SORT_ENTRY(ML_ARRAY_FORMAT_I8, int8_t),
+	SORT_ENTRY(ML_ARRAY_FORMAT_U8, uint8_t),
+	SORT_ENTRY(ML_ARRAY_FORMAT_I16, int16_t),
+	SORT_ENTRY(ML_ARRAY_FORMAT_U16, uint16_t),
+	SORT_ENTRY(ML_ARRAY_FORMAT_I32, int32_t),
+	SORT_ENTRY(ML_ARRAY_FORMAT_U32, uint32_t),
+	SORT_ENTRY(ML_ARRAY_FORMAT_I64, int64_t),
+	SORT_ENTRY(ML_ARRAY_FORMAT_U64, uint64_t),
+	SORT_ENTRY(ML_ARRAY_FORMAT_F32, float),
+	SORT_ENTRY(ML_ARRAY_FORMAT_F64, double)
+};
+
+typedef struct {
+	array_sort_fns_t *Fns;
+	ml_array_dimension_t *Row, *TargetRow;
+	char *Buffer;
+	int64_t *Indices, *Temp;
+	int ItemSize;
+} array_sort_t;
+
+static void array_sort_row(array_sort_t *Sort, char *Address, char *Target) {
+	ml_array_dimension_t *Row = Sort->Row;
+	int Size = Row->Size, Stride = Row->Stride, *Indices = Row->Indices;
+	int ItemSize = Sort->ItemSize;
+	char *Values = Address;
+	if (Indices || Stride != ItemSize) {
+		Values = Sort->Buffer;
+		for (int I = 0; I < Size; ++I) memcpy(Values + I * ItemSize, Address + ROW_OFFSET(I), ItemSize);
+	}
+	if (Target) {
+		for (int I = 0; I < Size; ++I) Sort->Indices[I] = I;
+		Sort->Fns->argsort(Values, Sort->Indices, Sort->Temp, Size);
+		int TargetStride = Sort->TargetRow->Stride;
+		for (int I = 0; I < Size; ++I) {
+			*(int64_t *)Target = Sort->Indices[I] + 1;
+			Target += TargetStride;
+		}
+	} else {
+		Sort->Fns->sort(Values, Size);
+		if (Values != Address) {
+			for (int I = 0; I < Size; ++I) memcpy(Address + ROW_OFFSET(I), Values + I * ItemSize, ItemSize);
+		}
+	}
+}
+
+static void array_sort_rows(array_sort_t *Sort, int Degree, ml_array_dimension_t *Dimension, char *Address, ml_array_dimension_t *TargetDimension, char *Target) {
+	if (Degree == 0) return array_sort_row(Sort, Address, Target);
+	int Stride = Dimension->Stride;
+	int TargetStride = TargetDimension ? TargetDimension->Stride : 0;
+	ml_array_dimension_t *TargetNext = TargetDimension ? TargetDimension + 1 : NULL;
+	if (Dimension->Indices) {
+		int *Indices = Dimension->Indices;
+		for (int I = 0; I < Dimension->Size; ++I) {
+			array_sort_rows(Sort, Degree - 1, Dimension + 1, Address + Indices[I] * Stride, TargetNext, Target);
+			if (Target) Target += TargetStride;
+		}
+	} else {
+		for (int I = Dimension->Size; --I >= 0;) {
+			array_sort_rows(Sort, Degree - 1, Dimension + 1, Address, TargetNext, Target);
+			Address += Stride;
+			if (Target) Target += TargetStride;
+		}
+	}
+}
+
+static ml_value_t *array_sort(ml_array_t *Source, int Index, int ArgSort) {
+	array_sort_fns_t *Fns = ArraySortFns + Source->Format;
+	if (!Fns->sort) return ml_error("ArrayError", "Invalid array format");
+	if (Index <= 0) Index += Source->Degree + 1;
+	if (Index < 1 || Index > Source->Degree) return ml_error("ArrayError", "Dimension index invalid");
+	int Degree = Source->Degree - 1;
+	array_sort_t Sort[1];
+	Sort->Fns = Fns;
+	Sort->Row = Source->Dimensions + (Index - 1);
+	Sort->ItemSize = MLArraySizes[Source->Format];
+	int Size = Sort->Row->Size;
+	Sort->Buffer = GC_MALLOC_ATOMIC(Size * Sort->ItemSize);
+	ml_array_dimension_t Dimensions[Degree + 1];
+	for (int I = 0, J = 0; I < Source->Degree; ++I) {
+		if (I != Index - 1) Dimensions[J++] = Source->Dimensions[I];
+	}
+	if (!ArgSort) {
+		array_sort_rows(Sort, Degree, Dimensions, Source->Base.Value, NULL, NULL);
+		return (ml_value_t *)Source;
+	}
+	Sort->Indices = (int64_t *)GC_MALLOC_ATOMIC(Size * sizeof(int64_t));
+	Sort->Temp = (int64_t *)GC_MALLOC_ATOMIC(Size * sizeof(int64_t));
+	ml_array_t *Target = ml_array_new(ML_ARRAY_FORMAT_I64, Source->Degree);
+	int DataSize = sizeof(int64_t);
+	for (int I = Source->Degree; --I >= 0;) {
+		Target->Dimensions[I].Stride = DataSize;
+		DataSize *= (Target->Dimensions[I].Size = Source->Dimensions[I].Size);
+	}
+	Target->Base.Value = GC_MALLOC_ATOMIC(DataSize);
+	Target->Base.Length = DataSize;
+	ml_array_dimension_t TargetDimensions[Degree + 1];
+	for (int I = 0, J = 0; I < Target->Degree; ++I) {
+		if (I != Index - 1) TargetDimensions[J++] = Target->Dimensions[I];
+	}
+	Sort->TargetRow = Target->Dimensions + (Index - 1);
+	array_sort_rows(Sort, Degree, Dimensions, Source->Base.Value, TargetDimensions, Target->Base.Value);
+	return (ml_value_t *)Target;
+}
+
+ML_METHOD("sort", MLArrayT) {
+//<Array
+//>array
+// Sorts the values in :mini:`Array` along its last dimension in place and returns :mini:`Array`.
+	return array_sort((ml_array_t *)Args[0], -1, 0);
+}
+
+ML_METHOD("sort", MLArrayT, MLIntegerT) {
+//<Array
+//<Index
+//>array
+// Sorts the values in :mini:`Array` along its :mini:`Index`-th dimension in place and returns :mini:`Array`.
+	return array_sort((ml_array_t *)Args[0], ml_integer_value(Args[1]), 0);
+}
+
+ML_METHOD("sorted", MLArrayT) {
+//<Array
+//>array
+// Returns a copy of :mini:`Array` sorted along its last dimension.
+	ml_array_t *Source = (ml_array_t *)Args[0];
+	ml_array_t *Target = ml_array_new(Source->Format, Source->Degree);
+	array_copy(Target, Source);
+	return array_sort(Target, -1, 0);
+}
+
+ML_METHOD("sorted", MLArrayT, MLIntegerT) {
+//<Array
+//<Index
+//>array
+// Returns a copy of :mini:`Array` sorted along its :mini:`Index`-th dimension.
+	ml_array_t *Source = (ml_array_t *)Args[0];
+	ml_array_t *Target = ml_array_new(Source->Format, Source->Degree);
+	array_copy(Target, Source);
+	return array_sort(Target, ml_integer_value(Args[1]), 0);
+}
+
+ML_METHOD("argsort", MLArrayT) {
+//<Array
+//>array
+// Returns an array of indices that would (stably) sort :mini:`Array` along its last dimension.
+	return array_sort((ml_array_t *)Args[0], -1, 1);
+}
+
+ML_METHOD("argsort", MLArrayT, MLIntegerT) {
+//<Array
+//<Index
+//>array
+// Returns an array of indices that would (stably) sort :mini:`Array` along its :mini:`Index`-th dimension.
+	return array_sort((ml_array_t *)Args[0], ml_integer_value(Args[1]), 1);
+}
+
+ML_METHOD("unique", MLArrayT) {
+//<Array
+//>array
+// Returns a one dimensional array with the sorted distinct values in :mini:`Array`.
+	ml_array_t *Source = (ml_array_t *)Args[0];
+	array_sort_fns_t *Fns = ArraySortFns + Source->Format;
+	if (!Fns->sort) return ml_error("ArrayError", "Invalid array format");
+	size_t Size = array_count(Source);
+	char *Values = array_flatten(Source);
+	if (Size) {
+		Fns->sort(Values, Size);
+		Size = Fns->unique(Values, Size);
+	}
+	if (Size > INT_MAX) return ml_error("ShapeError", "Too many distinct values");
+	ml_array_t *Target = ml_array_new(Source->Format, 1);
+	Target->Dimensions[0].Size = Size;
+	Target->Dimensions[0].Stride = MLArraySizes[Source->Format];
+	Target->Base.Value = Values;
+	Target->Base.Length = Size * MLArraySizes[Source->Format];
+	return (ml_value_t *)Target;
+}
+
+static ml_value_t *array_searchsorted(ml_array_t *Source, ml_array_t *Needles) {
+	if (Source->Degree != 1) return ml_error("ArrayError", "Sorted array must have degree 1");
+	array_sort_fns_t *Fns = ArraySortFns + Source->Format;
+	if (!Fns->sort) return ml_error("ArrayError", "Invalid array format");
+	if (!ArraySortFns[Needles->Format].sort) return ml_error("ArrayError", "Invalid array format");
+	int Real = Needles->Format >= ML_ARRAY_FORMAT_F32;
+	ml_array_t *Keys = ml_array_new(Real ? ML_ARRAY_FORMAT_F64 : ML_ARRAY_FORMAT_I64, Needles->Degree);
+	array_copy(Keys, Needles);
+	ml_array_t *Target = ml_array_new(ML_ARRAY_FORMAT_I64, Needles->Degree);
+	array_copy(Target, Needles);
+	if (Real) {
+		Fns->searchsorted_real(Source->Dimensions, Source->Base.Value, array_count(Keys), Keys->Base.Value, (int64_t *)Target->Base.Value);
+	} else {
+		Fns->searchsorted_integer(Source->Dimensions, Source->Base.Value, array_count(Keys), Keys->Base.Value, (int64_t *)Target->Base.Value);
+	}
+	return (ml_value_t *)Target;
+}
+
+ML_METHOD("searchsorted", MLArrayT, MLArrayT) {
+//<Array
+//<Values
+//>array
+// Returns an array with the indices where each value in :mini:`Values` would be inserted into the sorted array :mini:`Array` to maintain its order.
+	return array_searchsorted((ml_array_t *)Args[0], (ml_array_t *)Args[1]);
+}
+
+ML_METHOD("searchsorted", MLArrayT, MLIntegerT) {
+//<Array
+//<Value
+//>integer
+// Returns the index where :mini:`Value` would be inserted into the sorted array :mini:`Array` to maintain its order.
+	ml_array_t *Needle = ml_array(ML_ARRAY_FORMAT_I64, 1, 1);
+	*(int64_t *)Needle->Base.Value = ml_integer_value_fast(Args[1]);
+	ml_array_t *Target = (ml_array_t *)array_searchsorted((ml_array_t *)Args[0], Needle);
+	if (ml_is_error((ml_value_t *)Target)) return (ml_value_t *)Target;
+	return ml_integer(*(int64_t *)Target->Base.Value);
+}
+
+ML_METHOD("searchsorted", MLArrayT, MLRealT) {
+//<Array
+//<Value
+//>integer
+// Returns the index where :mini:`Value` would be inserted into the sorted array :mini:`Array` to maintain its order.
+	ml_array_t *Needle = ml_array(ML_ARRAY_FORMAT_F64, 1, 1);
+	*(double *)Needle->Base.Value = ml_real_value(Args[1]);
+	ml_array_t *Target = (ml_array_t *)array_searchsorted((ml_array_t *)Args[0], Needle);
+	if (ml_is_error((ml_value_t *)Target)) return (ml_value_t *)Target;
+	return ml_integer(*(int64_t *)Target->Base.Value);
+}
+
 ML_METHOD("-", MLArrayT) {
 //<Array
 //>array
@@ -2280,39 +3264,104 @@ ML_METHOD("-", MLArrayT) {
 	return (ml_value_t *)C;
 }
 
-static ml_value_t *array_math_fn(double (*fn)(double), int Count, ml_value_t **Args) {
+// The kernels avoid boxing and the indirect call per element but still call libm once per element,
+// only functions the compiler expands inline (such as fabs, floor or ceil) can be vectorized.
+
+typedef struct {
+	void (*Float)(size_t Count, float *Values);
+	void (*Double)(size_t Count, double *Values);
+} array_math_t;
+
+#define ARRAY_MATH(NAME, CNAME_FLOAT, CNAME_DOUBLE) \
+\
+static void array_math_ ## NAME ## _float(size_t Count, float *Values) { \
+	for (size_t I = 0; I < Count; ++I) Values[I] = CNAME_FLOAT(Values[I]); \
+} \
+\
+static void array_math_ ## NAME ## _double(size_t Count, double *Values) { \
+	for (size_t I = 0; I < Count; ++I) Values[I] = CNAME_DOUBLE(Values[I]); \
+} \
+\
+static array_math_t ArrayMath ## NAME[1] = {{array_math_ ## NAME ## _float, array_math_ ## NAME ## _double}}
+
+ARRAY_MATH(Acos, acosf, acos);
+ARRAY_MATH(Asin, asinf, asin);
+ARRAY_MATH(Atan, atanf, atan);
+ARRAY_MATH(Ceil, ceilf, ceil);
+ARRAY_MATH(Cos, cosf, cos);
+ARRAY_MATH(Cosh, coshf, cosh);
+ARRAY_MATH(Exp, expf, exp);
+ARRAY_MATH(Abs, fabsf, fabs);
+ARRAY_MATH(Floor, floorf, floor);
+ARRAY_MATH(Log, logf, log);
+ARRAY_MATH(Log10, log10f, log10);
+ARRAY_MATH(Sin, sinf, sin);
+ARRAY_MATH(Sinh, sinhf, sinh);
+ARRAY_MATH(Sqrt, sqrtf, sqrt);
+ARRAY_MATH(Tan, tanf, tan);
+ARRAY_MATH(Tanh, tanhf, tanh);
+ARRAY_MATH(Erf, erff, erf);
+ARRAY_MATH(Erfc, erfcf, erfc);
+ARRAY_MATH(Gamma, gammaf, gamma);
+ARRAY_MATH(Acosh, acoshf, acosh);
+ARRAY_MATH(Asinh, asinhf, asinh);
+ARRAY_MATH(Atanh, atanhf, atanh);
+ARRAY_MATH(Cbrt, cbrtf, cbrt);
+ARRAY_MATH(Expm1, expm1f, expm1);
+ARRAY_MATH(Log1p, log1pf, log1p);
+ARRAY_MATH(Round, roundf, round);
+
+static void array_math_apply(array_math_t *Math, ml_array_t *Array) {
+	// Array must be contiguous with format F32 or F64.
+	if (Array->Format == ML_ARRAY_FORMAT_F32) {
+		Math->Float(array_count(Array), (float *)Array->Base.Value);
+	} else {
+		Math->Double(array_count(Array), (double *)Array->Base.Value);
+	}
+}
+
+static ml_value_t *array_math_fn(void *Data, int Count, ml_value_t **Args) {
+	array_math_t *Math = (array_math_t *)Data;
 	ml_array_t *A = (ml_array_t *)Args[0];
 	if (A->Format == ML_ARRAY_FORMAT_ANY) return ml_error("TypeError", "Invalid types for array operation");
-	int Degree = A->Degree;
-	ml_array_t *C = ml_array_new(ML_ARRAY_FORMAT_F64, Degree);
-	int DataSize = array_copy(C, A);
-	switch (C->Format) {
-	case ML_ARRAY_FORMAT_F32: {
-		float *Values = (float *)C->Base.Value;
-		for (int I = DataSize / sizeof(float); --I >= 0; ++Values) *Values = fn(*Values);
-		break;
-	}
-	case ML_ARRAY_FORMAT_F64: {
-		double *Values = (double *)C->Base.Value;
-		for (int I = DataSize / sizeof(double); --I >= 0; ++Values) *Values = fn(*Values);
-		break;
-	}
-#ifdef ML_COMPLEX
-	case ML_ARRAY_FORMAT_C32: {
-		complex_float *Values = (complex_float *)C->Base.Value;
-		for (int I = DataSize / sizeof(complex_float); --I >= 0; ++Values) *Values = fn(*Values);
-		break;
-	}
-	case ML_ARRAY_FORMAT_C64: {
-		complex_double *Values = (complex_double *)C->Base.Value;
-		for (int I = DataSize / sizeof(complex_double); --I >= 0; ++Values) *Values = fn(*Values);
-		break;
-	}
-#endif
-	default: {
-		return ml_error("TypeError", "Invalid types for array operation");
-	}
+	if (Count > 1) {
+		ml_array_t *B = (ml_array_t *)Args[1];
+		if (B->Format != ML_ARRAY_FORMAT_F32 && B->Format != ML_ARRAY_FORMAT_F64) {
+			return ml_error("TypeError", "Target array must have format float32 or float64");
+		}
+		if (B->Degree != A->Degree) return ml_error("ShapeError", "Incompatible arrays");
+		for (int I = 0; I < A->Degree; ++I) {
+			if (A->Dimensions[I].Size != B->Dimensions[I].Size) return ml_error("ShapeError", "Incompatible arrays");
+		}
+		ml_array_t *C = B;
+		if (!array_is_contiguous(B)) {
+			C = ml_array_new(B->Format, B->Degree);
+			array_copy(C, A);
+		} else if (B != A) {
+			int Op = B->Format * MAX_FORMATS + A->Format;
+			if (A->Degree) {
+				update_array(Op, B->Dimensions, B->Base.Value, A->Degree, A->Dimensions, A->Base.Value);
+			} else {
+				ml_array_dimension_t ValueDimension[1] = {{1, 0, NULL}};
+				UpdateRowFns[Op](ValueDimension, B->Base.Value, ValueDimension, A->Base.Value);
+			}
+		}
+		array_math_apply(Math, C);
+		if (C != B) {
+			int Op = B->Format * MAX_FORMATS + C->Format;
+			if (B->Degree) {
+				update_array(Op, B->Dimensions, B->Base.Value, C->Degree, C->Dimensions, C->Base.Value);
+			} else {
+				ml_array_dimension_t ValueDimension[1] = {{1, 0, NULL}};
+				UpdateRowFns[Op](ValueDimension, B->Base.Value, ValueDimension, C->Base.Value);
+			}
+		}
+		return (ml_value_t *)B;
 	}
+	ml_array_format_t Format = A->Format == ML_ARRAY_FORMAT_F32 ? ML_ARRAY_FORMAT_F32 : ML_ARRAY_FORMAT_F64;
+	ml_array_t *C = ml_array_new(Format, A->Degree);
+	array_copy(C, A);
+	array_math_apply(Math, C);
 	return (ml_value_t *)C;
 }
 
@@ -3842,32 +4891,58 @@ void ml_array_init(stringmap_t *Globals) {
 	ml_method_by_name("--", ml_array_sub_fill, ml_array_pairwise_infix, MLArrayT, MLArrayT, NULL);
 	ml_method_by_name("//", ml_array_div_fill, ml_array_pairwise_infix, MLArrayT, MLArrayT, NULL);
 
-	ml_method_by_value(AcosMethod, acos, (ml_callback_t)array_math_fn, MLArrayT, NULL);
-	ml_method_by_value(AsinMethod, asin, (ml_callback_t)array_math_fn, MLArrayT, NULL);
-	ml_method_by_value(AtanMethod, atan, (ml_callback_t)array_math_fn, MLArrayT, NULL);
-	ml_method_by_value(CeilMethod, ceil, (ml_callback_t)array_math_fn, MLArrayT, NULL);
-	ml_method_by_value(CosMethod, cos, (ml_callback_t)array_math_fn, MLArrayT, NULL);
-	ml_method_by_value(CoshMethod, cosh, (ml_callback_t)array_math_fn, MLArrayT, NULL);
-	ml_method_by_value(ExpMethod, exp, (ml_callback_t)array_math_fn, MLArrayT, NULL);
-	ml_method_by_value(AbsMethod, abs, (ml_callback_t)array_math_fn, MLArrayT, NULL);
-	ml_method_by_value(FloorMethod, floor, (ml_callback_t)array_math_fn, MLArrayT, NULL);
-	ml_method_by_value(LogMethod, log, (ml_callback_t)array_math_fn, MLArrayT, NULL);
-	ml_method_by_value(Log10Method, log10, (ml_callback_t)array_math_fn, MLArrayT, NULL);
-	ml_method_by_value(SinMethod, sin, (ml_callback_t)array_math_fn, MLArrayT, NULL);
-	ml_method_by_value(SinhMethod, sinh, (ml_callback_t)array_math_fn, MLArrayT, NULL);
-	ml_method_by_value(SqrtMethod, sqrt, (ml_callback_t)array_math_fn, MLArrayT, NULL);
-	ml_method_by_value(TanMethod, tan, (ml_callback_t)array_math_fn, MLArrayT, NULL);
-	ml_method_by_value(TanhMethod, tanh, (ml_callback_t)array_math_fn, MLArrayT, NULL);
-	ml_method_by_value(ErfMethod, erf, (ml_callback_t)array_math_fn, MLArrayT, NULL);
-	ml_method_by_value(ErfcMethod, erfc, (ml_callback_t)array_math_fn, MLArrayT, NULL);
-	ml_method_by_value(GammaMethod, gamma, (ml_callback_t)array_math_fn, MLArrayT, NULL);
-	ml_method_by_value(AcoshMethod, acosh, (ml_callback_t)array_math_fn, MLArrayT, NULL);
-	ml_method_by_value(AsinhMethod, asinh, (ml_callback_t)array_math_fn, MLArrayT, NULL);
-	ml_method_by_value(AtanhMethod, atanh, (ml_callback_t)array_math_fn, MLArrayT, NULL);
-	ml_method_by_value(CbrtMethod, cbrt, (ml_callback_t)array_math_fn, MLArrayT, NULL);
-	ml_method_by_value(Expm1Method, expm1, (ml_callback_t)array_math_fn, MLArrayT, NULL);
-	ml_method_by_value(Log1pMethod, log1p, (ml_callback_t)array_math_fn, MLArrayT, NULL);
-	ml_method_by_value(RoundMethod, round, (ml_callback_t)array_math_fn, MLArrayT, NULL);
+	ml_method_by_value(AcosMethod, ArrayMathAcos, array_math_fn, MLArrayT, NULL);
+	ml_method_by_value(AcosMethod, ArrayMathAcos, array_math_fn, MLArrayT, MLArrayT, NULL);
+	ml_method_by_value(AsinMethod, ArrayMathAsin, array_math_fn, MLArrayT, NULL);
+	ml_method_by_value(AsinMethod, ArrayMathAsin, array_math_fn, MLArrayT, MLArrayT, NULL);
+	ml_method_by_value(AtanMethod, ArrayMathAtan, array_math_fn, MLArrayT, NULL);
+	ml_method_by_value(AtanMethod, ArrayMathAtan, array_math_fn, MLArrayT, MLArrayT, NULL);
+	ml_method_by_value(CeilMethod, ArrayMathCeil, array_math_fn, MLArrayT, NULL);
+	ml_method_by_value(CeilMethod, ArrayMathCeil, array_math_fn, MLArrayT, MLArrayT, NULL);
+	ml_method_by_value(CosMethod, ArrayMathCos, array_math_fn, MLArrayT, NULL);
+	ml_method_by_value(CosMethod, ArrayMathCos, array_math_fn, MLArrayT, MLArrayT, NULL);
+	ml_method_by_value(CoshMethod, ArrayMathCosh, array_math_fn, MLArrayT, NULL);
+	ml_method_by_value(CoshMethod, ArrayMathCosh, array_math_fn, MLArrayT, MLArrayT, NULL);
+	ml_method_by_value(ExpMethod, ArrayMathExp, array_math_fn, MLArrayT, NULL);
+	ml_method_by_value(ExpMethod, ArrayMathExp, array_math_fn, MLArrayT, MLArrayT, NULL);
+	ml_method_by_value(AbsMethod, ArrayMathAbs, array_math_fn, MLArrayT, NULL);
+	ml_method_by_value(AbsMethod, ArrayMathAbs, array_math_fn, MLArrayT, MLArrayT, NULL);
+	ml_method_by_value(FloorMethod, ArrayMathFloor, array_math_fn, MLArrayT, NULL);
+	ml_method_by_value(FloorMethod, ArrayMathFloor, array_math_fn, MLArrayT, MLArrayT, NULL);
+	ml_method_by_value(LogMethod, ArrayMathLog, array_math_fn, MLArrayT, NULL);
+	ml_method_by_value(LogMethod, ArrayMathLog, array_math_fn, MLArrayT, MLArrayT, NULL);
+	ml_method_by_value(Log10Method, ArrayMathLog10, array_math_fn, MLArrayT, NULL);
+	ml_method_by_value(Log10Method, ArrayMathLog10, array_math_fn, MLArrayT, MLArrayT, NULL);
+	ml_method_by_value(SinMethod, ArrayMathSin, array_math_fn, MLArrayT, NULL);
+	ml_method_by_value(SinMethod, ArrayMathSin, array_math_fn, MLArrayT, MLArrayT, NULL);
+	ml_method_by_value(SinhMethod, ArrayMathSinh, array_math_fn, MLArrayT, NULL);
+	ml_method_by_value(SinhMethod, ArrayMathSinh, array_math_fn, MLArrayT, MLArrayT, NULL);
+	ml_method_by_value(SqrtMethod, ArrayMathSqrt, array_math_fn, MLArrayT, NULL);
+	ml_method_by_value(SqrtMethod, ArrayMathSqrt, array_math_fn, MLArrayT, MLArrayT, NULL);
+	ml_method_by_value(TanMethod, ArrayMathTan, array_math_fn, MLArrayT, NULL);
+	ml_method_by_value(TanMethod, ArrayMathTan, array_math_fn, MLArrayT, MLArrayT, NULL);
+	ml_method_by_value(TanhMethod, ArrayMathTanh, array_math_fn, MLArrayT, NULL);
+	ml_method_by_value(TanhMethod, ArrayMathTanh, array_math_fn, MLArrayT, MLArrayT, NULL);
+	ml_method_by_value(ErfMethod, ArrayMathErf, array_math_fn, MLArrayT, NULL);
+	ml_method_by_value(ErfMethod, ArrayMathErf, array_math_fn, MLArrayT, MLArrayT, NULL);
+	ml_method_by_value(ErfcMethod, ArrayMathErfc, array_math_fn, MLArrayT, NULL);
+	ml_method_by_value(ErfcMethod, ArrayMathErfc, array_math_fn, MLArrayT, MLArrayT, NULL);
+	ml_method_by_value(GammaMethod, ArrayMathGamma, array_math_fn, MLArrayT, NULL);
+	ml_method_by_value(GammaMethod, ArrayMathGamma, array_math_fn, MLArrayT, MLArrayT, NULL);
+	ml_method_by_value(AcoshMethod, ArrayMathAcosh, array_math_fn, MLArrayT, NULL);
+	ml_method_by_value(AcoshMethod, ArrayMathAcosh, array_math_fn, MLArrayT, MLArrayT, NULL);
+	ml_method_by_value(AsinhMethod, ArrayMathAsinh, array_math_fn, MLArrayT, NULL);
+	ml_method_by_value(AsinhMethod, ArrayMathAsinh, array_math_fn, MLArrayT, MLArrayT, NULL);
+	ml_method_by_value(AtanhMethod, ArrayMathAtanh, array_math_fn, MLArrayT, NULL);
+	ml_method_by_value(AtanhMethod, ArrayMathAtanh, array_math_fn, MLArrayT, MLArrayT, NULL);
+	ml_method_by_value(CbrtMethod, ArrayMathCbrt, array_math_fn, MLArrayT, NULL);
+	ml_method_by_value(CbrtMethod, ArrayMathCbrt, array_math_fn, MLArrayT, MLArrayT, NULL);
+	ml_method_by_value(Expm1Method, ArrayMathExpm1, array_math_fn, MLArrayT, NULL);
+	ml_method_by_value(Expm1Method, ArrayMathExpm1, array_math_fn, MLArrayT, MLArrayT, NULL);
+	ml_method_by_value(Log1pMethod, ArrayMathLog1p, array_math_fn, MLArrayT, NULL);
+	ml_method_by_value(Log1pMethod, ArrayMathLog1p, array_math_fn, MLArrayT, MLArrayT, NULL);
+	ml_method_by_value(RoundMethod, ArrayMathRound, array_math_fn, MLArrayT, NULL);
+	ml_method_by_value(RoundMethod, ArrayMathRound, array_math_fn, MLArrayT, MLArrayT, NULL);
 
 	ml_method_define(ml_method("$"), MLArrayT->Constructor, 0, MLListT, NULL);
 	stringmap_insert(MLArrayT->Exports, "new", ml_cfunctionx(NULL, ml_array_new_fnx));
@@ -43,6 +43,7 @@ ml_array_t *ml_array(ml_array_format_t Format, int Degree, ...);
 int ml_array_degree(ml_value_t *Array);
 int ml_array_size(ml_value_t *Array, int Dim);
 ml_value_t *ml_array_index(ml_array_t *Array, int Count, ml_value_t **Indices);
+ml_array_t *ml_array_copy(ml_array_t *Source, ml_array_format_t Format);
 
 #define ML_ARRAY_ACCESSORS(CTYPE) \
 CTYPE ml_array_get_ ## CTYPE (ml_array_t *Array, ...); \
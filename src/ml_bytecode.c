@@ -174,6 +174,13 @@ static void ML_TYPED_FN(ml_iter_next, DEBUG_TYPE(Continuation), ml_state_t *Call
 	ML_CONTINUE(Suspension, MLNil);
 }
 
+static int ML_TYPED_FN(ml_iter_pair, DEBUG_TYPE(Continuation), DEBUG_STRUCT(frame) *Suspension, ml_value_t **Key, ml_value_t **Value) {
+	if (!Suspension->Suspend) return 0;
+	if (Key) *Key = Suspension->Top[-2];
+	if (Value) *Value = Suspension->Top[-1];
+	return 1;
+}
+
 static void ML_TYPED_FN(ml_iterate, DEBUG_TYPE(Continuation), ml_state_t *Caller, DEBUG_STRUCT(frame) *Suspension) {
 	if (!Suspension->Suspend) ML_ERROR("StateError", "Function did not suspend");
 	ML_RETURN(Suspension);
@@ -182,20 +189,25 @@ static void ML_TYPED_FN(ml_iterate, DEBUG_TYPE(Continuation), ml_state_t *Caller
 #ifndef DEBUG_VERSION
 
 #ifdef ML_SCHEDULER
-#define CHECK_COUNTER if (__builtin_expect(--Counter == 0, 0)) goto DO_SWAP;
+// The scheduler counter is only checked at calls and jumps, it may also be set to 1 asynchronously by a preemption timer.
+// Relaxed loads and stores keep this a plain decrement, a tick that lands between them is only delayed until the next one.
+#define CHECK_COUNTER { \
+	unsigned int *Counter = Frame->Schedule.Counter; \
+	unsigned int Remaining = __atomic_load_n(Counter, __ATOMIC_RELAXED) - 1; \
+	__atomic_store_n(Counter, Remaining, __ATOMIC_RELAXED); \
+	if (__builtin_expect(Remaining == 0, 0)) goto DO_SWAP; \
+}
 #else
 #define CHECK_COUNTER
 #endif
 
 #define ERROR() { \
 	Inst = Frame->OnError; \
-	CHECK_COUNTER \
 	goto *Labels[Inst->Opcode]; \
 }
 
 #define ADVANCE(NEXT) { \
 	Inst = NEXT; \
-	CHECK_COUNTER \
 	goto *Labels[Inst->Opcode]; \
 }
 
@@ -212,13 +224,11 @@ static void ML_TYPED_FN(ml_iterate, DEBUG_TYPE(Continuation), ml_state_t *Caller
 
 #define ERROR() { \
 	Inst = Frame->OnError; \
-	CHECK_COUNTER \
 	goto DO_DEBUG_ERROR; \
 }
 
 #define ADVANCE(NEXT) { \
 	Inst = NEXT; \
-	CHECK_COUNTER \
 	goto DO_DEBUG_ADVANCE; \
 }
 
@@ -226,21 +236,37 @@ static void ML_TYPED_FN(ml_iterate, DEBUG_TYPE(Continuation), ml_state_t *Caller
 
 #ifndef DEBUG_VERSION
 
-static ml_frame_t *MLCachedFrame = NULL;
-
 #ifdef ML_THREADSAFE
 
-#include <stdatomic.h>
+// Each thread keeps its own cache of frames so that calls never contend on a shared lock.
+// The head of each list is kept in an uncollectable cell since thread local storage is not scanned reliably,
+// the cell is freed by a thread specific key destructor when its thread exits so that the cached frames can be collected.
 
-static volatile atomic_flag MLCachedFrameLock[1] = {ATOMIC_FLAG_INIT};
+static __thread ml_frame_t **MLCachedFrames = NULL;
+static pthread_key_t MLCachedFramesKey;
+static pthread_once_t MLCachedFramesOnce = PTHREAD_ONCE_INIT;
+
+static void ml_cached_frames_free(void *Cell) {
+	MLCachedFrames = NULL;
+	GC_free(Cell);
+}
+
+static void ml_cached_frames_key() {
+	pthread_key_create(&MLCachedFramesKey, ml_cached_frames_free);
+}
+
+static ml_frame_t **ml_cached_frames_new() {
+	pthread_once(&MLCachedFramesOnce, ml_cached_frames_key);
+	MLCachedFrames = GC_MALLOC_UNCOLLECTABLE(sizeof(ml_frame_t *));
+	pthread_setspecific(MLCachedFramesKey, MLCachedFrames);
+	return MLCachedFrames;
+}
 
-#define ML_CACHED_FRAME_LOCK() while (atomic_flag_test_and_set(MLCachedFrameLock))
-#define ML_CACHED_FRAME_UNLOCK() atomic_flag_clear(MLCachedFrameLock)
+#define MLCachedFrame (*(MLCachedFrames ?: ml_cached_frames_new()))
 
 #else
 
-#define ML_CACHED_FRAME_LOCK() {}
-#define ML_CACHED_FRAME_UNLOCK() {}
+static ml_frame_t *MLCachedFrame = NULL;
 
 #endif
 
@@ -324,9 +350,6 @@ static void DEBUG_FUNC(frame_run)(DEBUG_STRUCT(frame) *Frame, ml_value_t *Result
 		ml_error_trace_add(Error, (ml_source_t){Frame->Source, Frame->Inst->Line});
 		ML_CONTINUE(Frame->Base.Caller, Error);
 	}
-#ifdef ML_SCHEDULER
-	uint64_t Counter = Frame->Schedule.Counter[0];
-#endif
 	ml_inst_t *Inst = Frame->Inst;
 	ml_value_t **Top = Frame->Top;
 #ifdef DEBUG_VERSION
@@ -351,18 +374,13 @@ static void DEBUG_FUNC(frame_run)(DEBUG_STRUCT(frame) *Frame, ml_value_t *Result
 		goto *Labels[Inst->Opcode];
 	}
 	DO_RETURN: {
-#ifdef ML_SCHEDULER
-		Frame->Schedule.Counter[0] = Counter;
-#endif
 		ml_state_t *Caller = Frame->Base.Caller;
 		if (!Frame->Continue) {
 			//memset(Frame, 0, ML_FRAME_REUSE_SIZE);
 			//while (Top > Frame->Stack) *--Top = NULL;
 			memset(Frame->Stack, 0, (Top - Frame->Stack) * sizeof(ml_value_t *));
-			ML_CACHED_FRAME_LOCK();
 			Frame->Next = MLCachedFrame;
 			MLCachedFrame = (ml_frame_t *)Frame;
-			ML_CACHED_FRAME_UNLOCK();
 		} else {
 			Frame->Line = Inst->Line;
 			Frame->Inst = Inst;
@@ -373,9 +391,6 @@ static void DEBUG_FUNC(frame_run)(DEBUG_STRUCT(frame) *Frame, ml_value_t *Result
 		Frame->Line = Inst->Line;
 		Frame->Inst = Inst + 1;
 		Frame->Top = Top;
-#ifdef ML_SCHEDULER
-		Frame->Schedule.Counter[0] = Counter;
-#endif
 		Frame->Suspend = 1;
 		ML_CONTINUE(Frame->Base.Caller, (ml_value_t *)Frame);
 	}
@@ -469,6 +484,7 @@ static void DEBUG_FUNC(frame_run)(DEBUG_STRUCT(frame) *Frame, ml_value_t *Result
 		ADVANCE(Inst + 3);
 	}
 	DO_GOTO: {
+		CHECK_COUNTER
 		ADVANCE(Inst[1].Inst);
 	}
 	DO_TRY: {
@@ -506,6 +522,7 @@ static void DEBUG_FUNC(frame_run)(DEBUG_STRUCT(frame) *Frame, ml_value_t *Result
 		ADVANCE(Inst + 3);
 	}
 	DO_RETRY: {
+		CHECK_COUNTER
 		ERROR();
 	}
 	DO_LOAD: {
@@ -607,9 +624,6 @@ static void DEBUG_FUNC(frame_run)(DEBUG_STRUCT(frame) *Frame, ml_value_t *Result
 		Frame->Line = Inst->Line;
 		Frame->Inst = Inst + 1;
 		Frame->Top = Top;
-#ifdef ML_SCHEDULER
-		Frame->Schedule.Counter[0] = Counter;
-#endif
 		return ml_iterate((ml_state_t *)Frame, Result);
 	}
 	DO_ITER: {
@@ -626,32 +640,43 @@ static void DEBUG_FUNC(frame_run)(DEBUG_STRUCT(frame) *Frame, ml_value_t *Result
 		Frame->Line = Inst->Line;
 		Frame->Inst = Inst[1].Inst;
 		Frame->Top = Top;
-#ifdef ML_SCHEDULER
-		Frame->Schedule.Counter[0] = Counter;
-#endif
+		if (ml_typeof(Result) == DEBUG_TYPE(Continuation)) {
+			// Resume suspended generators directly, skipping the typed function lookup.
+			DEBUG_STRUCT(frame) *Suspension = (DEBUG_STRUCT(frame) *)Result;
+			if (!Suspension->Suspend) {
+				Result = MLNil;
+				ADVANCE(Inst[1].Inst);
+			}
+			Suspension->Base.Caller = (ml_state_t *)Frame;
+			Suspension->Base.Context = Frame->Base.Context;
+			return Suspension->Base.run((ml_state_t *)Suspension, MLNil);
+		}
 		return ml_iter_next((ml_state_t *)Frame, Result);
 	}
 	DO_VALUE: {
 		Result = Top[Inst[1].Index];
+		if (ml_typeof(Result) == DEBUG_TYPE(Continuation) && ((DEBUG_STRUCT(frame) *)Result)->Suspend) {
+			Result = ((DEBUG_STRUCT(frame) *)Result)->Top[-1];
+			ADVANCE(Inst + 2);
+		}
 		Frame->Line = Inst->Line;
 		Frame->Inst = Inst + 2;
 		Frame->Top = Top;
-#ifdef ML_SCHEDULER
-		Frame->Schedule.Counter[0] = Counter;
-#endif
 		return ml_iter_value((ml_state_t *)Frame, Result);
 	}
 	DO_KEY: {
 		Result = Top[Inst[1].Index];
+		if (ml_typeof(Result) == DEBUG_TYPE(Continuation) && ((DEBUG_STRUCT(frame) *)Result)->Suspend) {
+			Result = ((DEBUG_STRUCT(frame) *)Result)->Top[-2];
+			ADVANCE(Inst + 2);
+		}
 		Frame->Line = Inst->Line;
 		Frame->Inst = Inst + 2;
 		Frame->Top = Top;
-#ifdef ML_SCHEDULER
-		Frame->Schedule.Counter[0] = Counter;
-#endif
 		return ml_iter_key((ml_state_t *)Frame, Result);
 	}
 	DO_CALL: {
+		CHECK_COUNTER
 		int Count = Inst[1].Count;
 		ml_value_t *Function = Top[~Count];
 		ml_value_t **Args = Top - Count;
@@ -661,18 +686,13 @@ static void DEBUG_FUNC(frame_run)(DEBUG_STRUCT(frame) *Frame, ml_value_t *Result
             ml_error_trace_add(Result, (ml_source_t){Frame->Source, Inst->Line});
             ERROR();
         }
-#ifdef ML_SCHEDULER
-		Frame->Schedule.Counter[0] = Counter;
-#endif
 		if (Next->Opcode == MLI_RETURN && !Frame->Continue) {
 			// Ensure at least one other cached frame is available to prevent this frame being used immediately which may result in arguments being overwritten.
-			ML_CACHED_FRAME_LOCK();
 			if (!MLCachedFrame) {
 				MLCachedFrame = GC_MALLOC(ML_FRAME_REUSE_SIZE);
 			}
 			Frame->Next = MLCachedFrame->Next;
 			MLCachedFrame->Next = Frame;
-			ML_CACHED_FRAME_UNLOCK();
 			return ml_call(Frame->Base.Caller, Function, Count, Args);
 		} else {
 			Frame->Inst = Next;
@@ -682,22 +702,18 @@ static void DEBUG_FUNC(frame_run)(DEBUG_STRUCT(frame) *Frame, ml_value_t *Result
 		}
 	}
 	DO_CONST_CALL: {
+		CHECK_COUNTER
 		int Count = Inst[1].Count;
 		ml_value_t *Function = Inst[2].Value;
 		ml_value_t **Args = Top - Count;
 		ml_inst_t *Next = Inst + 3;
-#ifdef ML_SCHEDULER
-		Frame->Schedule.Counter[0] = Counter;
-#endif
 		if (Next->Opcode == MLI_RETURN && !Frame->Continue) {
 			// Ensure at least one other cached frame is available to prevent this frame being used immediately which may result in arguments being overwritten.
-			ML_CACHED_FRAME_LOCK();
 			if (!MLCachedFrame) {
 				MLCachedFrame = GC_MALLOC(ML_FRAME_REUSE_SIZE);
 			}
 			Frame->Next = MLCachedFrame->Next;
 			MLCachedFrame->Next = Frame;
-			ML_CACHED_FRAME_UNLOCK();
 			return ml_call(Frame->Base.Caller, Function, Count, Args);
 		} else {
 			Frame->Inst = Next;
@@ -867,9 +883,6 @@ static void DEBUG_FUNC(frame_run)(DEBUG_STRUCT(frame) *Frame, ml_value_t *Result
 		int Count = Inst[1].Count;
 		ml_value_t **Args = Top - (Count + 1);
 		ml_inst_t *Next = Inst + 2;
-#ifdef ML_SCHEDULER
-		Frame->Schedule.Counter[0] = Counter;
-#endif
 		Frame->Line = Inst->Line;
 		Frame->Inst = Next;
 		Frame->Top = Top - Count;
@@ -890,9 +903,6 @@ static void DEBUG_FUNC(frame_run)(DEBUG_STRUCT(frame) *Frame, ml_value_t *Result
 		Args[0] = Result;
 		Args[1] = Inst[1].Value;
 		ml_inst_t *Next = Inst + 2;
-#ifdef ML_SCHEDULER
-		Frame->Schedule.Counter[0] = Counter;
-#endif
 		Frame->Line = Inst->Line;
 		Frame->Inst = Next;
 		Frame->Top = Top;
@@ -940,7 +950,6 @@ static void DEBUG_FUNC(frame_run)(DEBUG_STRUCT(frame) *Frame, ml_value_t *Result
 			int Line = Inst->Line;
 			if (Frame->Breakpoints[Line / SIZE_BITS] & (1L << Line % SIZE_BITS)) goto DO_BREAKPOINT;
 		}
-		CHECK_COUNTER
 		Line = Inst->Line;
 		goto *Labels[Inst->Opcode];
 	}
@@ -958,7 +967,9 @@ static void DEBUG_FUNC(frame_run)(DEBUG_STRUCT(frame) *Frame, ml_value_t *Result
 		Frame->Line = Inst->Line;
 		Frame->Inst = Inst;
 		Frame->Top = Top;
-		return Frame->Schedule.swap((ml_state_t *)Frame, Result);
+		// A cancelled frame still yields, but resumes with the error so the counter is reset as usual.
+		ml_value_t *Error = ml_cancel_check(Frame->Base.Context);
+		return Frame->Schedule.swap((ml_state_t *)Frame, Error ?: Result);
 	}
 #endif
 }
@@ -974,12 +985,9 @@ static void DEBUG_FUNC(closure_call)(ml_state_t *Caller, ml_closure_t *Closure,
 	size_t Size = sizeof(DEBUG_STRUCT(frame)) + Info->FrameSize * sizeof(ml_value_t *);
 	DEBUG_STRUCT(frame) *Frame;
 	if (Size <= ML_FRAME_REUSE_SIZE) {
-		ML_CACHED_FRAME_LOCK();
 		if ((Frame = (DEBUG_STRUCT(frame) *)MLCachedFrame)) {
 			MLCachedFrame = Frame->Next;
-			ML_CACHED_FRAME_UNLOCK();
 		} else {
-			ML_CACHED_FRAME_UNLOCK();
 			Frame = GC_MALLOC(ML_FRAME_REUSE_SIZE);
 		}
 		Frame->Continue = 0;
@@ -6,6 +6,9 @@
 #endif
 #include <gc/gc.h>
 #include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <unistd.h>
 #include "ml_object.h"
 
 #include "minicbor/minicbor.h"
@@ -503,6 +506,345 @@ ml_value_t *ml_cbor_read_object(void *Data, int Count, ml_value_t **Args) {
 	return ml_simple_call(Constructor, Count2, Args2);
 }
 
+// External sorting //
+
+extern ml_value_t *LessMethod;
+
+typedef struct {
+	ml_value_t *Value;
+	ml_cbor_t Cbor;
+} ml_cbor_sort_item_t;
+
+typedef struct {
+	off_t Offset, End;
+} ml_cbor_sort_run_t;
+
+typedef struct {
+	ml_type_t *Type;
+	ml_value_t *Compare;
+	FILE *File;
+	ml_cbor_sort_run_t *Runs;
+	ml_value_t **Values;
+	int NumRuns, Count;
+} ml_cbor_sorted_t;
+
+ML_TYPE(MLCborSortedT, (MLSequenceT), "cbor-sorted");
+//!internal
+
+static void ml_cbor_sorted_finalize(ml_cbor_sorted_t *Sorted, void *Data) {
+	if (Sorted->File) fclose(Sorted->File);
+}
+
+static ml_value_t *ml_cbor_sort_before(ml_value_t *Compare, ml_value_t *A, ml_value_t *B) {
+	ml_value_t *Args[2] = {A, B};
+	return ml_deref(ml_simple_call(Compare, 2, Args));
+}
+
+static ml_value_t *ml_cbor_sort_items(ml_value_t *Compare, ml_cbor_sort_item_t *Items, int Count) {
+	// Bottom up merge sort, only taking from the right half when strictly before to keep the sort stable.
+	ml_cbor_sort_item_t *Source = Items, *Target = anew(ml_cbor_sort_item_t, Count);
+	for (int Width = 1; Width < Count; Width *= 2) {
+		for (int Start = 0; Start < Count; Start += 2 * Width) {
+			int Left = Start, Mid = Start + Width, Right = Mid, End = Start + 2 * Width, I = Start;
+			if (Mid > Count) Mid = Right = Count;
+			if (End > Count) End = Count;
+			while (Left < Mid && Right < End) {
+				ml_value_t *Before = ml_cbor_sort_before(Compare, Source[Right].Value, Source[Left].Value);
+				if (ml_is_error(Before)) return Before;
+				Target[I++] = Before != MLNil ? Source[Right++] : Source[Left++];
+			}
+			while (Left < Mid) Target[I++] = Source[Left++];
+			while (Right < End) Target[I++] = Source[Right++];
+		}
+		ml_cbor_sort_item_t *Temp = Source;
+		Source = Target;
+		Target = Temp;
+	}
+	if (Source != Items) memcpy(Items, Source, Count * sizeof(ml_cbor_sort_item_t));
+	return NULL;
+}
+
+typedef struct {
+	ml_state_t Base;
+	ml_value_t *Iter;
+	ml_cbor_sorted_t *Sorted;
+	ml_cbor_sort_item_t *Items;
+	size_t Used, Budget;
+	int Count, Space, RunSpace;
+} ml_cbor_sort_state_t;
+
+static ml_value_t *ml_cbor_sort_spill(ml_cbor_sort_state_t *State) {
+	ml_cbor_sorted_t *Sorted = State->Sorted;
+	ml_value_t *Error = ml_cbor_sort_items(Sorted->Compare, State->Items, State->Count);
+	if (Error) return Error;
+	if (!Sorted->File) {
+		Sorted->File = tmpfile();
+		if (!Sorted->File) return ml_error("CBORError", "Error creating temporary file: %s", strerror(errno));
+		GC_register_finalizer(Sorted, (void *)ml_cbor_sorted_finalize, 0, 0, 0);
+	}
+	if (Sorted->NumRuns == State->RunSpace) {
+		State->RunSpace = State->RunSpace ? 2 * State->RunSpace : 8;
+		ml_cbor_sort_run_t *Runs = anew(ml_cbor_sort_run_t, State->RunSpace);
+		if (Sorted->NumRuns) memcpy(Runs, Sorted->Runs, Sorted->NumRuns * sizeof(ml_cbor_sort_run_t));
+		Sorted->Runs = Runs;
+	}
+	ml_cbor_sort_run_t *Run = Sorted->Runs + Sorted->NumRuns++;
+	Run->Offset = ftello(Sorted->File);
+	for (int I = 0; I < State->Count; ++I) {
+		// Run entries store 32 bit lengths.
+		if (State->Items[I].Cbor.Length > UINT32_MAX) return ml_error("CBORError", "Value too large to write to temporary file");
+		uint32_t Length = State->Items[I].Cbor.Length;
+		if (fwrite(&Length, sizeof(Length), 1, Sorted->File) != 1) goto error;
+		if (fwrite(State->Items[I].Cbor.Data, 1, Length, Sorted->File) != Length) goto error;
+		State->Items[I].Value = NULL;
+		State->Items[I].Cbor.Data = NULL;
+	}
+	if (fflush(Sorted->File)) goto error;
+	Run->End = ftello(Sorted->File);
+	State->Count = 0;
+	State->Used = 0;
+	return NULL;
+error:
+	return ml_error("CBORError", "Error writing temporary file: %s", strerror(errno));
+}
+
+static void ml_cbor_sort_iterate(ml_cbor_sort_state_t *State, ml_value_t *Value);
+
+static void ml_cbor_sort_value(ml_cbor_sort_state_t *State, ml_value_t *Value) {
+	Value = ml_deref(Value);
+	if (ml_is_error(Value)) ML_CONTINUE(State->Base.Caller, Value);
+	ml_cbor_t Cbor = ml_to_cbor(Value);
+	if (!Cbor.Length) ML_CONTINUE(State->Base.Caller, Cbor.Error);
+	if (State->Count == State->Space) {
+		State->Space *= 2;
+		ml_cbor_sort_item_t *Items = anew(ml_cbor_sort_item_t, State->Space);
+		memcpy(Items, State->Items, State->Count * sizeof(ml_cbor_sort_item_t));
+		State->Items = Items;
+	}
+	State->Items[State->Count++] = (ml_cbor_sort_item_t){Value, Cbor};
+	State->Used += Cbor.Length + sizeof(ml_cbor_sort_item_t);
+	if (State->Used >= State->Budget) {
+		ml_value_t *Error = ml_cbor_sort_spill(State);
+		if (Error) ML_CONTINUE(State->Base.Caller, Error);
+	}
+	State->Base.run = (void *)ml_cbor_sort_iterate;
+	return ml_iter_next((ml_state_t *)State, State->Iter);
+}
+
+static void ml_cbor_sort_iterate(ml_cbor_sort_state_t *State, ml_value_t *Value) {
+	if (ml_is_error(Value)) ML_CONTINUE(State->Base.Caller, Value);
+	if (Value == MLNil) {
+		ml_cbor_sorted_t *Sorted = State->Sorted;
+		if (Sorted->NumRuns) {
+			if (State->Count) {
+				ml_value_t *Error = ml_cbor_sort_spill(State);
+				if (Error) ML_CONTINUE(State->Base.Caller, Error);
+			}
+		} else {
+			ml_value_t *Error = ml_cbor_sort_items(Sorted->Compare, State->Items, State->Count);
+			if (Error) ML_CONTINUE(State->Base.Caller, Error);
+			Sorted->Values = anew(ml_value_t *, State->Count);
+			for (int I = 0; I < State->Count; ++I) Sorted->Values[I] = State->Items[I].Value;
+			Sorted->Count = State->Count;
+		}
+		ML_CONTINUE(State->Base.Caller, Sorted);
+	}
+	State->Base.run = (void *)ml_cbor_sort_value;
+	return ml_iter_value((ml_state_t *)State, State->Iter = Value);
+}
+
+ML_FUNCTIONX(MLCborSort) {
+//@cbor::sort
+//<Sequence
+//<Budget?:integer
+//<Compare?:function
+//>sequence | error
+// Returns a sequence of the values produced by :mini:`Sequence` in sorted order, using :mini:`Compare(A, B)` (or :mini:`A < B` if omitted) to determine whether :mini:`A` comes before :mini:`B`. The sort is stable.
+// Values are held in memory until their CBOR encoded size reaches :mini:`Budget` bytes (64MiB by default), then sorted and written to a temporary file as a run. The runs are merged lazily as the returned sequence is iterated.
+// Once anything has been written to a run, every value is produced by decoding its CBOR encoding, so the results are copies rather than the original values. Each value must encode to less than 4GiB.
+	ML_CHECKX_ARG_COUNT(1);
+	ML_CHECKX_ARG_TYPE(0, MLSequenceT);
+	ml_cbor_sort_state_t *State = new(ml_cbor_sort_state_t);
+	ml_cbor_sorted_t *Sorted = new(ml_cbor_sorted_t);
+	Sorted->Type = MLCborSortedT;
+	Sorted->Compare = LessMethod;
+	State->Budget = 1 << 26;
+	for (int I = 1; I < Count; ++I) {
+		if (ml_is(Args[I], MLIntegerT)) {
+			int64_t Budget = ml_integer_value(Args[I]);
+			if (Budget <= 0) ML_ERROR("ValueError", "Memory budget must be positive");
+			State->Budget = Budget;
+		} else if (ml_is(Args[I], MLFunctionT)) {
+			Sorted->Compare = Args[I];
+		} else {
+			ML_ERROR("TypeError", "Expected integer or function for argument %d", I + 1);
+		}
+	}
+	State->Base.Caller = Caller;
+	State->Base.run = (void *)ml_cbor_sort_iterate;
+	State->Base.Context = Caller->Context;
+	State->Sorted = Sorted;
+	State->Space = 64;
+	State->Items = anew(ml_cbor_sort_item_t, State->Space);
+	return ml_iterate((ml_state_t *)State, Args[0]);
+}
+
+typedef struct {
+	unsigned char *Buffer;
+	off_t Offset, End;
+	size_t Start, Length, Size;
+	ml_value_t *Value;
+} ml_cbor_sort_reader_t;
+
+typedef struct {
+	ml_type_t *Type;
+	ml_cbor_sorted_t *Sorted;
+	ml_cbor_sort_reader_t *Readers;
+	int *Heap;
+	ml_value_t *Value;
+	int HeapSize, Index;
+} ml_cbor_sort_iter_t;
+
+ML_TYPE(MLCborSortIterT, (), "cbor-sort-iter");
+//!internal
+
+#define ML_CBOR_SORT_BUFFER_SIZE 65536
+
+static int ml_cbor_sort_reader_fill(ml_cbor_sort_reader_t *Reader, int FileNo, size_t Needed) {
+	if (Reader->Length >= Needed) return 1;
+	if (Needed > Reader->Size) {
+		while (Reader->Size < Needed) Reader->Size *= 2;
+		unsigned char *Buffer = GC_MALLOC_ATOMIC(Reader->Size);
+		memcpy(Buffer, Reader->Buffer + Reader->Start, Reader->Length);
+		Reader->Buffer = Buffer;
+	} else if (Reader->Start) {
+		memmove(Reader->Buffer, Reader->Buffer + Reader->Start, Reader->Length);
+	}
+	Reader->Start = 0;
+	while (Reader->Length < Needed) {
+		size_t Space = Reader->Size - Reader->Length;
+		if (Space > Reader->End - Reader->Offset) Space = Reader->End - Reader->Offset;
+		if (!Space) return 0;
+		ssize_t Read = pread(FileNo, Reader->Buffer + Reader->Length, Space, Reader->Offset);
+		if (Read <= 0) return 0;
+		Reader->Offset += Read;
+		Reader->Length += Read;
+	}
+	return 1;
+}
+
+static ml_value_t *ml_cbor_sort_reader_next(ml_cbor_sort_reader_t *Reader, int FileNo) {
+	if (!Reader->Length && Reader->Offset == Reader->End) return NULL;
+	uint32_t Length;
+	if (!ml_cbor_sort_reader_fill(Reader, FileNo, sizeof(Length))) goto error;
+	memcpy(&Length, Reader->Buffer + Reader->Start, sizeof(Length));
+	Reader->Start += sizeof(Length);
+	Reader->Length -= sizeof(Length);
+	if (!ml_cbor_sort_reader_fill(Reader, FileNo, Length)) goto error;
+	ml_cbor_t Cbor = {{.Data = Reader->Buffer + Reader->Start}, Length};
+	Reader->Start += Length;
+	Reader->Length -= Length;
+	return ml_from_cbor(Cbor, NULL, NULL);
+error:
+	return ml_error("CBORError", "Error reading temporary file: %s", strerror(errno));
+}
+
+static ml_value_t *ml_cbor_sort_heap_down(ml_cbor_sort_iter_t *Iter, int Index) {
+	int *Heap = Iter->Heap, Size = Iter->HeapSize;
+	ml_value_t *Compare = Iter->Sorted->Compare;
+	for (;;) {
+		int Min = Index, Left = 2 * Index + 1, Right = Left + 1;
+		for (int Child = Left; Child <= Right && Child < Size; ++Child) {
+			ml_value_t *A = Iter->Readers[Heap[Child]].Value, *B = Iter->Readers[Heap[Min]].Value;
+			ml_value_t *Before = ml_cbor_sort_before(Compare, A, B);
+			if (ml_is_error(Before)) return Before;
+			// Ties go to the earlier run to keep the merge stable.
+			if (Before != MLNil) {
+				Min = Child;
+			} else if (Heap[Child] < Heap[Min]) {
+				Before = ml_cbor_sort_before(Compare, B, A);
+				if (ml_is_error(Before)) return Before;
+				if (Before == MLNil) Min = Child;
+			}
+		}
+		if (Min == Index) return NULL;
+		int Temp = Heap[Index];
+		Heap[Index] = Heap[Min];
+		Heap[Min] = Temp;
+		Index = Min;
+	}
+}
+
+static ml_value_t *ml_cbor_sort_heap_pop(ml_cbor_sort_iter_t *Iter) {
+	int FileNo = fileno(Iter->Sorted->File);
+	ml_cbor_sort_reader_t *Reader = Iter->Readers + Iter->Heap[0];
+	ml_value_t *Value = ml_cbor_sort_reader_next(Reader, FileNo);
+	if (Value && ml_is_error(Value)) return Value;
+	if ((Reader->Value = Value)) return ml_cbor_sort_heap_down(Iter, 0);
+	if (--Iter->HeapSize) {
+		Iter->Heap[0] = Iter->Heap[Iter->HeapSize];
+		return ml_cbor_sort_heap_down(Iter, 0);
+	}
+	return NULL;
+}
+
+static void ML_TYPED_FN(ml_iterate, MLCborSortedT, ml_state_t *Caller, ml_cbor_sorted_t *Sorted) {
+	ml_cbor_sort_iter_t *Iter = new(ml_cbor_sort_iter_t);
+	Iter->Type = MLCborSortIterT;
+	Iter->Sorted = Sorted;
+	Iter->Index = 1;
+	if (!Sorted->NumRuns) {
+		if (!Sorted->Count) ML_RETURN(MLNil);
+		Iter->Value = Sorted->Values[0];
+		ML_RETURN(Iter);
+	}
+	int FileNo = fileno(Sorted->File);
+	Iter->Readers = anew(ml_cbor_sort_reader_t, Sorted->NumRuns);
+	Iter->Heap = anew(int, Sorted->NumRuns);
+	for (int I = 0; I < Sorted->NumRuns; ++I) {
+		ml_cbor_sort_reader_t *Reader = Iter->Readers + I;
+		Reader->Offset = Sorted->Runs[I].Offset;
+		Reader->End = Sorted->Runs[I].End;
+		Reader->Size = ML_CBOR_SORT_BUFFER_SIZE;
+		Reader->Buffer = GC_MALLOC_ATOMIC(Reader->Size);
+		ml_value_t *Value = ml_cbor_sort_reader_next(Reader, FileNo);
+		if (!Value) continue;
+		if (ml_is_error(Value)) ML_RETURN(Value);
+		Reader->Value = Value;
+		Iter->Heap[Iter->HeapSize++] = I;
+	}
+	for (int I = Iter->HeapSize / 2; --I >= 0;) {
+		ml_value_t *Error = ml_cbor_sort_heap_down(Iter, I);
+		if (Error) ML_RETURN(Error);
+	}
+	if (!Iter->HeapSize) ML_RETURN(MLNil);
+	Iter->Value = Iter->Readers[Iter->Heap[0]].Value;
+	ML_RETURN(Iter);
+}
+
+static void ML_TYPED_FN(ml_iter_next, MLCborSortIterT, ml_state_t *Caller, ml_cbor_sort_iter_t *Iter) {
+	ml_cbor_sorted_t *Sorted = Iter->Sorted;
+	if (!Sorted->NumRuns) {
+		if (Iter->Index >= Sorted->Count) ML_RETURN(MLNil);
+		Iter->Value = Sorted->Values[Iter->Index++];
+		ML_RETURN(Iter);
+	}
+	ml_value_t *Error = ml_cbor_sort_heap_pop(Iter);
+	if (Error) ML_RETURN(Error);
+	if (!Iter->HeapSize) ML_RETURN(MLNil);
+	Iter->Value = Iter->Readers[Iter->Heap[0]].Value;
+	++Iter->Index;
+	ML_RETURN(Iter);
+}
+
+static void ML_TYPED_FN(ml_iter_key, MLCborSortIterT, ml_state_t *Caller, ml_cbor_sort_iter_t *Iter) {
+	ML_RETURN(ml_integer(Iter->Index));
+}
+
+static void ML_TYPED_FN(ml_iter_value, MLCborSortIterT, ml_state_t *Caller, ml_cbor_sort_iter_t *Iter) {
+	ML_RETURN(Iter->Value);
+}
+
 void ml_cbor_init(stringmap_t *Globals) {
 	if (!CborDefaultTags) CborDefaultTags = ml_map();
 	if (!CborObjects) CborObjects = ml_map();
@@ -517,6 +859,7 @@ void ml_cbor_init(stringmap_t *Globals) {
 		stringmap_insert(Globals, "cbor", ml_module("cbor",
 			"encode", MLEncode,
 			"decode", MLDecode,
+			"sort", MLCborSort,
 			"Default", CborDefaultTags,
 			"Objects", CborObjects,
 		NULL));
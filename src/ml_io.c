@@ -4,6 +4,7 @@
 #include <unistd.h>
 #include <errno.h>
 #include <string.h>
+#include <fcntl.h>
 
 ML_TYPE(MLStreamT, (MLAnyT), "stream");
 ML_METHOD_DECL(MLIORead, "io::read");
@@ -36,15 +37,81 @@ void ml_io_write(ml_state_t *Caller, ml_value_t *Value, const void *Address, int
 }
 
 ML_METHODX("write", MLStreamT, MLStringT) {
+	ml_value_t *Error = ml_cancel_check(Caller->Context);
+	if (Error) ML_RETURN(Error);
 	return ml_io_write(Caller, Args[0], ml_string_value(Args[1]), ml_string_length(Args[1]));
 }
 
-typedef struct ml_fd_t {
+#if defined(ML_SCHEDULER) && defined(Linux)
+#define ML_IO_REACTOR
+#endif
+
+typedef struct ml_fd_t ml_fd_t;
+
+#ifdef ML_IO_REACTOR
+
+// When the current thread has a scheduler queue, reads and writes on an fd that is not ready park the calling state in an epoll based reactor.
+// The reactor is registered as the queue's poller, so ml_scheduler_queue_wait() blocks in epoll_wait() and ready states are resumed through the queue.
+// Non-blocking fds are read and written optimistically, blocking fds (such as an inherited stdin) are checked with poll() first and written in chunks of
+// at most PIPE_BUF bytes so that a ready fd never blocks the thread. Regular files cannot be polled and are always read and written directly.
+// Closing an fd sets its number to -1 and resumes any parked states with an error on the thread that owns the reactor, the fd number is never used again
+// since it may already belong to another file.
+// An fd belongs to the thread whose reactor it is registered with: only that thread reads, writes or parks on it, and only that thread touches Events,
+// the stream list links and the parked requests. Handing an fd to another thread is only supported once it has no parked operations, and the handoff
+// itself must be ordered by the program (e.g. by sending the fd over a channel). close is the one operation that may be called from any thread, it
+// takes Fd and Reactor atomically and forwards the cleanup of parked states to the owning thread's queue.
+
+#include <sys/epoll.h>
+#include <sys/stat.h>
+#include <poll.h>
+#include <limits.h>
+#ifdef ML_THREADSAFE
+#include <sys/eventfd.h>
+#endif
+
+#define ML_IO_REACTOR_EVENTS 64
+
+#define ML_FD_CHECKED 1
+#define ML_FD_NONBLOCK 2
+#define ML_FD_UNPOLLABLE 4
+
+typedef struct ml_io_reactor_t ml_io_reactor_t;
+
+typedef struct {
+	ml_state_t Base;
+	ml_fd_t *Stream;
+	void *Address;
+	int Count, Written;
+} ml_io_request_t;
+
+struct ml_io_reactor_t {
+	ml_scheduler_poller_t Base;
+	ml_fd_t *Streams;
+	int Epoll;
+#ifdef ML_THREADSAFE
+	ml_scheduler_queue_t *Queue;
+	int Wake;
+#endif
+};
+
+#endif
+
+struct ml_fd_t {
 	const ml_type_t *Type;
 	int Fd;
-} ml_fd_t;
+#ifdef ML_IO_REACTOR
+	int Flags, Events;
+	ml_io_reactor_t *Reactor;
+	ml_fd_t *Next, *Prev;
+	ml_io_request_t *Read, *Write;
+#endif
+};
 
-ML_TYPE(MLFdT, (MLStreamT), "fd");
+extern ml_cfunction_t MLFdOpen[];
+
+ML_TYPE(MLFdT, (MLStreamT), "fd",
+	.Constructor = (ml_value_t *)MLFdOpen
+);
 
 ml_value_t *ml_fd_new(int Fd) {
 	ml_fd_t *Stream = new(ml_fd_t);
@@ -53,50 +120,335 @@ ml_value_t *ml_fd_new(int Fd) {
 	return (ml_value_t *)Stream;
 }
 
-static void ML_TYPED_FN(ml_io_read, MLFdT, ml_state_t *Caller, ml_fd_t *Stream, void *Address, int Count) {
-	ssize_t Actual = read(Stream->Fd, Address, Count);
-	ml_value_t *Result;
-	if (Actual < 0) {
-		Result = ml_error("ReadError", strerror(errno));
+#ifdef ML_IO_REACTOR
+
+#ifdef ML_THREADSAFE
+static __thread ml_io_reactor_t *CurrentReactor = NULL;
+#else
+static ml_io_reactor_t *CurrentReactor = NULL;
+#endif
+
+static void ml_io_reactor_poll(ml_io_reactor_t *Reactor, int Timeout) {
+	struct epoll_event Events[ML_IO_REACTOR_EVENTS];
+	int Count = epoll_wait(Reactor->Epoll, Events, ML_IO_REACTOR_EVENTS, Timeout);
+	for (int I = 0; I < Count; ++I) {
+		ml_fd_t *Stream = (ml_fd_t *)Events[I].data.ptr;
+#ifdef ML_THREADSAFE
+		if (!Stream) {
+			uint64_t Value;
+			while (read(Reactor->Wake, &Value, sizeof(Value)) < 0 && errno == EINTR);
+			continue;
+		}
+#endif
+		int Ready = Events[I].events;
+		if (Ready & (EPOLLERR | EPOLLHUP)) Ready |= EPOLLIN | EPOLLOUT;
+		ml_io_request_t *Read = NULL, *Write = NULL;
+		if ((Ready & EPOLLIN) && Stream->Read) {
+			Read = Stream->Read;
+			Stream->Read = NULL;
+			Stream->Events &= ~EPOLLIN;
+			--Reactor->Base.Waiting;
+		}
+		if ((Ready & EPOLLOUT) && Stream->Write) {
+			Write = Stream->Write;
+			Stream->Write = NULL;
+			Stream->Events &= ~EPOLLOUT;
+			--Reactor->Base.Waiting;
+		}
+		if (Stream->Events) {
+			// Registrations are one-shot, rearm for the remaining direction.
+			struct epoll_event Event = {Stream->Events | EPOLLONESHOT, {.ptr = Stream}};
+			epoll_ctl(Reactor->Epoll, EPOLL_CTL_MOD, Stream->Fd, &Event);
+		} else {
+			if (Stream->Prev) Stream->Prev->Next = Stream->Next; else Reactor->Streams = Stream->Next;
+			if (Stream->Next) Stream->Next->Prev = Stream->Prev;
+			Stream->Next = Stream->Prev = NULL;
+		}
+		if (Read) ml_scheduler_queue_add((ml_state_t *)Read, MLNil);
+		if (Write) ml_scheduler_queue_add((ml_state_t *)Write, MLNil);
+	}
+}
+
+#ifdef ML_THREADSAFE
+
+static void ml_io_reactor_wake(ml_io_reactor_t *Reactor) {
+	uint64_t Value = 1;
+	while (write(Reactor->Wake, &Value, sizeof(Value)) < 0 && errno == EINTR);
+}
+
+#endif
+
+static ml_io_reactor_t *ml_io_reactor() {
+	ml_io_reactor_t *Reactor = CurrentReactor;
+	if (Reactor) return Reactor;
+	if (!ml_scheduler_queue_current() || ml_scheduler_queue_get_poller()) return NULL;
+	int Epoll = epoll_create1(EPOLL_CLOEXEC);
+	if (Epoll < 0) return NULL;
+	// Reactors live as long as their thread and hold the only references to streams with parked states.
+	Reactor = GC_MALLOC_UNCOLLECTABLE(sizeof(ml_io_reactor_t));
+	Reactor->Base.poll = (void *)ml_io_reactor_poll;
+	Reactor->Epoll = Epoll;
+#ifdef ML_THREADSAFE
+	Reactor->Base.wake = (void *)ml_io_reactor_wake;
+	Reactor->Queue = ml_scheduler_queue_current();
+	Reactor->Wake = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	struct epoll_event Event = {EPOLLIN, {.ptr = NULL}};
+	epoll_ctl(Epoll, EPOLL_CTL_ADD, Reactor->Wake, &Event);
+#endif
+	ml_scheduler_queue_poller((ml_scheduler_poller_t *)Reactor);
+	return CurrentReactor = Reactor;
+}
+
+static int ml_fd_ready(ml_fd_t *Stream, int Events) {
+	// Returns 1 if Stream should be read or written directly, 0 if the caller should park first.
+	if (!(Stream->Flags & ML_FD_CHECKED)) {
+		Stream->Flags |= ML_FD_CHECKED;
+		struct stat Stat;
+		if (fstat(Stream->Fd, &Stat) || S_ISREG(Stat.st_mode) || S_ISDIR(Stat.st_mode)) Stream->Flags |= ML_FD_UNPOLLABLE;
+		int Flags = fcntl(Stream->Fd, F_GETFL);
+		if (Flags >= 0 && (Flags & O_NONBLOCK)) Stream->Flags |= ML_FD_NONBLOCK;
+	}
+	if (Stream->Flags & (ML_FD_UNPOLLABLE | ML_FD_NONBLOCK)) return 1;
+	if (!ml_io_reactor()) return 1;
+	struct pollfd Poll = {Stream->Fd, Events == EPOLLIN ? POLLIN : POLLOUT, 0};
+	return poll(&Poll, 1, 0) != 0;
+}
+
+static void ml_fd_read(ml_state_t *Caller, ml_fd_t *Stream, void *Address, int Count);
+static void ml_fd_write(ml_state_t *Caller, ml_fd_t *Stream, const void *Address, int Count, int Written);
+
+static void ml_io_request_read(ml_io_request_t *Request, ml_value_t *Value) {
+	return ml_fd_read(Request->Base.Caller, Request->Stream, Request->Address, Request->Count);
+}
+
+static void ml_io_request_write(ml_io_request_t *Request, ml_value_t *Value) {
+	return ml_fd_write(Request->Base.Caller, Request->Stream, Request->Address, Request->Count, Request->Written);
+}
+
+static void ml_fd_park(ml_state_t *Caller, ml_fd_t *Stream, int Event, void *Address, int Count, int Written) {
+	ml_io_reactor_t *Reactor = ml_io_reactor();
+	const char *Error = Event == EPOLLIN ? "ReadError" : "WriteError";
+	if (!Reactor) ML_ERROR(Error, "No reactor for current thread");
+	if (Stream->Events & Event) ML_ERROR(Error, "Stream already has a pending operation");
+	ml_io_reactor_t *Previous = __atomic_load_n(&Stream->Reactor, __ATOMIC_ACQUIRE);
+	if (Previous != Reactor) {
+		// Only valid after the program has handed the fd over to this thread, see above.
+		if (Stream->Events) ML_ERROR(Error, "Stream is in use by another thread");
+		if (Previous) epoll_ctl(Previous->Epoll, EPOLL_CTL_DEL, Stream->Fd, NULL);
+		struct epoll_event Register = {0, {.ptr = Stream}};
+		if (epoll_ctl(Reactor->Epoll, EPOLL_CTL_ADD, Stream->Fd, &Register)) {
+			if (errno != EPERM) ML_ERROR(Error, "%s", strerror(errno));
+			__atomic_store_n(&Stream->Reactor, NULL, __ATOMIC_RELEASE);
+			Stream->Flags |= ML_FD_UNPOLLABLE;
+			if (Event == EPOLLIN) return ml_fd_read(Caller, Stream, Address, Count);
+			return ml_fd_write(Caller, Stream, Address, Count, Written);
+		}
+		__atomic_store_n(&Stream->Reactor, Reactor, __ATOMIC_RELEASE);
+	}
+	struct epoll_event Ready = {Stream->Events | Event | EPOLLONESHOT, {.ptr = Stream}};
+	if (epoll_ctl(Reactor->Epoll, EPOLL_CTL_MOD, Stream->Fd, &Ready)) ML_ERROR(Error, "%s", strerror(errno));
+	ml_io_request_t *Request = new(ml_io_request_t);
+	Request->Base.Caller = Caller;
+	Request->Base.Context = Caller->Context;
+	Request->Stream = Stream;
+	Request->Address = Address;
+	Request->Count = Count;
+	Request->Written = Written;
+	if (Event == EPOLLIN) {
+		Request->Base.run = (ml_state_fn)ml_io_request_read;
+		Stream->Read = Request;
 	} else {
-		Result = ml_integer(Actual);
+		Request->Base.run = (ml_state_fn)ml_io_request_write;
+		Stream->Write = Request;
 	}
-	ML_CONTINUE(Caller, Result);
+	if (!Stream->Events) {
+		Stream->Prev = NULL;
+		Stream->Next = Reactor->Streams;
+		if (Reactor->Streams) Reactor->Streams->Prev = Stream;
+		Reactor->Streams = Stream;
+	}
+	Stream->Events |= Event;
+	++Reactor->Base.Waiting;
+}
+
+static void ml_fd_closed(ml_io_request_t *Request, ml_value_t *Value) {
+	// Runs on the thread that owns the reactor, after Stream has been closed.
+	ml_fd_t *Stream = Request->Stream;
+	if (!Stream->Events) return;
+	ml_io_reactor_t *Reactor = CurrentReactor;
+	if (Stream->Prev) Stream->Prev->Next = Stream->Next; else Reactor->Streams = Stream->Next;
+	if (Stream->Next) Stream->Next->Prev = Stream->Prev;
+	Stream->Next = Stream->Prev = NULL;
+	Stream->Events = 0;
+	if (Stream->Read) {
+		--Reactor->Base.Waiting;
+		ml_scheduler_queue_add(Stream->Read->Base.Caller, ml_error("ReadError", "Stream closed"));
+		Stream->Read = NULL;
+	}
+	if (Stream->Write) {
+		--Reactor->Base.Waiting;
+		ml_scheduler_queue_add(Stream->Write->Base.Caller, ml_error("WriteError", "Stream closed"));
+		Stream->Write = NULL;
+	}
+}
+
+#endif
+
+static void ml_fd_read(ml_state_t *Caller, ml_fd_t *Stream, void *Address, int Count) {
+	ml_value_t *Error = ml_cancel_check(Caller->Context);
+	if (Error) ML_RETURN(Error);
+	if (Stream->Fd < 0) ML_ERROR("ReadError", "Stream closed");
+#ifdef ML_IO_REACTOR
+	if (!ml_fd_ready(Stream, EPOLLIN)) return ml_fd_park(Caller, Stream, EPOLLIN, Address, Count, 0);
+#endif
+	ssize_t Actual;
+	while ((Actual = read(Stream->Fd, Address, Count)) < 0 && errno == EINTR);
+	if (Actual < 0) {
+#ifdef ML_IO_REACTOR
+		if ((errno == EAGAIN || errno == EWOULDBLOCK) && ml_io_reactor()) {
+			return ml_fd_park(Caller, Stream, EPOLLIN, Address, Count, 0);
+		}
+#endif
+		ML_ERROR("ReadError", "%s", strerror(errno));
+	}
+	ML_RETURN(ml_integer(Actual));
+}
+
+static void ml_fd_write(ml_state_t *Caller, ml_fd_t *Stream, const void *Address, int Count, int Written) {
+	ml_value_t *Error = ml_cancel_check(Caller->Context);
+	if (Error) ML_RETURN(Error);
+	if (Stream->Fd < 0) ML_ERROR("WriteError", "Stream closed");
+#ifdef ML_IO_REACTOR
+	while (Written < Count) {
+		if (!ml_fd_ready(Stream, EPOLLOUT)) return ml_fd_park(Caller, Stream, EPOLLOUT, (void *)Address, Count, Written);
+		int Chunk = Count - Written;
+		if (!(Stream->Flags & (ML_FD_UNPOLLABLE | ML_FD_NONBLOCK)) && CurrentReactor && Chunk > PIPE_BUF) Chunk = PIPE_BUF;
+		ssize_t Actual = write(Stream->Fd, (const char *)Address + Written, Chunk);
+		if (Actual < 0) {
+			if (errno == EINTR) continue;
+			if ((errno == EAGAIN || errno == EWOULDBLOCK) && ml_io_reactor()) {
+				return ml_fd_park(Caller, Stream, EPOLLOUT, (void *)Address, Count, Written);
+			}
+			ML_ERROR("WriteError", "%s", strerror(errno));
+		}
+		Written += Actual;
+		if (!CurrentReactor) break;
+	}
+	ML_RETURN(ml_integer(Written));
+#else
+	ssize_t Actual = write(Stream->Fd, Address, Count);
+	if (Actual < 0) ML_ERROR("WriteError", "%s", strerror(errno));
+	ML_RETURN(ml_integer(Actual));
+#endif
+}
+
+static void ML_TYPED_FN(ml_io_read, MLFdT, ml_state_t *Caller, ml_fd_t *Stream, void *Address, int Count) {
+	return ml_fd_read(Caller, Stream, Address, Count);
 }
 
-ML_METHOD(MLIORead, MLFdT, MLAddressT) {
+ML_METHODX(MLIORead, MLFdT, MLBufferT) {
 //@io::read
+//<Fd
+//<Buffer
+//>integer
+// Reads up to :mini:`Buffer:length` bytes from :mini:`Fd` into :mini:`Buffer` and returns the number of bytes read (:mini:`0` at the end of input).
+// If the current thread has a scheduler queue and :mini:`Fd` is not ready, the current state is suspended until it is.
 	ml_fd_t *Stream = (ml_fd_t *)Args[0];
 	ml_address_t *Buffer = (ml_address_t *)Args[1];
-	ssize_t Actual = read(Stream->Fd, Buffer->Value, Buffer->Length);
-	if (Actual < 0) {
-		return ml_error("ReadError", strerror(errno));
-	} else {
-		return ml_integer(Actual);
-	}
+	return ml_fd_read(Caller, Stream, (void *)Buffer->Value, Buffer->Length);
 }
 
 static void ML_TYPED_FN(ml_io_write, MLFdT, ml_state_t *Caller, ml_fd_t *Stream, void *Address, int Count) {
-	ssize_t Actual = write(Stream->Fd, Address, Count);
-	ml_value_t *Result;
-	if (Actual < 0) {
-		Result = ml_error("WriteError", strerror(errno));
-	} else {
-		Result = ml_integer(Actual);
-	}
-	ML_RETURN(Result);
+	return ml_fd_write(Caller, Stream, Address, Count, 0);
 }
 
-ML_METHOD(MLIOWrite, MLFdT, MLAddressT) {
+ML_METHODX(MLIOWrite, MLFdT, MLAddressT) {
 //@io::write
+//<Fd
+//<Address
+//>integer
+// Writes the bytes of :mini:`Address` to :mini:`Fd` and returns the number of bytes written.
+// If the current thread has a scheduler queue and :mini:`Fd` is not ready, the current state is suspended until it is.
 	ml_fd_t *Stream = (ml_fd_t *)Args[0];
 	ml_address_t *Buffer = (ml_address_t *)Args[1];
-	ssize_t Actual = write(Stream->Fd, Buffer->Value, Buffer->Length);
-	if (Actual < 0) {
-		return ml_error("WriteError", strerror(errno));
+	return ml_fd_write(Caller, Stream, Buffer->Value, Buffer->Length, 0);
+}
+
+ML_METHOD("close", MLFdT) {
+//<Fd
+//>nil
+// Closes :mini:`Fd`. Any reads or writes still waiting on :mini:`Fd` are resumed and return an error. Unlike other operations, :mini:`close` may be called from a thread other than the one using :mini:`Fd`.
+	ml_fd_t *Stream = (ml_fd_t *)Args[0];
+	int Fd = __atomic_exchange_n(&Stream->Fd, -1, __ATOMIC_ACQ_REL);
+	if (Fd < 0) return ml_error("CloseError", "Stream already closed");
+#ifdef ML_IO_REACTOR
+	ml_io_reactor_t *Reactor = __atomic_exchange_n(&Stream->Reactor, NULL, __ATOMIC_ACQ_REL);
+	if (Reactor) {
+		epoll_ctl(Reactor->Epoll, EPOLL_CTL_DEL, Fd, NULL);
+		ml_io_request_t *Request = new(ml_io_request_t);
+		Request->Base.Context = &MLRootContext;
+		Request->Base.run = (ml_state_fn)ml_fd_closed;
+		Request->Stream = Stream;
+#ifdef ML_THREADSAFE
+		if (Reactor != CurrentReactor) {
+			ml_scheduler_queue_send(Reactor->Queue, (ml_state_t *)Request, MLNil);
+		} else {
+			ml_fd_closed(Request, MLNil);
+		}
+#else
+		ml_fd_closed(Request, MLNil);
+#endif
+	}
+#endif
+	if (close(Fd)) return ml_error("CloseError", "%s", strerror(errno));
+	return MLNil;
+}
+
+ML_FUNCTION(MLFdOpen) {
+//@fd
+//<Path:string
+//<Mode?:string
+//>fd
+// Opens the file at :mini:`Path` and returns its file descriptor. :mini:`Mode` is one of :mini:`"r"` (the default), :mini:`"w"`, :mini:`"a"` or :mini:`"r+"`.
+	ML_CHECK_ARG_COUNT(1);
+	ML_CHECK_ARG_TYPE(0, MLStringT);
+	const char *Path = ml_string_value(Args[0]);
+	const char *Mode = "r";
+	if (Count > 1) {
+		ML_CHECK_ARG_TYPE(1, MLStringT);
+		Mode = ml_string_value(Args[1]);
+	}
+	int Flags;
+	if (!strcmp(Mode, "r")) {
+		Flags = O_RDONLY;
+	} else if (!strcmp(Mode, "w")) {
+		Flags = O_WRONLY | O_CREAT | O_TRUNC;
+	} else if (!strcmp(Mode, "a")) {
+		Flags = O_WRONLY | O_CREAT | O_APPEND;
+	} else if (!strcmp(Mode, "r+")) {
+		Flags = O_RDWR;
 	} else {
-		return ml_integer(Actual);
+		return ml_error("ValueError", "Invalid mode %s", Mode);
 	}
+	int Fd = open(Path, Flags | O_CLOEXEC, 0666);
+	if (Fd < 0) return ml_error("FileError", "failed to open %s in mode %s: %s", Path, Mode, strerror(errno));
+	return ml_fd_new(Fd);
+}
+
+ML_FUNCTION(MLIOPipe) {
+//@io::pipe
+//>tuple[fd, fd]
+// Creates a new non-blocking pipe and returns a tuple of its read and write ends.
+	int Fds[2];
+#ifdef Linux
+	if (pipe2(Fds, O_NONBLOCK | O_CLOEXEC)) return ml_error("PipeError", "%s", strerror(errno));
+#else
+	if (pipe(Fds)) return ml_error("PipeError", "%s", strerror(errno));
+#endif
+	ml_value_t *Tuple = ml_tuple(2);
+	ml_tuple_set(Tuple, 1, ml_fd_new(Fds[0]));
+	ml_tuple_set(Tuple, 2, ml_fd_new(Fds[1]));
+	return Tuple;
 }
 
 void ml_io_init(stringmap_t *Globals) {
@@ -110,6 +462,7 @@ void ml_io_init(stringmap_t *Globals) {
 			"stderr", ml_fd_new(STDERR_FILENO),
 			"read", MLIORead,
 			"write", MLIOWrite,
+			"pipe", MLIOPipe,
 		NULL));
 	}
 }
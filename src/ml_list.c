@@ -121,9 +121,26 @@ static void list_iterate(ml_iter_state_t *State, ml_value_t *Value) {
 	if (ml_is_error(Value)) ML_CONTINUE(State->Base.Caller, Value);
 	State->Base.run = (void *)list_iter_value;
 	if (Value == MLNil) ML_CONTINUE(State->Base.Caller, State->Values[0]);
+	if (ml_iter_pair(Value, NULL, State->Values + 1)) {
+		ml_list_put(State->Values[0], ml_deref(State->Values[1]));
+		State->Base.run = (void *)list_iterate;
+		return ml_iter_next((ml_state_t *)State, State->Iter = Value);
+	}
 	return ml_iter_value((ml_state_t *)State, State->Iter = Value);
 }
 
+static int list_grow_block(ml_value_t *List, ml_value_t *Sequence) {
+	ml_iter_cursor_t Cursor[1] = {{NULL, 0}};
+	ml_value_t *Values[ML_ITER_BLOCK_SIZE];
+	int Size = ml_iter_block(Sequence, Cursor, NULL, Values, ML_ITER_BLOCK_SIZE);
+	if (Size < 0) return 0;
+	while (Size > 0) {
+		for (int I = 0; I < Size; ++I) ml_list_put(List, ml_deref(Values[I]));
+		Size = ml_iter_block(Sequence, Cursor, NULL, Values, ML_ITER_BLOCK_SIZE);
+	}
+	return 1;
+}
+
 ML_METHOD(MLSequenceCount, MLListT) {
 //!internal
 	return ml_integer(ml_list_length(Args[0]));
@@ -133,12 +150,15 @@ ML_METHODVX(MLListT, MLSequenceT) {
 //<Sequence
 //>list
 // Returns a list of all of the values produced by :mini:`Sequence`.
-	ml_iter_state_t *State = xnew(ml_iter_state_t, 1, ml_value_t *);
+	ml_value_t *Sequence = ml_chained(Count, Args);
+	ml_value_t *List = ml_list();
+	if (list_grow_block(List, Sequence)) ML_RETURN(List);
+	ml_iter_state_t *State = xnew(ml_iter_state_t, 2, ml_value_t *);
 	State->Base.Caller = Caller;
 	State->Base.run = (void *)list_iterate;
 	State->Base.Context = Caller->Context;
-	State->Values[0] = ml_list();
-	return ml_iterate((ml_state_t *)State, ml_chained(Count, Args));
+	State->Values[0] = List;
+	return ml_iterate((ml_state_t *)State, Sequence);
 }
 
 ML_METHODVX("grow", MLListT, MLSequenceT) {
@@ -146,12 +166,14 @@ ML_METHODVX("grow", MLListT, MLSequenceT) {
 //<Sequence
 //>list
 // Pushes of all of the values produced by :mini:`Sequence` onto :mini:`List` and returns :mini:`List`.
-	ml_iter_state_t *State = xnew(ml_iter_state_t, 1, ml_value_t *);
+	ml_value_t *Sequence = ml_chained(Count - 1, Args + 1);
+	if (list_grow_block(Args[0], Sequence)) ML_RETURN(Args[0]);
+	ml_iter_state_t *State = xnew(ml_iter_state_t, 2, ml_value_t *);
 	State->Base.Caller = Caller;
 	State->Base.run = (void *)list_iterate;
 	State->Base.Context = Caller->Context;
 	State->Values[0] = Args[0];
-	return ml_iterate((ml_state_t *)State, ml_chained(Count - 1, Args + 1));
+	return ml_iterate((ml_state_t *)State, Sequence);
 }
 
 ml_value_t *ml_list_from_array(ml_value_t **Values, int Length) {
@@ -543,6 +565,32 @@ static void ML_TYPED_FN(ml_iterate, MLListT, ml_state_t *Caller, ml_list_t *List
 	}
 }
 
+static int ML_TYPED_FN(ml_iter_block, MLListT, ml_list_t *List, ml_iter_cursor_t *Cursor, ml_value_t **Keys, ml_value_t **Values, int Size) {
+	ml_list_node_t *Node = Cursor->Index ? Cursor->Node : List->Head;
+	long Index = Cursor->Index;
+	int Count = 0;
+	while (Node && Count < Size) {
+		if (Keys) Keys[Count] = ml_integer(Index + Count + 1);
+		if (Values) Values[Count] = (ml_value_t *)Node;
+		++Count;
+		Node = Node->Next;
+	}
+	Cursor->Node = Node;
+	Cursor->Index = Index + Count;
+	return Count;
+}
+
+static long ML_TYPED_FN(ml_iter_seek, MLListT, ml_list_t *List, ml_iter_cursor_t *Cursor, long Index) {
+	if (Index >= List->Length) {
+		Cursor->Node = NULL;
+		Cursor->Index = List->Length;
+	} else if (Index > 0) {
+		Cursor->Node = ml_list_index(List, Index + 1);
+		Cursor->Index = Index;
+	}
+	return List->Length;
+}
+
 ML_METHODV("push", MLListT) {
 //<List
 //<Values...: any
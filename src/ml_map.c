@@ -2,6 +2,7 @@
 #include "minilang.h"
 #include "ml_macros.h"
 #include <string.h>
+#include <stdlib.h>
 #include "ml_sequence.h"
 
 ML_TYPE(MLMapT, (MLSequenceT), "map",
@@ -70,10 +71,32 @@ static void map_iter_key(ml_iter_state_t *State, ml_value_t *Value) {
 static void map_iterate(ml_iter_state_t *State, ml_value_t *Value) {
 	if (ml_is_error(Value)) ML_CONTINUE(State->Base.Caller, Value);
 	if (Value == MLNil) ML_CONTINUE(State->Base.Caller, State->Values[0]);
+	if (ml_iter_pair(Value, State->Values + 1, State->Values + 2)) {
+		ml_value_t *Key = ml_deref(State->Values[1]);
+		if (Key == MLNil) Key = ml_integer(ml_map_size(State->Values[0]) + 1);
+		ml_map_insert(State->Values[0], Key, ml_deref(State->Values[2]));
+		return ml_iter_next((ml_state_t *)State, State->Iter = Value);
+	}
 	State->Base.run = (void *)map_iter_key;
 	return ml_iter_key((ml_state_t *)State, State->Iter = Value);
 }
 
+static int map_grow_block(ml_value_t *Map, ml_value_t *Sequence) {
+	ml_iter_cursor_t Cursor[1] = {{NULL, 0}};
+	ml_value_t *Keys[ML_ITER_BLOCK_SIZE], *Values[ML_ITER_BLOCK_SIZE];
+	int Size = ml_iter_block(Sequence, Cursor, Keys, Values, ML_ITER_BLOCK_SIZE);
+	if (Size < 0) return 0;
+	while (Size > 0) {
+		for (int I = 0; I < Size; ++I) {
+			ml_value_t *Key = Keys[I];
+			if (Key == MLNil) Key = ml_integer(ml_map_size(Map) + 1);
+			ml_map_insert(Map, Key, ml_deref(Values[I]));
+		}
+		Size = ml_iter_block(Sequence, Cursor, Keys, Values, ML_ITER_BLOCK_SIZE);
+	}
+	return 1;
+}
+
 ML_METHOD(MLSequenceCount, MLMapT) {
 //!internal
 	return ml_integer(ml_map_size(Args[0]));
@@ -83,12 +106,15 @@ ML_METHODVX(MLMapT, MLSequenceT) {
 //<Sequence
 //>map
 // Returns a map of all the key and value pairs produced by :mini:`Sequence`.
-	ml_iter_state_t *State = xnew(ml_iter_state_t, 2, ml_value_t *);
+	ml_value_t *Sequence = ml_chained(Count, Args);
+	ml_value_t *Map = ml_map();
+	if (map_grow_block(Map, Sequence)) ML_RETURN(Map);
+	ml_iter_state_t *State = xnew(ml_iter_state_t, 3, ml_value_t *);
 	State->Base.Caller = Caller;
 	State->Base.run = (void *)map_iterate;
 	State->Base.Context = Caller->Context;
-	State->Values[0] = ml_map();
-	return ml_iterate((ml_state_t *)State, ml_chained(Count, Args));
+	State->Values[0] = Map;
+	return ml_iterate((ml_state_t *)State, Sequence);
 }
 
 ML_METHODVX("grow", MLMapT, MLSequenceT) {
@@ -96,12 +122,14 @@ ML_METHODVX("grow", MLMapT, MLSequenceT) {
 //<Sequence
 //>map
 // Adds of all the key and value pairs produced by :mini:`Sequence` to :mini:`Map` and returns :mini:`Map`.
-	ml_iter_state_t *State = xnew(ml_iter_state_t, 2, ml_value_t *);
+	ml_value_t *Sequence = ml_chained(Count - 1, Args + 1);
+	if (map_grow_block(Args[0], Sequence)) ML_RETURN(Args[0]);
+	ml_iter_state_t *State = xnew(ml_iter_state_t, 3, ml_value_t *);
 	State->Base.Caller = Caller;
 	State->Base.run = (void *)map_iterate;
 	State->Base.Context = Caller->Context;
 	State->Values[0] = Args[0];
-	return ml_iterate((ml_state_t *)State, ml_chained(Count - 1, Args + 1));
+	return ml_iterate((ml_state_t *)State, Sequence);
 }
 
 extern ml_value_t *CompareMethod;
@@ -226,12 +254,9 @@ ml_map_node_t *ml_map_slot(ml_value_t *Map0, ml_value_t *Key) {
 	return ml_map_node(Map, &Map->Root, ml_typeof(Key)->hash(Key, NULL), Key);
 }
 
-ml_value_t *ml_map_insert(ml_value_t *Map0, ml_value_t *Key, ml_value_t *Value) {
-	ml_map_t *Map = (ml_map_t *)Map0;
-	ml_map_node_t *Node = ml_map_node(Map, &Map->Root, ml_typeof(Key)->hash(Key, NULL), Key);
-	ml_value_t *Old = Node->Value ?: MLNil;
-	Node->Value = Value;
 #ifdef ML_GENERICS
+
+static void ml_map_update_type(ml_map_t *Map, ml_value_t *Key, ml_value_t *Value) {
 	if (Map->Size == 1 && Map->Type == MLMapT) {
 		ml_type_t *Types[] = {MLMapT, ml_typeof(Key), ml_typeof(Value)};
 		Map->Type = ml_generic_type(3, Types);
@@ -247,10 +272,65 @@ ml_value_t *ml_map_insert(ml_value_t *Map0, ml_value_t *Key, ml_value_t *Value)
 			}
 		}
 	}
+}
+
+#endif
+
+ml_value_t *ml_map_insert(ml_value_t *Map0, ml_value_t *Key, ml_value_t *Value) {
+	ml_map_t *Map = (ml_map_t *)Map0;
+	ml_map_node_t *Node = ml_map_node(Map, &Map->Root, ml_typeof(Key)->hash(Key, NULL), Key);
+	ml_value_t *Old = Node->Value ?: MLNil;
+	Node->Value = Value;
+#ifdef ML_GENERICS
+	ml_map_update_type(Map, Key, Value);
 #endif
 	return Old;
 }
 
+static int ml_map_node_compare(const void *A, const void *B) {
+	ml_map_node_t *NodeA = *(ml_map_node_t **)A, *NodeB = *(ml_map_node_t **)B;
+	if (NodeA->Hash < NodeB->Hash) return -1;
+	if (NodeA->Hash > NodeB->Hash) return 1;
+	ml_value_t *Args[2] = {NodeA->Key, NodeB->Key};
+	return ml_integer_value(ml_simple_call(CompareMethod, 2, Args));
+}
+
+static ml_map_node_t *ml_map_build(ml_map_node_t **Nodes, int Size) {
+	if (!Size) return NULL;
+	int Middle = Size / 2;
+	ml_map_node_t *Node = Nodes[Middle];
+	Node->Left = ml_map_build(Nodes, Middle);
+	Node->Right = ml_map_build(Nodes + Middle + 1, Size - Middle - 1);
+	ml_map_update_depth(Node);
+	return Node;
+}
+
+ml_value_t *ml_map_from_nodes(ml_map_node_t **Nodes, int Size) {
+	ml_map_t *Map = (ml_map_t *)ml_map();
+	ml_map_node_t *Prev = NULL;
+	for (int I = 0; I < Size; ++I) {
+		ml_map_node_t *Node = Nodes[I];
+		Node->Type = MLMapNodeT;
+		if ((Node->Prev = Prev)) {
+			Prev->Next = Node;
+		} else {
+			Map->Head = Node;
+		}
+		Prev = Node;
+		++Map->Size;
+#ifdef ML_GENERICS
+		ml_map_update_type(Map, Node->Key, Node->Value);
+#endif
+	}
+	Map->Tail = Prev;
+	// Sorting by hash (then key) and splitting at the middle gives a balanced tree without any rotations.
+	ml_map_node_t **Sorted = anew(ml_map_node_t *, Size);
+	memcpy(Sorted, Nodes, Size * sizeof(ml_map_node_t *));
+	qsort(Sorted, Size, sizeof(ml_map_node_t *), ml_map_node_compare);
+	Map->Root = ml_map_build(Sorted, Size);
+	return (ml_value_t *)Map;
+}
+
 static void ml_map_remove_depth_helper(ml_map_node_t *Node) {
 	if (Node) {
 		ml_map_remove_depth_helper(Node->Right);
@@ -536,6 +616,39 @@ static void ML_TYPED_FN(ml_iterate, MLMapT, ml_state_t *Caller, ml_map_t *Map) {
 	ML_RETURN((ml_value_t *)Map->Head ?: MLNil);
 }
 
+static int ML_TYPED_FN(ml_iter_block, MLMapT, ml_map_t *Map, ml_iter_cursor_t *Cursor, ml_value_t **Keys, ml_value_t **Values, int Size) {
+	ml_map_node_t *Node = Cursor->Index ? Cursor->Node : Map->Head;
+	int Count = 0;
+	while (Node && Count < Size) {
+		if (Keys) Keys[Count] = Node->Key;
+		if (Values) Values[Count] = (ml_value_t *)Node;
+		++Count;
+		Node = Node->Next;
+	}
+	Cursor->Node = Node;
+	Cursor->Index += Count;
+	return Count;
+}
+
+static long ML_TYPED_FN(ml_iter_seek, MLMapT, ml_map_t *Map, ml_iter_cursor_t *Cursor, long Index) {
+	if (Index >= Map->Size) {
+		Cursor->Node = NULL;
+		Cursor->Index = Map->Size;
+	} else if (Index > 0) {
+		ml_map_node_t *Node;
+		if (2 * Index < Map->Size) {
+			Node = Map->Head;
+			for (long I = Index; --I >= 0;) Node = Node->Next;
+		} else {
+			Node = Map->Tail;
+			for (long I = Map->Size - 1 - Index; --I >= 0;) Node = Node->Prev;
+		}
+		Cursor->Node = Node;
+		Cursor->Index = Index;
+	}
+	return Map->Size;
+}
+
 ML_METHOD("+", MLMapT, MLMapT) {
 //<Map/1
 //<Map/2
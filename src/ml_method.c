@@ -23,7 +23,7 @@ struct ml_methods_t {
 
 static void ml_methods_call(ml_state_t *Caller, ml_methods_t *Methods, int Count, ml_value_t **Args) {
 	ml_state_t *State = ml_state_new(Caller);
-	State->Context->Values[ML_METHODS_INDEX] = Methods;
+	ml_context_set(State->Context, ML_METHODS_INDEX, Methods);
 	ml_value_t *Function = Args[0];
 	return ml_call(State, Function, Count - 1, Args + 1);
 }
@@ -49,7 +49,7 @@ ml_methods_t *ml_methods_context_new(ml_context_t *Context) {
 #ifdef ML_THREADSAFE
 	Methods->Lock[0] = (atomic_flag)ATOMIC_FLAG_INIT;
 #endif
-	Context->Values[ML_METHODS_INDEX] = Methods;
+	ml_context_set(Context, ML_METHODS_INDEX, Methods);
 	return Methods;
 }
 
@@ -12,6 +12,7 @@ struct ml_queue_node_t {
 	ml_queue_t *Queue;
 	ml_value_t *Value;
 	double Score;
+	long Order;
 	int Index;
 };
 
@@ -20,11 +21,13 @@ ML_TYPE(MLQueueNodeT, (), "queue-node");
 struct ml_queue_t {
 	ml_type_t *Type;
 	ml_queue_node_t **Nodes;
+	long Order;
 	int Count, Size;
 };
 
 ML_TYPE(MLQueueT, (MLSequenceT), "queue");
 // A priority queue with values and associated scores.
+// Values with equal scores are produced in the order they were inserted.
 
 ML_METHOD(MLQueueT) {
 	ml_queue_t *Queue = new(ml_queue_t);
@@ -34,13 +37,19 @@ ML_METHOD(MLQueueT) {
 	return (ml_value_t *)Queue;
 }
 
+static inline int ml_queue_higher(ml_queue_node_t *A, ml_queue_node_t *B) {
+	if (A->Score > B->Score) return 1;
+	if (A->Score < B->Score) return 0;
+	return A->Order < B->Order;
+}
+
 static void ml_queue_up(ml_queue_t *Queue, ml_queue_node_t *Node) {
 	ml_queue_node_t **Nodes = Queue->Nodes;
 	int Index = Node->Index;
 	while (Index > 0) {
 		int ParentIndex = (Index - 1) / 2;
 		ml_queue_node_t *Parent = Nodes[ParentIndex];
-		if (Parent->Score >= Node->Score) {
+		if (!ml_queue_higher(Node, Parent)) {
 			Node->Index = Index;
 			return;
 		}
@@ -61,10 +70,10 @@ static void ml_queue_down(ml_queue_t *Queue, ml_queue_node_t *Node) {
 		int Right = 2 * Index + 2;
 		int Largest = Index;
 		Nodes[Index] = Node;
-		if (Left < Count && Nodes[Left] && Nodes[Left]->Score > Nodes[Largest]->Score) {
+		if (Left < Count && Nodes[Left] && ml_queue_higher(Nodes[Left], Nodes[Largest])) {
 			Largest = Left;
 		}
-		if (Right < Count && Nodes[Right] && Nodes[Right]->Score > Nodes[Largest]->Score) {
+		if (Right < Count && Nodes[Right] && ml_queue_higher(Nodes[Right], Nodes[Largest])) {
 			Largest = Right;
 		}
 		if (Largest != Index) {
@@ -98,21 +107,28 @@ ML_METHOD("insert", MLQueueT, MLAnyT, MLNumberT) {
 	Node->Queue = Queue;
 	Node->Value = Args[1];
 	Node->Score = ml_real_value(Args[2]);
+	Node->Order = ++Queue->Order;
 	ml_queue_insert(Queue, Node);
 	return (ml_value_t *)Node;
 }
 
-ML_METHOD("next", MLQueueT) {
-	ml_queue_t *Queue = (ml_queue_t *)Args[0];
-	if (!Queue->Count) return MLNil;
+static ml_queue_node_t *ml_queue_next(ml_queue_t *Queue) {
 	ml_queue_node_t *Next = Queue->Nodes[0];
 	ml_queue_node_t *Node = Queue->Nodes[--Queue->Count];
 	Queue->Nodes[Queue->Count] = NULL;
-	Queue->Nodes[0] = Node;
-	Node->Index = 0;
-	ml_queue_down(Queue, Node);
+	if (Node != Next) {
+		Queue->Nodes[0] = Node;
+		Node->Index = 0;
+		ml_queue_down(Queue, Node);
+	}
 	Next->Index = INT_MAX;
-	return (ml_value_t *)Next;
+	return Next;
+}
+
+ML_METHOD("next", MLQueueT) {
+	ml_queue_t *Queue = (ml_queue_t *)Args[0];
+	if (!Queue->Count) return MLNil;
+	return (ml_value_t *)ml_queue_next(Queue);
 }
 
 ML_METHOD("count", MLQueueT) {
@@ -131,6 +147,7 @@ ML_METHOD("update", MLQueueNodeT, MLNumberT) {
 	ml_queue_t *Queue = Node->Queue;
 	if (Node->Index == INT_MAX) {
 		Node->Score = Score;
+		Node->Order = ++Queue->Order;
 		ml_queue_insert(Queue, Node);
 	} else if (Score < Node->Score) {
 		Node->Score = Score;
@@ -148,12 +165,15 @@ ML_METHOD("remove", MLQueueNodeT) {
 	ml_queue_t *Queue = Node->Queue;
 	ml_queue_node_t *Next = Queue->Nodes[--Queue->Count];
 	Queue->Nodes[Queue->Count] = NULL;
-	int Index = Next->Index = Node->Index;
+	int Index = Node->Index;
+	Node->Index = INT_MAX;
+	if (Next == Node) return Args[0];
+	Next->Index = Index;
 	Queue->Nodes[Index] = Next;
-	if (Node->Score < Next->Score) {
-		ml_queue_down(Queue, Next);
-	} else if (Node->Score > Next->Score) {
+	if (ml_queue_higher(Next, Node)) {
 		ml_queue_up(Queue, Next);
+	} else {
+		ml_queue_down(Queue, Next);
 	}
 	return Args[0];
 }
@@ -174,6 +194,129 @@ ml_value_t *ML_TYPED_FN(ml_unpack, MLQueueNodeT, ml_queue_node_t *Node, int Inde
 	return MLNil;
 }
 
+typedef struct {
+	ml_state_t Base;
+	ml_value_t *Iter, *Score, *Value;
+	ml_value_t *Args[1];
+	ml_queue_t Queue[1];
+	double Sign;
+	long Index;
+	int Limit;
+} ml_queue_select_t;
+
+static void ml_queue_select_iterate(ml_queue_select_t *State, ml_value_t *Value);
+
+static void ml_queue_select_score(ml_queue_select_t *State, ml_value_t *Value) {
+	Value = ml_deref(Value);
+	if (ml_is_error(Value)) ML_CONTINUE(State->Base.Caller, Value);
+	if (!ml_is(Value, MLNumberT)) {
+		ML_CONTINUE(State->Base.Caller, ml_error("TypeError", "Expected number for score not %s", ml_typeof(Value)->Name));
+	}
+	// The heap keeps the worst selected value at the root: lowest score first, then latest.
+	ml_queue_t *Queue = State->Queue;
+	double Score = State->Sign * ml_real_value(Value);
+	long Order = -(++State->Index);
+	ml_queue_node_t *Node;
+	if (Queue->Count < State->Limit) {
+		Node = new(ml_queue_node_t);
+		Node->Type = MLQueueNodeT;
+		Node->Queue = Queue;
+		Node->Value = State->Value;
+		Node->Score = Score;
+		Node->Order = Order;
+		ml_queue_insert(Queue, Node);
+	} else if ((Node = Queue->Nodes[0])->Score > Score) {
+		Node->Value = State->Value;
+		Node->Score = Score;
+		Node->Order = Order;
+		ml_queue_down(Queue, Node);
+	}
+	State->Base.run = (void *)ml_queue_select_iterate;
+	return ml_iter_next((ml_state_t *)State, State->Iter);
+}
+
+static void ml_queue_select_value(ml_queue_select_t *State, ml_value_t *Value) {
+	Value = ml_deref(Value);
+	if (ml_is_error(Value)) ML_CONTINUE(State->Base.Caller, Value);
+	State->Value = Value;
+	if (State->Score) {
+		State->Base.run = (void *)ml_queue_select_score;
+		State->Args[0] = Value;
+		return ml_call(State, State->Score, 1, State->Args);
+	}
+	return ml_queue_select_score(State, Value);
+}
+
+static void ml_queue_select_iterate(ml_queue_select_t *State, ml_value_t *Value) {
+	if (ml_is_error(Value)) ML_CONTINUE(State->Base.Caller, Value);
+	if (Value == MLNil) {
+		ml_queue_t *Queue = State->Queue;
+		int Count = Queue->Count;
+		ml_value_t **Values = anew(ml_value_t *, Count);
+		for (int I = Count; --I >= 0;) Values[I] = ml_queue_next(Queue)->Value;
+		ml_value_t *List = ml_list();
+		for (int I = 0; I < Count; ++I) ml_list_put(List, Values[I]);
+		ML_CONTINUE(State->Base.Caller, List);
+	}
+	State->Base.run = (void *)ml_queue_select_value;
+	return ml_iter_value((ml_state_t *)State, State->Iter = Value);
+}
+
+static void ml_queue_select(ml_state_t *Caller, ml_value_t *Sequence, long Limit, ml_value_t *Score, double Sign) {
+	if (Limit <= 0) ML_RETURN(ml_list());
+	if (Limit > INT_MAX) Limit = INT_MAX;
+	ml_queue_select_t *State = new(ml_queue_select_t);
+	State->Base.Caller = Caller;
+	State->Base.run = (void *)ml_queue_select_iterate;
+	State->Base.Context = Caller->Context;
+	State->Score = Score;
+	State->Sign = Sign;
+	State->Limit = Limit;
+	ml_queue_t *Queue = State->Queue;
+	Queue->Type = MLQueueT;
+	Queue->Size = Limit < 16 ? Limit : 16;
+	Queue->Nodes = anew(ml_queue_node_t *, Queue->Size);
+	return ml_iterate((ml_state_t *)State, Sequence);
+}
+
+ML_METHODX("top", MLSequenceT, MLIntegerT) {
+//<Sequence
+//<K
+//>list
+// Returns a list of the :mini:`K` largest values produced by :mini:`Sequence` in descending order, using a bounded heap. Equal values keep the order they were produced in.
+// The values are compared as scores, so they must be numbers. Use the :mini:`Score` form to select other values.
+	return ml_queue_select(Caller, Args[0], ml_integer_value(Args[1]), NULL, -1);
+}
+
+ML_METHODX("top", MLSequenceT, MLIntegerT, MLFunctionT) {
+//<Sequence
+//<K
+//<Score
+//>list
+// Returns a list of the :mini:`K` values produced by :mini:`Sequence` with the largest :mini:`Score(Value)` in descending order of score. Values with equal scores keep the order they were produced in.
+// Scores must be numbers.
+	return ml_queue_select(Caller, Args[0], ml_integer_value(Args[1]), Args[2], -1);
+}
+
+ML_METHODX("bottom", MLSequenceT, MLIntegerT) {
+//<Sequence
+//<K
+//>list
+// Returns a list of the :mini:`K` smallest values produced by :mini:`Sequence` in ascending order, using a bounded heap. Equal values keep the order they were produced in.
+// The values are compared as scores, so they must be numbers. Use the :mini:`Score` form to select other values.
+	return ml_queue_select(Caller, Args[0], ml_integer_value(Args[1]), NULL, 1);
+}
+
+ML_METHODX("bottom", MLSequenceT, MLIntegerT, MLFunctionT) {
+//<Sequence
+//<K
+//<Score
+//>list
+// Returns a list of the :mini:`K` values produced by :mini:`Sequence` with the smallest :mini:`Score(Value)` in ascending order of score. Values with equal scores keep the order they were produced in.
+// Scores must be numbers.
+	return ml_queue_select(Caller, Args[0], ml_integer_value(Args[1]), Args[2], 1);
+}
+
 typedef struct {
 	ml_type_t *Type;
 	ml_queue_node_t **Nodes;
@@ -8,6 +8,17 @@
 #include <inttypes.h>
 #include "ml_types.h"
 
+#include <time.h>
+#include <math.h>
+
+#if defined(ML_SCHEDULER) || defined(ML_THREADSAFE)
+#include <pthread.h>
+#endif
+
+#ifdef ML_SCHEDULER
+#include <errno.h>
+#endif
+
 // Runtime //
 
 #ifndef ML_THREADSAFE
@@ -16,13 +27,16 @@ ml_value_t *MLArgCache[ML_ARG_CACHE_SIZE];
 
 #endif
 
-static int MLContextSize = 5;
+static int MLContextSize = 8;
 // Reserved context slots:
 //  0: Method Table
 //  1: Context variables
 //  2: Debugger
 //	3: Scheduler
 //	4: Module Path
+//	5: Cancellation token
+//	6: Scheduler priority
+//	7: Quota
 
 static unsigned int DefaultCounter = UINT_MAX;
 
@@ -35,18 +49,37 @@ static ml_schedule_t default_scheduler(ml_context_t *Context) {
 	return (ml_schedule_t){&DefaultCounter, default_swap};
 }
 
-ml_context_t MLRootContext = {&MLRootContext, 4, {
+static void *MLRootValues[4] = {
 	NULL,
 	NULL,
 	NULL,
 	default_scheduler
-}};
+};
 
-ml_context_t *ml_context_new(ml_context_t *Parent) {
-	ml_context_t *Context = xnew(ml_context_t, MLContextSize, void *);
+ml_context_t MLRootContext = {&MLRootContext, MLRootValues, 4, 0};
+
+// A context is only marked as shared by the thread creating a child, which may not be the thread that changes it.
+// The new context is marked before it is returned, the parent is marked atomically so that its next change copies its slots first.
+
+#ifdef ML_THREADSAFE
+#define ML_CONTEXT_SHARED(CONTEXT) __atomic_load_n(&(CONTEXT)->Shared, __ATOMIC_ACQUIRE)
+#define ML_CONTEXT_SHARE(CONTEXT) __atomic_store_n(&(CONTEXT)->Shared, 1, __ATOMIC_RELEASE)
+#else
+#define ML_CONTEXT_SHARED(CONTEXT) (CONTEXT)->Shared
+#define ML_CONTEXT_SHARE(CONTEXT) (CONTEXT)->Shared = 1
+#endif
+
+static inline void ml_context_share(ml_context_t *Context, ml_context_t *Parent) {
 	Context->Parent = Parent;
-	Context->Size = MLContextSize;
-	for (int I = 0; I < Parent->Size; ++I) Context->Values[I] = Parent->Values[I];
+	Context->Values = Parent->Values;
+	Context->Size = Parent->Size;
+	Context->Shared = 1;
+	if (!ML_CONTEXT_SHARED(Parent)) ML_CONTEXT_SHARE(Parent);
+}
+
+ml_context_t *ml_context_new(ml_context_t *Parent) {
+	ml_context_t *Context = new(ml_context_t);
+	ml_context_share(Context, Parent);
 	return Context;
 }
 
@@ -55,7 +88,15 @@ int ml_context_index_new() {
 }
 
 void ml_context_set(ml_context_t *Context, int Index, void *Value) {
-	if (Context->Size <= Index) return;
+	if (Index >= MLContextSize) return;
+	if (Index < Context->Size && Context->Values[Index] == Value) return;
+	if (ML_CONTEXT_SHARED(Context) || Context->Size <= Index) {
+		void **Values = anew(void *, MLContextSize);
+		memcpy(Values, Context->Values, Context->Size * sizeof(void *));
+		Context->Values = Values;
+		Context->Size = MLContextSize;
+		Context->Shared = 0;
+	}
 	Context->Values[Index] = Value;
 }
 
@@ -78,6 +119,7 @@ static void ml_context_key_call(ml_state_t *Caller, ml_context_key_t *Key, int C
 	if (Count == 0) {
 		while (Values) {
 			if (Values->Key == Key) ML_RETURN(Values->Value);
+			Values = Values->Prev;
 		}
 		ML_RETURN(MLNil);
 	} else if (Count == 1) {
@@ -177,7 +219,11 @@ ml_result_state_t *ml_result_state_new(ml_context_t *Context) {
 }
 
 ml_value_t *ml_simple_call(ml_value_t *Value, int Count, ml_value_t **Args) {
+#ifdef ML_THREADSAFE
+	static __thread ml_result_state_t State = {{MLStateT, NULL, (void *)ml_result_state_run, &MLRootContext}, MLNil};
+#else
 	static ml_result_state_t State = {{MLStateT, NULL, (void *)ml_result_state_run, &MLRootContext}, MLNil};
+#endif
 	ml_call(&State, Value, Count, Args);
 	ml_value_t *Result = State.Value;
 	State.Value = MLNil;
@@ -190,11 +236,8 @@ typedef struct {
 } ml_context_state_t;
 
 ml_state_t *ml_state_new(ml_state_t *Caller) {
-	ml_context_state_t *State = xnew(ml_context_state_t, MLContextSize, void *);
-	ml_context_t *Parent = Caller->Context;
-	State->Context->Parent = Parent;
-	State->Context->Size = MLContextSize;
-	for (int I = 0; I < Parent->Size; ++I) State->Context->Values[I] = Parent->Values[I];
+	ml_context_state_t *State = new(ml_context_state_t);
+	ml_context_share(State->Context, Caller->Context);
 	State->Base.Caller = Caller;
 	State->Base.run = ml_default_state_run;
 	State->Base.Context = State->Context;
@@ -826,48 +869,1003 @@ ML_METHOD("source", MLStateT) {
 	return Location;
 }
 
+// Cancellation //
+
+static uint64_t ml_timer_now() {
+	struct timespec Time;
+	clock_gettime(CLOCK_MONOTONIC, &Time);
+	return Time.tv_sec * 1000 + Time.tv_nsec / 1000000;
+}
+
+#define ML_CANCEL_CHECK_INTERVAL 10000
+
+typedef struct ml_cancel_t ml_cancel_t;
+
+struct ml_cancel_t {
+	ml_type_t *Type;
+	ml_cancel_t *Parent;
+	const char *Message;
+	uint64_t Deadline;
+	int Cancelled;
+};
+
+static ml_value_t *ml_cancel_token_check(ml_cancel_t *Cancel) {
+	uint64_t Now = 0;
+	do {
+		if (__atomic_load_n(&Cancel->Cancelled, __ATOMIC_ACQUIRE)) return ml_error("CancelError", "%s", Cancel->Message);
+		if (Cancel->Deadline) {
+			if (!Now) Now = ml_timer_now();
+			if (Now >= Cancel->Deadline) return ml_error("DeadlineError", "Deadline exceeded");
+		}
+	} while ((Cancel = Cancel->Parent));
+	return NULL;
+}
+
+ml_value_t *ml_cancel_check(ml_context_t *Context) {
+	ml_cancel_t *Cancel = ml_context_get(Context, ML_CANCEL_INDEX);
+	return Cancel ? ml_cancel_token_check(Cancel) : NULL;
+}
+
+uint64_t ml_cancel_remaining(ml_context_t *Context) {
+	uint64_t Deadline = UINT64_MAX;
+	for (ml_cancel_t *Cancel = ml_context_get(Context, ML_CANCEL_INDEX); Cancel; Cancel = Cancel->Parent) {
+		if (__atomic_load_n(&Cancel->Cancelled, __ATOMIC_ACQUIRE)) return 0;
+		if (Cancel->Deadline && Cancel->Deadline < Deadline) Deadline = Cancel->Deadline;
+	}
+	if (Deadline == UINT64_MAX) return Deadline;
+	uint64_t Now = ml_timer_now();
+	return Deadline > Now ? Deadline - Now : 0;
+}
+
+static ml_cancel_t *ml_cancel_new(ml_context_t *Context, uint64_t Deadline) {
+	ml_cancel_t *Cancel = new(ml_cancel_t);
+	Cancel->Type = MLCancelT;
+	Cancel->Parent = ml_context_get(Context, ML_CANCEL_INDEX);
+	Cancel->Message = "Cancelled";
+	Cancel->Deadline = Deadline;
+	return Cancel;
+}
+
+#ifdef ML_SCHEDULER
+
+typedef struct {
+	ml_state_t Base;
+	unsigned int *Counter;
+	ml_context_t Context[1];
+} ml_cancel_state_t;
+
+static void ml_cancel_state_run(ml_cancel_state_t *State, ml_value_t *Value) {
+	ml_scheduler_preempt_remove(State->Counter, ML_CANCEL_CHECK_INTERVAL);
+	ML_CONTINUE(State->Base.Caller, Value);
+}
+
+#endif
+
+static void ml_cancel_run(ml_state_t *Caller, ml_cancel_t *Cancel, ml_value_t *Function, int Count, ml_value_t **Args) {
+	ml_value_t *Error = ml_cancel_token_check(Cancel);
+	if (Error) ML_RETURN(Error);
+#ifdef ML_SCHEDULER
+	// Make sure loops that never suspend still reach a swap, and so a cancellation check, regularly.
+	// The timer is only registered until Function returns, it does not change how often other work is preempted.
+	ml_scheduler_t Scheduler = (ml_scheduler_t)ml_context_get(Caller->Context, ML_SCHEDULER_INDEX);
+	if (Scheduler) {
+		ml_cancel_state_t *State = xnew(ml_cancel_state_t, MLContextSize, void *);
+		ml_context_share(State->Context, Caller->Context);
+		ml_context_set(State->Context, ML_CANCEL_INDEX, Cancel);
+		State->Base.Caller = Caller;
+		State->Base.run = (ml_state_fn)ml_cancel_state_run;
+		State->Base.Context = State->Context;
+		State->Counter = Scheduler(Caller->Context).Counter;
+		ml_scheduler_preempt(State->Counter, ML_CANCEL_CHECK_INTERVAL);
+		return ml_call(State, ml_deref(Function), Count, Args);
+	}
+#endif
+	ml_state_t *State = ml_state_new(Caller);
+	ml_context_set(State->Context, ML_CANCEL_INDEX, Cancel);
+	return ml_call(State, ml_deref(Function), Count, Args);
+}
+
+static void ml_cancel_call(ml_state_t *Caller, ml_cancel_t *Cancel, int Count, ml_value_t **Args) {
+	ML_CHECKX_ARG_COUNT(1);
+	return ml_cancel_run(Caller, Cancel, Args[0], Count - 1, Args + 1);
+}
+
+ML_FUNCTIONX(MLCancel) {
+//!cancel
+//@cancel
+//>cancel
+// Creates a new cancellation token.
+// The new token is also cancelled when the token of the current context (if any) is cancelled or reaches its deadline.
+	ML_RETURN(ml_cancel_new(Caller->Context, 0));
+}
+
+ML_TYPE(MLCancelT, (MLFunctionT), "cancel",
+//!cancel
+// A cancellation token.
+// If :mini:`token` is a cancellation token, then calling :mini:`token(Function, Args...)` will invoke :mini:`Function(Args...)` in a new context carrying :mini:`token`.
+// Once :mini:`token` is cancelled, any work in that context returns a :mini:`CancelError` at its next suspension point, channel or semaphore operation, task launch or stream operation.
+	.call = (void *)ml_cancel_call,
+	.Constructor = (ml_value_t *)MLCancel
+);
+
+ML_METHOD("cancel", MLCancelT) {
+//!cancel
+//<Token
+//>cancel
+// Cancels :mini:`Token`.
+	ml_cancel_t *Cancel = (ml_cancel_t *)Args[0];
+	__atomic_store_n(&Cancel->Cancelled, 1, __ATOMIC_RELEASE);
+	return Args[0];
+}
+
+ML_METHOD("cancel", MLCancelT, MLStringT) {
+//!cancel
+//<Token
+//<Message
+//>cancel
+// Cancels :mini:`Token`, using :mini:`Message` as the message of subsequent :mini:`CancelError`\ s.
+	ml_cancel_t *Cancel = (ml_cancel_t *)Args[0];
+	if (!__atomic_load_n(&Cancel->Cancelled, __ATOMIC_ACQUIRE)) {
+		Cancel->Message = ml_string_value(Args[1]);
+		__atomic_store_n(&Cancel->Cancelled, 1, __ATOMIC_RELEASE);
+	}
+	return Args[0];
+}
+
+ML_METHOD("cancelled", MLCancelT) {
+//!cancel
+//<Token
+//>cancel | nil
+// Returns :mini:`Token` if it (or a token it was created under) has been cancelled or has reached its deadline, otherwise returns :mini:`nil`.
+	ml_cancel_t *Cancel = (ml_cancel_t *)Args[0];
+	return ml_cancel_token_check(Cancel) ? Args[0] : MLNil;
+}
+
+ML_FUNCTIONX(MLDeadline) {
+//@deadline
+//<Duration:number
+//<Function:function
+//<Args:any
+//>any | error
+// Calls :mini:`Function(Args...)` in a new context with a cancellation token that expires after :mini:`Duration` seconds.
+// Work started by :mini:`Function` (including tasks) returns a :mini:`DeadlineError` at its next check after the deadline passes.
+// Nested deadlines can only shorten the deadline of the current context.
+	ML_CHECKX_ARG_COUNT(2);
+	ML_CHECKX_ARG_TYPE(0, MLNumberT);
+	double Duration = ml_real_value(Args[0]);
+	uint64_t Deadline = ml_timer_now() + (Duration > 0 ? (uint64_t)ceil(Duration * 1000) : 0);
+	return ml_cancel_run(Caller, ml_cancel_new(Caller->Context, Deadline ?: 1), Args[1], Count - 2, Args + 2);
+}
+
+// Quotas //
+
+#ifdef ML_SCHEDULER
+
+// Frames running under a quota use a scheduler whose counter is refilled with at most ML_QUOTA_SLICE checks at a time.
+// Each swap charges the slice to the quota (and the quotas it was created under) before passing the state to the underlying scheduler.
+// Allocations are measured with GC_get_total_bytes() between the resumption of a quota's state and its next swap,
+// in ML_THREADSAFE builds this also includes allocations made concurrently by other threads.
+
+#define ML_QUOTA_SLICE 1000
+
+typedef struct ml_quota_t ml_quota_t;
+
+struct ml_quota_t {
+	ml_type_t *Type;
+	ml_quota_t *Parent;
+	ml_scheduler_t Scheduler;
+	const char *Exceeded;
+	uint64_t Instructions, InstructionLimit;
+	uint64_t Start, TimeLimit;
+	size_t Bytes, ByteLimit;
+	unsigned int Counter, Slice;
+};
+
+#ifdef ML_THREADSAFE
+static __thread ml_quota_t *QuotaOwner = NULL;
+static __thread size_t QuotaMark = 0;
+#else
+static ml_quota_t *QuotaOwner = NULL;
+static size_t QuotaMark = 0;
+#endif
+
+static void ml_quota_charge(ml_quota_t *Quota, uint64_t Instructions) {
+	size_t Bytes = 0;
+	if (QuotaOwner == Quota) {
+		size_t Mark = GC_get_total_bytes();
+		Bytes = Mark - QuotaMark;
+		QuotaMark = Mark;
+	}
+	do {
+		__atomic_add_fetch(&Quota->Instructions, Instructions, __ATOMIC_RELAXED);
+		__atomic_add_fetch(&Quota->Bytes, Bytes, __ATOMIC_RELAXED);
+	} while ((Quota = Quota->Parent));
+}
+
+static ml_value_t *ml_quota_exceeded(ml_quota_t *Quota) {
+	uint64_t Now = 0;
+	do {
+		if (!Quota->Exceeded) {
+			if (Quota->InstructionLimit && __atomic_load_n(&Quota->Instructions, __ATOMIC_RELAXED) >= Quota->InstructionLimit) {
+				Quota->Exceeded = "Instruction quota exceeded";
+			} else if (Quota->ByteLimit && __atomic_load_n(&Quota->Bytes, __ATOMIC_RELAXED) >= Quota->ByteLimit) {
+				Quota->Exceeded = "Memory quota exceeded";
+			} else if (Quota->TimeLimit && Quota->Start) {
+				if (!Now) Now = ml_timer_now();
+				if (Now - Quota->Start >= Quota->TimeLimit) Quota->Exceeded = "Time quota exceeded";
+			}
+		}
+		if (Quota->Exceeded) return ml_error("QuotaError", "%s", Quota->Exceeded);
+	} while ((Quota = Quota->Parent));
+	return NULL;
+}
+
+ml_value_t *ml_quota_check(ml_context_t *Context) {
+	ml_quota_t *Quota = ml_context_get(Context, ML_QUOTA_INDEX);
+	return Quota ? ml_quota_exceeded(Quota) : NULL;
+}
+
+static void ml_quota_refill(ml_quota_t *Quota) {
+	uint64_t Slice = ML_QUOTA_SLICE;
+	for (ml_quota_t *Limit = Quota; Limit; Limit = Limit->Parent) {
+		if (!Limit->InstructionLimit) continue;
+		uint64_t Used = __atomic_load_n(&Limit->Instructions, __ATOMIC_RELAXED);
+		uint64_t Remaining = Used < Limit->InstructionLimit ? Limit->InstructionLimit - Used : 1;
+		if (Slice > Remaining) Slice = Remaining;
+	}
+	Quota->Counter = Quota->Slice = Slice;
+}
+
+static void ml_quota_resume(ml_state_t *State, ml_value_t *Value) {
+	QuotaOwner = ml_context_get(State->Context, ML_QUOTA_INDEX);
+	QuotaMark = GC_get_total_bytes();
+	ml_state_t *Caller = State->Caller;
+	return Caller->run(Caller, Value);
+}
+
+static void ml_quota_swap(ml_state_t *State, ml_value_t *Value) {
+	ml_quota_t *Quota = ml_context_get(State->Context, ML_QUOTA_INDEX);
+	ml_quota_charge(Quota, Quota->Slice);
+	QuotaOwner = NULL;
+	ml_value_t *Error = ml_quota_exceeded(Quota);
+	ml_quota_refill(Quota);
+	ml_state_t *Resume = ml_state_new(State);
+	Resume->run = ml_quota_resume;
+	// As with cancellation, a frame that exceeds its quota still yields and then resumes with the error.
+	return Quota->Scheduler(State->Context).swap(Resume, ml_is_error(Value) ? Value : Error ?: Value);
+}
+
+static ml_schedule_t ml_quota_scheduler(ml_context_t *Context) {
+	ml_quota_t *Quota = ml_context_get(Context, ML_QUOTA_INDEX);
+	return (ml_schedule_t){&Quota->Counter, ml_quota_swap};
+}
+
+ml_quota_t *ml_quota_new(ml_context_t *Context, uint64_t Instructions, double Seconds, size_t Bytes) {
+	ml_quota_t *Quota = new(ml_quota_t);
+	Quota->Type = MLQuotaT;
+	Quota->Parent = ml_context_get(Context, ML_QUOTA_INDEX);
+	Quota->InstructionLimit = Instructions;
+	Quota->TimeLimit = Seconds > 0 ? (uint64_t)ceil(Seconds * 1000) : 0;
+	Quota->ByteLimit = Bytes;
+	return Quota;
+}
+
+static void ml_quota_finish(ml_state_t *State, ml_value_t *Value) {
+	ml_quota_t *Quota = ml_context_get(State->Context, ML_QUOTA_INDEX);
+	ml_quota_charge(Quota, Quota->Slice - Quota->Counter);
+	Quota->Slice = Quota->Counter;
+	QuotaOwner = Quota->Parent;
+	ml_state_t *Caller = State->Caller;
+	ML_RETURN(Value);
+}
+
+void ml_quota_call(ml_state_t *Caller, ml_quota_t *Quota, ml_value_t *Function, int Count, ml_value_t **Args) {
+	if (!Quota->Start) Quota->Start = ml_timer_now();
+	ml_value_t *Error = ml_quota_exceeded(Quota);
+	if (Error) ML_RETURN(Error);
+	ml_scheduler_t Scheduler = (ml_scheduler_t)ml_context_get(Caller->Context, ML_SCHEDULER_INDEX);
+	if (Scheduler == ml_quota_scheduler) Scheduler = ((ml_quota_t *)ml_context_get(Caller->Context, ML_QUOTA_INDEX))->Scheduler;
+	Quota->Scheduler = Scheduler;
+	ml_quota_refill(Quota);
+	ml_state_t *State = ml_state_new(Caller);
+	State->run = ml_quota_finish;
+	ml_context_set(State->Context, ML_QUOTA_INDEX, Quota);
+	ml_context_set(State->Context, ML_SCHEDULER_INDEX, ml_quota_scheduler);
+	QuotaOwner = Quota;
+	QuotaMark = GC_get_total_bytes();
+	return ml_call(State, ml_deref(Function), Count, Args);
+}
+
+static void ml_quota_call_fn(ml_state_t *Caller, ml_quota_t *Quota, int Count, ml_value_t **Args) {
+	ML_CHECKX_ARG_COUNT(1);
+	return ml_quota_call(Caller, Quota, Args[0], Count - 1, Args + 1);
+}
+
+ML_FUNCTIONX(MLQuota) {
+//!quota
+//@quota
+//<Limits:map
+//>quota
+// Creates a new quota with the limits in :mini:`Limits`, which can contain the following keys (all optional).
+//
+// * :mini:`"instructions"`: the maximum number of calls and jumps executed.
+// * :mini:`"time"`: the maximum wall-clock time in seconds, measured from the first use of the quota.
+// * :mini:`"memory"`: the maximum number of bytes allocated.
+//
+// Usage under the new quota is also charged to the quota of the current context (if any).
+	ML_CHECKX_ARG_COUNT(1);
+	ML_CHECKX_ARG_TYPE(0, MLMapT);
+	uint64_t Instructions = 0, Bytes = 0;
+	double Seconds = 0;
+	ML_MAP_FOREACH(Args[0], Iter) {
+		if (!ml_is(Iter->Key, MLStringT)) ML_ERROR("TypeError", "Quota limit must be a string");
+		const char *Limit = ml_string_value(Iter->Key);
+		if (!strcmp(Limit, "time")) {
+			if (!ml_is(Iter->Value, MLNumberT)) ML_ERROR("TypeError", "Time limit must be a number");
+			Seconds = ml_real_value(Iter->Value);
+		} else if (!strcmp(Limit, "instructions") || !strcmp(Limit, "memory")) {
+			if (!ml_is(Iter->Value, MLIntegerT)) ML_ERROR("TypeError", "%s limit must be an integer", Limit);
+			int64_t Value = ml_integer_value(Iter->Value);
+			if (Value <= 0) ML_ERROR("ValueError", "%s limit must be positive", Limit);
+			if (Limit[0] == 'i') Instructions = Value; else Bytes = Value;
+		} else {
+			ML_ERROR("ValueError", "Unknown quota limit %s", Limit);
+		}
+	}
+	ML_RETURN(ml_quota_new(Caller->Context, Instructions, Seconds, Bytes));
+}
+
+ML_TYPE(MLQuotaT, (MLFunctionT), "quota",
+//!quota
+// A quota limiting the instructions, wall-clock time and memory used by code running under it.
+// If :mini:`quota` is a quota, then calling :mini:`quota(Function, Args...)` will invoke :mini:`Function(Args...)` in a new context charged to :mini:`quota`.
+// Once any limit is exceeded, code running under :mini:`quota` (including tasks it started) returns a :mini:`QuotaError` at its next call or jump.
+// A quota keeps its usage across calls and stays exceeded once any limit has been reached.
+	.call = (void *)ml_quota_call_fn,
+	.Constructor = (ml_value_t *)MLQuota
+);
+
+ML_METHOD("instructions", MLQuotaT) {
+//!quota
+//<Quota
+//>integer
+// Returns the number of instructions charged to :mini:`Quota` so far.
+// Instructions are charged in slices at each scheduler check, so this is approximate while code is still running.
+	ml_quota_t *Quota = (ml_quota_t *)Args[0];
+	return ml_integer(__atomic_load_n(&Quota->Instructions, __ATOMIC_RELAXED));
+}
+
+ML_METHOD("memory", MLQuotaT) {
+//!quota
+//<Quota
+//>integer
+// Returns the number of bytes charged to :mini:`Quota` so far.
+	ml_quota_t *Quota = (ml_quota_t *)Args[0];
+	return ml_integer(__atomic_load_n(&Quota->Bytes, __ATOMIC_RELAXED));
+}
+
+ML_METHOD("time", MLQuotaT) {
+//!quota
+//<Quota
+//>real
+// Returns the number of seconds since :mini:`Quota` was first used.
+	ml_quota_t *Quota = (ml_quota_t *)Args[0];
+	if (!Quota->Start) return ml_real(0);
+	return ml_real((ml_timer_now() - Quota->Start) / 1000.0);
+}
+
+ML_METHOD("exceeded", MLQuotaT) {
+//!quota
+//<Quota
+//>quota | nil
+// Returns :mini:`Quota` if it (or a quota it was created under) has exceeded any of its limits, otherwise returns :mini:`nil`.
+	ml_quota_t *Quota = (ml_quota_t *)Args[0];
+	return ml_quota_exceeded(Quota) ? Args[0] : MLNil;
+}
+
+#endif
+
 // Schedulers //
 
 #ifdef ML_SCHEDULER
 
-static struct {
+// Timers are kept in a hierarchical timing wheel with millisecond ticks.
+// A timer is stored at the level of the highest group of bits where its expiry differs from the current tick,
+// and is moved down a level each time the current tick reaches its slot at that level.
+// Slots are kept in insertion order so that timers with the same expiry fire in the order they were added.
+
+#define ML_TIMER_LEVELS 4
+#define ML_TIMER_BITS 6
+#define ML_TIMER_SLOTS (1 << ML_TIMER_BITS)
+#define ML_TIMER_MASK (ML_TIMER_SLOTS - 1)
+
+struct ml_timer_t {
+	ml_timer_t *Next, **Prev;
+	ml_scheduler_queue_t *Queue;
+	ml_state_t *State;
+	ml_value_t *Value;
+	uint64_t Expiry;
+	int Level, Index, Cancelled;
+};
+
+typedef struct {
+	ml_timer_t *Slots[ML_TIMER_LEVELS + 1][ML_TIMER_SLOTS];
+	ml_timer_t **Tails[ML_TIMER_LEVELS + 1][ML_TIMER_SLOTS];
+	int Counts[ML_TIMER_LEVELS + 1];
+	uint64_t Current;
+} ml_timer_wheel_t;
+
+// The scheduler queue keeps a ring buffer per priority level and always runs the highest non-empty level first.
+// To avoid starving background work, the next lower non-empty level is served once after every ML_SCHEDULER_BURST states from above.
+
+#define ML_SCHEDULER_BURST 64
+
+typedef struct {
 	ml_queued_state_t *States;
 	int Size, Fill, Write, Read;
-} SchedulerQueue;
+} ml_scheduler_level_t;
+
+#ifdef ML_THREADSAFE
+
+typedef struct ml_queued_signal_t ml_queued_signal_t;
+
+struct ml_queued_signal_t {
+	ml_queued_signal_t *Next;
+	ml_state_t *State;
+	ml_value_t *Value;
+};
+
+#endif
+
+struct ml_scheduler_queue_t {
+	ml_scheduler_level_t Levels[ML_SCHEDULER_PRIORITIES];
+	ml_timer_wheel_t Timers;
+	ml_scheduler_poller_t *Poller;
+	int Fill, Burst, TimerCount;
+#ifdef ML_THREADSAFE
+	pthread_mutex_t Lock[1];
+	pthread_cond_t Signal[1];
+	ml_queued_signal_t *Inbox, **InboxTail;
+	void (*wakeup)(void *Data);
+	void *Data;
+	int Pending, Signalled, Polling;
+#endif
+};
+
+// Each thread that runs states from a queue has its own queue and timers.
+// Queues are never freed and are allocated uncollectable since thread local storage is not scanned reliably.
+
+#ifdef ML_THREADSAFE
+static __thread ml_scheduler_queue_t *CurrentQueue = NULL;
+#else
+static ml_scheduler_queue_t *CurrentQueue = NULL;
+#endif
 
 void ml_scheduler_queue_init(int Size) {
-	SchedulerQueue.Size = Size;
-	SchedulerQueue.States = anew(ml_queued_state_t, Size);
+	ml_scheduler_queue_t *Queue = GC_MALLOC_UNCOLLECTABLE(sizeof(ml_scheduler_queue_t));
+	for (int I = 0; I < ML_SCHEDULER_PRIORITIES; ++I) {
+		ml_scheduler_level_t *Level = Queue->Levels + I;
+		Level->Size = Size;
+		Level->States = anew(ml_queued_state_t, Size);
+	}
+#ifdef ML_THREADSAFE
+	pthread_mutex_init(Queue->Lock, NULL);
+	pthread_condattr_t Attr;
+	pthread_condattr_init(&Attr);
+	pthread_condattr_setclock(&Attr, CLOCK_MONOTONIC);
+	pthread_cond_init(Queue->Signal, &Attr);
+	pthread_condattr_destroy(&Attr);
+	Queue->InboxTail = &Queue->Inbox;
+#endif
+	CurrentQueue = Queue;
 }
 
+ml_scheduler_queue_t *ml_scheduler_queue_current() {
+	return CurrentQueue;
+}
+
+static void ml_timers_advance(ml_scheduler_queue_t *Queue, uint64_t Now);
+
+static int ml_scheduler_queue_push(ml_scheduler_queue_t *Queue, ml_state_t *State, ml_value_t *Value) {
+	ml_scheduler_level_t *Level = Queue->Levels + ml_scheduler_priority(State->Context);
+	if (++Level->Fill > Level->Size) {
+		int NewQueueSize = Level->Size * 2;
+		ml_queued_state_t *NewQueuedStates = anew(ml_queued_state_t, NewQueueSize);
+		memcpy(NewQueuedStates, Level->States + Level->Read, (Level->Size - Level->Read) * sizeof(ml_queued_state_t));
+		memcpy(NewQueuedStates + Level->Size - Level->Read, Level->States, Level->Read * sizeof(ml_queued_state_t));
+		Level->Read = 0;
+		Level->Write = Level->Size;
+		Level->States = NewQueuedStates;
+		Level->Size = NewQueueSize;
+	}
+	int Write = Level->Write;
+	Level->States[Write] = (ml_queued_state_t){State, Value};
+	Level->Write = (Write + 1) % Level->Size;
+	return ++Queue->Fill;
+}
+
+#ifdef ML_THREADSAFE
+static void ml_scheduler_queue_drain(ml_scheduler_queue_t *Queue);
+#endif
+
 ml_queued_state_t ml_scheduler_queue_next() {
-	if (SchedulerQueue.Fill) {
-		ml_queued_state_t *States = SchedulerQueue.States;
-		int Read = SchedulerQueue.Read;
-		ml_queued_state_t QueuedState = States[Read];
-		States[Read] = (ml_queued_state_t){NULL, NULL};
-		--SchedulerQueue.Fill;
-		SchedulerQueue.Read = (Read + 1) % SchedulerQueue.Size;
-		return QueuedState;
-	} else {
-		return (ml_queued_state_t){NULL, NULL};
+	ml_scheduler_queue_t *Queue = CurrentQueue;
+#ifdef ML_THREADSAFE
+	if (__atomic_load_n(&Queue->Signalled, __ATOMIC_ACQUIRE)) ml_scheduler_queue_drain(Queue);
+#endif
+	if (Queue->TimerCount) ml_timers_advance(Queue, ml_timer_now());
+	if (!Queue->Fill) return (ml_queued_state_t){NULL, NULL};
+	ml_scheduler_level_t *Level = Queue->Levels + ML_SCHEDULER_PRIORITIES - 1;
+	while (!Level->Fill) --Level;
+	if (Level->Fill == Queue->Fill) {
+		Queue->Burst = 0;
+	} else if (++Queue->Burst > ML_SCHEDULER_BURST) {
+		Queue->Burst = 0;
+		do --Level; while (!Level->Fill);
 	}
+	ml_queued_state_t *States = Level->States;
+	int Read = Level->Read;
+	ml_queued_state_t QueuedState = States[Read];
+	States[Read] = (ml_queued_state_t){NULL, NULL};
+	--Level->Fill;
+	--Queue->Fill;
+	Level->Read = (Read + 1) % Level->Size;
+	return QueuedState;
 }
 
 int ml_scheduler_queue_add(ml_state_t *State, ml_value_t *Value) {
-	if (++SchedulerQueue.Fill > SchedulerQueue.Size) {
-		int NewQueueSize = SchedulerQueue.Size * 2;
-		ml_queued_state_t *NewQueuedStates = anew(ml_queued_state_t, NewQueueSize);
-		memcpy(NewQueuedStates, SchedulerQueue.States, SchedulerQueue.Size * sizeof(ml_queued_state_t));
-		SchedulerQueue.Read = 0;
-		SchedulerQueue.Write = SchedulerQueue.Size;
-		SchedulerQueue.States = NewQueuedStates;
-		SchedulerQueue.Size = NewQueueSize;
+	return ml_scheduler_queue_push(CurrentQueue, State, Value);
+}
+
+ML_FUNCTIONX(MLPriority) {
+//@priority
+//<Level?:integer
+//<Function?:function
+//<Args:any
+//>integer | any
+// With no arguments, returns the scheduling priority of the current context.
+// Otherwise calls :mini:`Function(Args...)` in a new context with priority :mini:`Level` (clamped to :mini:`0` .. :mini:`3`), whenever states in that context are queued they run before any queued states with a lower priority.
+// The default priority is :mini:`1`, :mini:`0` is intended for background work.
+	if (!Count) ML_RETURN(ml_integer(ml_scheduler_priority(Caller->Context)));
+	ML_CHECKX_ARG_COUNT(2);
+	ML_CHECKX_ARG_TYPE(0, MLIntegerT);
+	int64_t Priority = ml_integer_value_fast(Args[0]);
+	if (Priority < 0) Priority = 0;
+	if (Priority >= ML_SCHEDULER_PRIORITIES) Priority = ML_SCHEDULER_PRIORITIES - 1;
+	ml_state_t *State = ml_state_new(Caller);
+	ml_context_set(State->Context, ML_PRIORITY_INDEX, (void *)(uintptr_t)(Priority + 1));
+	ml_value_t *Function = ml_deref(Args[1]);
+	return ml_call(State, Function, Count - 2, Args + 2);
+}
+
+static void ml_timer_insert(ml_scheduler_queue_t *Queue, ml_timer_t *Timer) {
+	uint64_t Diff = Timer->Expiry ^ Queue->Timers.Current;
+	int Level = 0;
+	while (Level < ML_TIMER_LEVELS && (Diff >> (ML_TIMER_BITS * (Level + 1)))) ++Level;
+	// Timers beyond the top level are kept in a single overflow slot until the top level wraps.
+	int Index = Level < ML_TIMER_LEVELS ? (Timer->Expiry >> (ML_TIMER_BITS * Level)) & ML_TIMER_MASK : 0;
+	ml_timer_t **Tail = Queue->Timers.Tails[Level][Index] ?: &Queue->Timers.Slots[Level][Index];
+	Timer->Next = NULL;
+	Timer->Prev = Tail;
+	*Tail = Timer;
+	Queue->Timers.Tails[Level][Index] = &Timer->Next;
+	Timer->Level = Level;
+	Timer->Index = Index;
+	++Queue->Timers.Counts[Level];
+}
+
+static void ml_timer_remove(ml_scheduler_queue_t *Queue, ml_timer_t *Timer) {
+	if ((*Timer->Prev = Timer->Next)) {
+		Timer->Next->Prev = Timer->Prev;
+	} else {
+		Queue->Timers.Tails[Timer->Level][Timer->Index] = Timer->Prev;
 	}
-	int Write = SchedulerQueue.Write;
-	SchedulerQueue.States[Write] = (ml_queued_state_t){State, Value};
-	SchedulerQueue.Write = (Write + 1) % SchedulerQueue.Size;
-	return SchedulerQueue.Fill;
+	--Queue->Timers.Counts[Timer->Level];
+	Timer->Level = -1;
+	Timer->Next = NULL;
+	Timer->Prev = NULL;
+	--Queue->TimerCount;
+}
+
+static void ml_timers_advance(ml_scheduler_queue_t *Queue, uint64_t Now) {
+	while (Queue->Timers.Current < Now) {
+		if (!Queue->TimerCount) {
+			Queue->Timers.Current = Now;
+			return;
+		}
+		// Skip straight to the next tick where a timer can fire or move down a level.
+		int Empty = 0;
+		while (Empty < ML_TIMER_LEVELS && !Queue->Timers.Counts[Empty]) ++Empty;
+		if (Empty) {
+			uint64_t Skip = Queue->Timers.Current | ((1ull << (ML_TIMER_BITS * Empty)) - 1);
+			if (Skip >= Now) {
+				Queue->Timers.Current = Now;
+				return;
+			}
+			Queue->Timers.Current = Skip;
+		}
+		uint64_t Tick = ++Queue->Timers.Current;
+		int Top = 0;
+		while (Top < ML_TIMER_LEVELS && !(Tick & ((1ull << (ML_TIMER_BITS * (Top + 1))) - 1))) ++Top;
+		for (int Level = Top; Level > 0; --Level) {
+			int Index = Level < ML_TIMER_LEVELS ? (Tick >> (ML_TIMER_BITS * Level)) & ML_TIMER_MASK : 0;
+			ml_timer_t *Timer = Queue->Timers.Slots[Level][Index];
+			if (!Timer) continue;
+			Queue->Timers.Slots[Level][Index] = NULL;
+			Queue->Timers.Tails[Level][Index] = NULL;
+			while (Timer) {
+				ml_timer_t *Next = Timer->Next;
+				--Queue->Timers.Counts[Level];
+				ml_timer_insert(Queue, Timer);
+				Timer = Next;
+			}
+		}
+		ml_timer_t *Timer = Queue->Timers.Slots[0][Tick & ML_TIMER_MASK];
+		Queue->Timers.Slots[0][Tick & ML_TIMER_MASK] = NULL;
+		Queue->Timers.Tails[0][Tick & ML_TIMER_MASK] = NULL;
+		while (Timer) {
+			ml_timer_t *Next = Timer->Next;
+			--Queue->Timers.Counts[0];
+			--Queue->TimerCount;
+			Timer->Level = -1;
+			Timer->Next = NULL;
+			Timer->Prev = NULL;
+			if (!__atomic_load_n(&Timer->Cancelled, __ATOMIC_ACQUIRE)) ml_scheduler_queue_push(Queue, Timer->State, Timer->Value);
+			Timer = Next;
+		}
+	}
+}
+
+static uint64_t ml_timers_next(ml_scheduler_queue_t *Queue) {
+	uint64_t Current = Queue->Timers.Current;
+	for (int Level = 0; Level < ML_TIMER_LEVELS; ++Level) {
+		if (!Queue->Timers.Counts[Level]) continue;
+		int Shift = ML_TIMER_BITS * Level;
+		int Index = (Current >> Shift) & ML_TIMER_MASK;
+		for (int I = Index + 1; I < ML_TIMER_SLOTS; ++I) {
+			if (Queue->Timers.Slots[Level][I]) {
+				return ((Current >> (Shift + ML_TIMER_BITS)) << (Shift + ML_TIMER_BITS)) + ((uint64_t)I << Shift);
+			}
+		}
+	}
+	return ((Current >> (ML_TIMER_BITS * ML_TIMER_LEVELS)) + 1) << (ML_TIMER_BITS * ML_TIMER_LEVELS);
+}
+
+ml_timer_t *ml_scheduler_timer(ml_state_t *State, ml_value_t *Value, uint64_t Delay) {
+	ml_scheduler_queue_t *Queue = CurrentQueue;
+	if (!Queue) return NULL;
+	ml_timers_advance(Queue, ml_timer_now());
+	ml_timer_t *Timer = new(ml_timer_t);
+	Timer->Queue = Queue;
+	Timer->State = State;
+	Timer->Value = Value;
+	if (!Delay) {
+		Timer->Level = -1;
+		ml_scheduler_queue_push(Queue, State, Value);
+		return Timer;
+	}
+	Timer->Expiry = Queue->Timers.Current + Delay;
+	++Queue->TimerCount;
+	ml_timer_insert(Queue, Timer);
+	return Timer;
+}
+
+void ml_scheduler_timer_cancel(ml_timer_t *Timer) {
+	// A timer is only unlinked by the thread that owns its queue, other threads mark it so that it is dropped when it expires.
+	if (Timer->Queue != CurrentQueue) {
+		__atomic_store_n(&Timer->Cancelled, 1, __ATOMIC_RELEASE);
+	} else if (Timer->Level >= 0) {
+		ml_timer_remove(Timer->Queue, Timer);
+	}
+}
+
+static int ml_timers_timeout(ml_scheduler_queue_t *Queue) {
+	if (!Queue->TimerCount) return -1;
+	uint64_t Next = ml_timers_next(Queue), Now = ml_timer_now();
+	if (Next <= Now) return 0;
+	return Next - Now > INT_MAX ? INT_MAX : Next - Now;
+}
+
+void ml_scheduler_queue_poller(ml_scheduler_poller_t *Poller) {
+	CurrentQueue->Poller = Poller;
+}
+
+ml_scheduler_poller_t *ml_scheduler_queue_get_poller() {
+	ml_scheduler_queue_t *Queue = CurrentQueue;
+	return Queue ? Queue->Poller : NULL;
+}
+
+#ifdef ML_THREADSAFE
+
+ml_scheduler_queue_t *ml_scheduler_queue_park() {
+	ml_scheduler_queue_t *Queue = CurrentQueue;
+	if (!Queue) return NULL;
+	pthread_mutex_lock(Queue->Lock);
+	++Queue->Pending;
+	pthread_mutex_unlock(Queue->Lock);
+	return Queue;
+}
+
+int ml_scheduler_queue_parked() {
+	ml_scheduler_queue_t *Queue = CurrentQueue;
+	if (!Queue) return 0;
+	pthread_mutex_lock(Queue->Lock);
+	int Pending = Queue->Pending;
+	pthread_mutex_unlock(Queue->Lock);
+	return Pending;
+}
+
+static void ml_scheduler_queue_signal(ml_scheduler_queue_t *Queue, ml_state_t *State, ml_value_t *Value, int Parked) {
+	ml_queued_signal_t *Signal = new(ml_queued_signal_t);
+	Signal->State = State;
+	Signal->Value = Value;
+	pthread_mutex_lock(Queue->Lock);
+	Queue->Pending -= Parked;
+	*Queue->InboxTail = Signal;
+	Queue->InboxTail = &Signal->Next;
+	__atomic_store_n(&Queue->Signalled, 1, __ATOMIC_RELEASE);
+	pthread_cond_signal(Queue->Signal);
+	void (*wakeup)(void *) = Queue->wakeup;
+	void *Data = Queue->Data;
+	ml_scheduler_poller_t *Poller = Queue->Polling ? Queue->Poller : NULL;
+	pthread_mutex_unlock(Queue->Lock);
+	if (wakeup) wakeup(Data);
+	if (Poller) Poller->wake(Poller);
+}
+
+void ml_scheduler_queue_add_signal(ml_scheduler_queue_t *Queue, ml_state_t *State, ml_value_t *Value) {
+	return ml_scheduler_queue_signal(Queue, State, Value, 1);
+}
+
+void ml_scheduler_queue_send(ml_scheduler_queue_t *Queue, ml_state_t *State, ml_value_t *Value) {
+	return ml_scheduler_queue_signal(Queue, State, Value, 0);
+}
+
+void ml_scheduler_queue_wakeup(void (*wakeup)(void *Data), void *Data) {
+	ml_scheduler_queue_t *Queue = CurrentQueue;
+	if (!Queue) return;
+	pthread_mutex_lock(Queue->Lock);
+	Queue->wakeup = wakeup;
+	Queue->Data = Data;
+	pthread_mutex_unlock(Queue->Lock);
+}
+
+static void ml_scheduler_queue_drain(ml_scheduler_queue_t *Queue) {
+	pthread_mutex_lock(Queue->Lock);
+	ml_queued_signal_t *Signal = Queue->Inbox;
+	Queue->Inbox = NULL;
+	Queue->InboxTail = &Queue->Inbox;
+	Queue->Signalled = 0;
+	pthread_mutex_unlock(Queue->Lock);
+	for (; Signal; Signal = Signal->Next) ml_scheduler_queue_push(Queue, Signal->State, Signal->Value);
+}
+
+int ml_scheduler_queue_wait() {
+	ml_scheduler_queue_t *Queue = CurrentQueue;
+	ml_scheduler_poller_t *Poller = Queue->Poller;
+	if (Poller && Poller->Waiting) {
+		pthread_mutex_lock(Queue->Lock);
+		int Polling = Queue->Polling = !Queue->Inbox;
+		pthread_mutex_unlock(Queue->Lock);
+		if (Polling) {
+			Poller->poll(Poller, ml_timers_timeout(Queue));
+			pthread_mutex_lock(Queue->Lock);
+			Queue->Polling = 0;
+			pthread_mutex_unlock(Queue->Lock);
+		}
+		ml_scheduler_queue_drain(Queue);
+		ml_timers_advance(Queue, ml_timer_now());
+		return 1;
+	}
+	pthread_mutex_lock(Queue->Lock);
+	while (!Queue->Inbox) {
+		if (Queue->TimerCount) {
+			uint64_t Next = ml_timers_next(Queue);
+			if (Next <= ml_timer_now()) break;
+			struct timespec Time = {Next / 1000, (Next % 1000) * 1000000};
+			if (pthread_cond_timedwait(Queue->Signal, Queue->Lock, &Time) == ETIMEDOUT) break;
+		} else if (Queue->Pending) {
+			pthread_cond_wait(Queue->Signal, Queue->Lock);
+		} else {
+			pthread_mutex_unlock(Queue->Lock);
+			return 0;
+		}
+	}
+	pthread_mutex_unlock(Queue->Lock);
+	ml_scheduler_queue_drain(Queue);
+	ml_timers_advance(Queue, ml_timer_now());
+	return 1;
+}
+
+#else
+
+int ml_scheduler_queue_wait() {
+	ml_scheduler_queue_t *Queue = CurrentQueue;
+	ml_scheduler_poller_t *Poller = Queue->Poller;
+	if (Poller && Poller->Waiting) {
+		Poller->poll(Poller, ml_timers_timeout(Queue));
+		ml_timers_advance(Queue, ml_timer_now());
+		return 1;
+	}
+	if (!Queue->TimerCount) return 0;
+	uint64_t Next = ml_timers_next(Queue), Now = ml_timer_now();
+	if (Next > Now) {
+		uint64_t Delay = Next - Now;
+		struct timespec Time = {Delay / 1000, (Delay % 1000) * 1000000};
+		while (nanosleep(&Time, &Time) == -1 && errno == EINTR);
+	}
+	ml_timers_advance(Queue, ml_timer_now());
+	return 1;
+}
+
+#endif
+
+static void ml_sleep_wake(ml_state_t *State, ml_value_t *Value) {
+	ML_CONTINUE(State->Caller, ml_cancel_check(State->Context) ?: Value);
+}
+
+ML_FUNCTIONX(MLSleep) {
+//@sleep
+//<Duration:number
+//>nil
+// Suspends the current state for :mini:`Duration` seconds, letting other queued states run.
+// Returns a :mini:`CancelError` or :mini:`DeadlineError` if the current context is cancelled or reaches its deadline first.
+	ML_CHECKX_ARG_COUNT(1);
+	ML_CHECKX_ARG_TYPE(0, MLNumberT);
+	ml_value_t *Error = ml_cancel_check(Caller->Context);
+	if (Error) ML_RETURN(Error);
+	if (!CurrentQueue) ML_ERROR("SchedulerError", "No scheduler queue on this thread");
+	double Duration = ml_real_value(Args[0]);
+	uint64_t Delay = Duration > 0 ? (uint64_t)ceil(Duration * 1000) : 0;
+	if (!ml_context_get(Caller->Context, ML_CANCEL_INDEX)) {
+		ml_scheduler_timer(Caller, MLNil, Delay);
+		return;
+	}
+	// Wake no later than the deadline and check the token again before resuming.
+	uint64_t Remaining = ml_cancel_remaining(Caller->Context);
+	if (Delay > Remaining) Delay = Remaining;
+	ml_state_t *State = new(ml_state_t);
+	State->Caller = Caller;
+	State->run = ml_sleep_wake;
+	State->Context = Caller->Context;
+	ml_scheduler_timer(State, MLNil, Delay);
+}
+
+typedef struct {
+	ml_state_t Base;
+	ml_timer_t *Timer;
+	double Duration;
+	int Done;
+} ml_timeout_state_t;
+
+static void ml_timeout_run(ml_timeout_state_t *State, ml_value_t *Value) {
+	// The result may arrive on a different thread from the timer.
+	if (__atomic_exchange_n(&State->Done, 1, __ATOMIC_ACQ_REL)) return;
+	ml_scheduler_timer_cancel(State->Timer);
+	ML_CONTINUE(State->Base.Caller, Value);
+}
+
+static void ml_timeout_expire(ml_state_t *Expire, ml_value_t *Value) {
+	ml_timeout_state_t *State = (ml_timeout_state_t *)Expire->Caller;
+	if (__atomic_exchange_n(&State->Done, 1, __ATOMIC_ACQ_REL)) return;
+	ML_CONTINUE(State->Base.Caller, ml_error("TimeoutError", "Timed out after %g seconds", State->Duration));
+}
+
+ML_FUNCTIONX(MLTimeout) {
+//@timeout
+//<Duration:number
+//<Function:function
+//<Args:any
+//>any | error
+// Calls :mini:`Function(Args...)` and returns its result, or returns a :mini:`TimeoutError` if it has not returned within :mini:`Duration` seconds.
+// A late result from :mini:`Function` is discarded.
+	ML_CHECKX_ARG_COUNT(2);
+	ML_CHECKX_ARG_TYPE(0, MLNumberT);
+	if (!CurrentQueue) ML_ERROR("SchedulerError", "No scheduler queue on this thread");
+	double Duration = ml_real_value(Args[0]);
+	ml_timeout_state_t *State = new(ml_timeout_state_t);
+	State->Base.Caller = Caller;
+	State->Base.run = (void *)ml_timeout_run;
+	State->Base.Context = Caller->Context;
+	State->Duration = Duration;
+	ml_state_t *Expire = new(ml_state_t);
+	Expire->Caller = (ml_state_t *)State;
+	Expire->run = ml_timeout_expire;
+	Expire->Context = Caller->Context;
+	State->Timer = ml_scheduler_timer(Expire, MLNil, Duration > 0 ? (uint64_t)ceil(Duration * 1000) : 0);
+	ml_value_t *Function = ml_deref(Args[1]);
+	return ml_call(State, Function, Count - 2, Args + 2);
+}
+
+typedef struct {
+	unsigned int *Counter;
+	unsigned int Interval;
+	uint64_t Due;
+} ml_preempt_t;
+
+static struct {
+	pthread_mutex_t Lock[1];
+	pthread_cond_t Changed[1];
+	ml_preempt_t *Entries;
+	uint64_t Wake;
+	int Count, Size, Running;
+} PreemptTimer = {{PTHREAD_MUTEX_INITIALIZER}};
+
+static uint64_t ml_preempt_now() {
+	struct timespec Time;
+	clock_gettime(CLOCK_MONOTONIC, &Time);
+	return Time.tv_sec * 1000000ull + Time.tv_nsec / 1000;
+}
+
+static void *ml_preempt_thread(void *Arg) {
+	pthread_mutex_lock(PreemptTimer.Lock);
+	for (;;) {
+		// Park until a counter is registered, nothing is preempted while every counter is removed.
+		while (!PreemptTimer.Count) pthread_cond_wait(PreemptTimer.Changed, PreemptTimer.Lock);
+		// Each registration sets its counter at its own interval, a short interval does not preempt other counters more often.
+		uint64_t Now = ml_preempt_now(), Wake = UINT64_MAX;
+		for (int I = 0; I < PreemptTimer.Count; ++I) {
+			ml_preempt_t *Entry = PreemptTimer.Entries + I;
+			if (Entry->Due <= Now) {
+				__atomic_store_n(Entry->Counter, 1, __ATOMIC_RELAXED);
+				Entry->Due = Now + Entry->Interval;
+			}
+			if (Entry->Due < Wake) Wake = Entry->Due;
+		}
+		PreemptTimer.Wake = Wake;
+		struct timespec Deadline = {Wake / 1000000, (Wake % 1000000) * 1000};
+		while (pthread_cond_timedwait(PreemptTimer.Changed, PreemptTimer.Lock, &Deadline) == 0) {
+			if (PreemptTimer.Wake < Wake) break;
+		}
+	}
+	return NULL;
+}
+
+void ml_scheduler_preempt(unsigned int *Counter, unsigned int Interval) {
+	if (!Interval) Interval = 1;
+	uint64_t Due = ml_preempt_now() + Interval;
+	pthread_mutex_lock(PreemptTimer.Lock);
+	if (PreemptTimer.Count == PreemptTimer.Size) {
+		PreemptTimer.Size += 4;
+		ml_preempt_t *Entries = GC_MALLOC_UNCOLLECTABLE(PreemptTimer.Size * sizeof(ml_preempt_t));
+		if (PreemptTimer.Count) memcpy(Entries, PreemptTimer.Entries, PreemptTimer.Count * sizeof(ml_preempt_t));
+		if (PreemptTimer.Entries) GC_free(PreemptTimer.Entries);
+		PreemptTimer.Entries = Entries;
+	}
+	PreemptTimer.Entries[PreemptTimer.Count++] = (ml_preempt_t){Counter, Interval, Due};
+	if (!PreemptTimer.Running) {
+		pthread_condattr_t CondAttr;
+		pthread_condattr_init(&CondAttr);
+		pthread_condattr_setclock(&CondAttr, CLOCK_MONOTONIC);
+		pthread_cond_init(PreemptTimer.Changed, &CondAttr);
+		pthread_condattr_destroy(&CondAttr);
+		PreemptTimer.Wake = Due;
+		PreemptTimer.Running = 1;
+		pthread_t Thread;
+		pthread_attr_t Attr;
+		pthread_attr_init(&Attr);
+		pthread_attr_setdetachstate(&Attr, PTHREAD_CREATE_DETACHED);
+		pthread_create(&Thread, &Attr, ml_preempt_thread, NULL);
+		pthread_attr_destroy(&Attr);
+	} else if (PreemptTimer.Count == 1 || Due < PreemptTimer.Wake) {
+		// Wake the timer thread if it is parked or sleeping past the new registration's first tick.
+		PreemptTimer.Wake = Due;
+		pthread_cond_signal(PreemptTimer.Changed);
+	}
+	pthread_mutex_unlock(PreemptTimer.Lock);
+}
+
+void ml_scheduler_preempt_remove(unsigned int *Counter, unsigned int Interval) {
+	if (!Interval) Interval = 1;
+	pthread_mutex_lock(PreemptTimer.Lock);
+	for (int I = PreemptTimer.Count; --I >= 0;) {
+		ml_preempt_t *Entry = PreemptTimer.Entries + I;
+		if (Entry->Counter == Counter && Entry->Interval == Interval) {
+			*Entry = PreemptTimer.Entries[--PreemptTimer.Count];
+			break;
+		}
+	}
+	pthread_mutex_unlock(PreemptTimer.Lock);
 }
 
 #endif
@@ -905,6 +1903,8 @@ ML_METHODX("wait", MLSemaphoreT) {
 //!semaphore
 //<Semaphore
 	ml_semaphore_t *Semaphore = (ml_semaphore_t *)Args[0];
+	ml_value_t *Error = ml_cancel_check(Caller->Context);
+	if (Error) ML_RETURN(Error);
 	int64_t Value = Semaphore->Value;
 	if (Value) {
 		Semaphore->Value = Value - 1;
@@ -928,16 +1928,21 @@ ML_METHOD("signal", MLSemaphoreT) {
 //!semaphore
 //<Semaphore
 	ml_semaphore_t *Semaphore = (ml_semaphore_t *)Args[0];
-	int Fill = Semaphore->Fill;
-	if (Fill) {
-		Semaphore->Fill = Fill - 1;
+	while (Semaphore->Fill) {
+		--Semaphore->Fill;
 		ml_state_t *State = Semaphore->States[Semaphore->Read];
 		Semaphore->States[Semaphore->Read] = NULL;
 		Semaphore->Read = (Semaphore->Read + 1) % Semaphore->Size;
-		State->run(State, Args[0]);
-	} else {
-		++Semaphore->Value;
+		// Cancelled waiters are resumed with their error and do not consume the signal.
+		ml_value_t *Error = ml_cancel_check(State->Context);
+		if (Error) {
+			State->run(State, Error);
+		} else {
+			State->run(State, Args[0]);
+			return Args[0];
+		}
 	}
+	++Semaphore->Value;
 	return Args[0];
 }
 
@@ -1009,6 +2014,8 @@ ML_METHOD("open", MLChannelT) {
 
 static inline void ml_channel_next(ml_state_t *Caller, ml_channel_t *Channel, ml_value_t *Value) {
 	if (!Channel->Open) ML_ERROR("ChannelError", "Channel is not open");
+	ml_value_t *Error = ml_cancel_check(Caller->Context);
+	if (Error) ML_RETURN(Error);
 	ml_channel_message_t *Message = Channel->Head;
 	ml_channel_message_t *Next = Message->Next;
 	Channel->Head = Next;
@@ -1043,6 +2050,8 @@ ML_METHODX("send", MLChannelT, MLAnyT) {
 //>any
 	ml_channel_t *Channel = (ml_channel_t *)Args[0];
 	if (!Channel->Open) ML_ERROR("ChannelError", "Channel is not open");
+	ml_value_t *Error = ml_cancel_check(Caller->Context);
+	if (Error) ML_RETURN(Error);
 	ml_channel_message_t *Message = new(ml_channel_message_t);
 	Message->Sender = Caller;
 	Message->Value = Args[1];
@@ -1105,6 +2114,371 @@ ML_METHODX("raise", MLChannelT, MLErrorValueT) {
 }
 */
 
+#ifdef ML_THREADSAFE
+
+// Thread Channels //
+
+typedef struct ml_thread_waiter_t ml_thread_waiter_t;
+
+struct ml_thread_waiter_t {
+	ml_thread_waiter_t *Next;
+	ml_state_t *State;
+	ml_value_t *Value;
+	ml_scheduler_queue_t *Queue;
+	pthread_cond_t *Ready;
+	int Done;
+};
+
+static void ml_thread_wake(ml_thread_waiter_t *Waiter, ml_value_t *Value) {
+	// Must be called with the lock of the waiter's list held.
+#ifdef ML_SCHEDULER
+	if (Waiter->Queue) return ml_scheduler_queue_add_signal(Waiter->Queue, Waiter->State, Value);
+#endif
+	Waiter->Value = Value;
+	Waiter->Done = 1;
+	pthread_cond_signal(Waiter->Ready);
+}
+
+static void ml_thread_wait(ml_state_t *Caller, pthread_mutex_t *Lock, ml_thread_waiter_t ***Tail, ml_value_t *Value) {
+	// Appends Caller to a wait list and releases Lock. Caller is parked on the current thread's scheduler queue if it has one, otherwise the thread blocks until woken.
+#ifdef ML_SCHEDULER
+	ml_scheduler_queue_t *Queue = ml_scheduler_queue_park();
+	if (Queue) {
+		ml_thread_waiter_t *Waiter = new(ml_thread_waiter_t);
+		Waiter->State = Caller;
+		Waiter->Value = Value;
+		Waiter->Queue = Queue;
+		**Tail = Waiter;
+		*Tail = &Waiter->Next;
+		pthread_mutex_unlock(Lock);
+		return;
+	}
+#endif
+	pthread_cond_t Ready[1] = {PTHREAD_COND_INITIALIZER};
+	ml_thread_waiter_t Waiter[1] = {{NULL, Caller, Value, NULL, Ready, 0}};
+	**Tail = Waiter;
+	*Tail = &Waiter->Next;
+	while (!Waiter->Done) pthread_cond_wait(Ready, Lock);
+	pthread_mutex_unlock(Lock);
+	pthread_cond_destroy(Ready);
+	ML_RETURN(Waiter->Value);
+}
+
+static inline ml_thread_waiter_t *ml_thread_waiter_pop(ml_thread_waiter_t **Head, ml_thread_waiter_t ***Tail) {
+	ml_thread_waiter_t *Waiter = *Head;
+	if (Waiter && !(*Head = Waiter->Next)) *Tail = Head;
+	return Waiter;
+}
+
+typedef struct {
+	ml_type_t *Type;
+	pthread_mutex_t Lock[1];
+	ml_value_t **Buffer;
+	ml_thread_waiter_t *Senders, **SendersTail;
+	ml_thread_waiter_t *Receivers, **ReceiversTail;
+	size_t Size, Fill, Read, Capacity;
+	int Closed;
+} ml_thread_channel_t;
+
+ML_FUNCTION(MLThreadChannel) {
+//!channel
+//@channel::threads
+//<Capacity?:integer
+//>thread-channel
+// Returns a new channel that can be shared between threads, with any number of senders and receivers.
+// If :mini:`Capacity` is given, at most :mini:`Capacity` messages are buffered and further senders wait, otherwise the channel is unbounded.
+// A :mini:`Capacity` of :mini:`0` makes each sender wait for a receiver.
+	size_t Capacity = SIZE_MAX;
+	if (Count > 0) {
+		ML_CHECK_ARG_TYPE(0, MLIntegerT);
+		int64_t Value = ml_integer_value_fast(Args[0]);
+		if (Value < 0) return ml_error("ValueError", "Channel capacity must be non-negative");
+		Capacity = Value;
+	}
+	ml_thread_channel_t *Channel = new(ml_thread_channel_t);
+	Channel->Type = MLThreadChannelT;
+	pthread_mutex_init(Channel->Lock, NULL);
+	Channel->Capacity = Capacity;
+	Channel->Size = Capacity < 16 ? (Capacity ?: 1) : 16;
+	Channel->Buffer = anew(ml_value_t *, Channel->Size);
+	Channel->SendersTail = &Channel->Senders;
+	Channel->ReceiversTail = &Channel->Receivers;
+	return (ml_value_t *)Channel;
+}
+
+ML_TYPE(MLThreadChannelT, (), "thread-channel",
+//!channel
+// A thread safe multi-producer, multi-consumer channel.
+	.Constructor = (ml_value_t *)MLThreadChannel
+);
+
+static void ml_thread_channel_push(ml_thread_channel_t *Channel, ml_value_t *Value) {
+	if (Channel->Fill == Channel->Size) {
+		size_t Size = Channel->Size * 2;
+		ml_value_t **Buffer = anew(ml_value_t *, Size);
+		size_t Tail = Channel->Size - Channel->Read;
+		memcpy(Buffer, Channel->Buffer + Channel->Read, Tail * sizeof(ml_value_t *));
+		memcpy(Buffer + Tail, Channel->Buffer, Channel->Read * sizeof(ml_value_t *));
+		Channel->Buffer = Buffer;
+		Channel->Size = Size;
+		Channel->Read = 0;
+	}
+	Channel->Buffer[(Channel->Read + Channel->Fill++) % Channel->Size] = Value;
+}
+
+ML_METHODX("send", MLThreadChannelT, MLAnyT) {
+//!channel
+//<Channel
+//<Message
+//>thread-channel | error
+// Sends :mini:`Message` to :mini:`Channel`, waiting while the channel is full.
+// Returns an error if :mini:`Channel` is (or becomes) closed.
+	ml_thread_channel_t *Channel = (ml_thread_channel_t *)Args[0];
+	ml_value_t *Error = ml_cancel_check(Caller->Context);
+	if (Error) ML_RETURN(Error);
+	ml_value_t *Value = ml_deref(Args[1]);
+	pthread_mutex_lock(Channel->Lock);
+	if (Channel->Closed) {
+		pthread_mutex_unlock(Channel->Lock);
+		ML_ERROR("ChannelError", "Channel is closed");
+	}
+	ml_thread_waiter_t *Receiver = ml_thread_waiter_pop(&Channel->Receivers, &Channel->ReceiversTail);
+	if (Receiver) {
+		ml_thread_wake(Receiver, Value);
+	} else if (Channel->Fill < Channel->Capacity) {
+		ml_thread_channel_push(Channel, Value);
+	} else {
+		return ml_thread_wait(Caller, Channel->Lock, &Channel->SendersTail, Value);
+	}
+	pthread_mutex_unlock(Channel->Lock);
+	ML_RETURN(Channel);
+}
+
+ML_METHODX("next", MLThreadChannelT) {
+//!channel
+//<Channel
+//>any | nil
+// Returns the next message from :mini:`Channel`, waiting until one is available.
+// Returns :mini:`nil` once :mini:`Channel` is closed and empty.
+	ml_thread_channel_t *Channel = (ml_thread_channel_t *)Args[0];
+	ml_value_t *Error = ml_cancel_check(Caller->Context);
+	if (Error) ML_RETURN(Error);
+	ml_value_t *Value;
+	pthread_mutex_lock(Channel->Lock);
+	ml_thread_waiter_t *Sender = ml_thread_waiter_pop(&Channel->Senders, &Channel->SendersTail);
+	if (Channel->Fill) {
+		Value = Channel->Buffer[Channel->Read];
+		Channel->Buffer[Channel->Read] = NULL;
+		Channel->Read = (Channel->Read + 1) % Channel->Size;
+		--Channel->Fill;
+		if (Sender) ml_thread_channel_push(Channel, Sender->Value);
+	} else if (Sender) {
+		Value = Sender->Value;
+	} else if (Channel->Closed) {
+		Value = MLNil;
+	} else {
+		return ml_thread_wait(Caller, Channel->Lock, &Channel->ReceiversTail, NULL);
+	}
+	if (Sender) ml_thread_wake(Sender, (ml_value_t *)Channel);
+	pthread_mutex_unlock(Channel->Lock);
+	ML_RETURN(Value);
+}
+
+ML_METHOD("close", MLThreadChannelT) {
+//!channel
+//<Channel
+//>thread-channel
+// Closes :mini:`Channel`. Waiting receivers return :mini:`nil` and waiting senders return an error, buffered messages can still be received.
+	ml_thread_channel_t *Channel = (ml_thread_channel_t *)Args[0];
+	pthread_mutex_lock(Channel->Lock);
+	Channel->Closed = 1;
+	ml_thread_waiter_t *Waiter;
+	while ((Waiter = ml_thread_waiter_pop(&Channel->Receivers, &Channel->ReceiversTail))) ml_thread_wake(Waiter, MLNil);
+	while ((Waiter = ml_thread_waiter_pop(&Channel->Senders, &Channel->SendersTail))) {
+		ml_thread_wake(Waiter, ml_error("ChannelError", "Channel is closed"));
+	}
+	pthread_mutex_unlock(Channel->Lock);
+	return Args[0];
+}
+
+ML_METHOD("length", MLThreadChannelT) {
+//!channel
+//<Channel
+//>integer
+// Returns the number of messages currently buffered in :mini:`Channel`.
+	ml_thread_channel_t *Channel = (ml_thread_channel_t *)Args[0];
+	pthread_mutex_lock(Channel->Lock);
+	size_t Fill = Channel->Fill;
+	pthread_mutex_unlock(Channel->Lock);
+	return ml_integer(Fill);
+}
+
+// Thread Semaphores //
+
+typedef struct {
+	ml_type_t *Type;
+	pthread_mutex_t Lock[1];
+	ml_thread_waiter_t *Waiters, **WaitersTail;
+	int64_t Value;
+} ml_thread_semaphore_t;
+
+ML_FUNCTION(MLThreadSemaphore) {
+//!semaphore
+//@semaphore::threads
+//<Initial?:integer
+//>thread-semaphore
+// Returns a new semaphore that can be shared between threads.
+	if (Count > 0) ML_CHECK_ARG_TYPE(0, MLIntegerT);
+	ml_thread_semaphore_t *Semaphore = new(ml_thread_semaphore_t);
+	Semaphore->Type = MLThreadSemaphoreT;
+	pthread_mutex_init(Semaphore->Lock, NULL);
+	Semaphore->WaitersTail = &Semaphore->Waiters;
+	Semaphore->Value = (Count > 0) ? ml_integer_value(Args[0]) : 1;
+	return (ml_value_t *)Semaphore;
+}
+
+ML_TYPE(MLThreadSemaphoreT, (), "thread-semaphore",
+//!semaphore
+// A thread safe semaphore.
+	.Constructor = (ml_value_t *)MLThreadSemaphore
+);
+
+ML_METHODX("wait", MLThreadSemaphoreT) {
+//!semaphore
+//<Semaphore
+//>thread-semaphore
+	ml_thread_semaphore_t *Semaphore = (ml_thread_semaphore_t *)Args[0];
+	ml_value_t *Error = ml_cancel_check(Caller->Context);
+	if (Error) ML_RETURN(Error);
+	pthread_mutex_lock(Semaphore->Lock);
+	if (Semaphore->Value > 0) {
+		--Semaphore->Value;
+		pthread_mutex_unlock(Semaphore->Lock);
+		ML_RETURN(Semaphore);
+	}
+	return ml_thread_wait(Caller, Semaphore->Lock, &Semaphore->WaitersTail, NULL);
+}
+
+ML_METHOD("signal", MLThreadSemaphoreT) {
+//!semaphore
+//<Semaphore
+//>thread-semaphore
+	ml_thread_semaphore_t *Semaphore = (ml_thread_semaphore_t *)Args[0];
+	pthread_mutex_lock(Semaphore->Lock);
+	ml_thread_waiter_t *Waiter = ml_thread_waiter_pop(&Semaphore->Waiters, &Semaphore->WaitersTail);
+	if (Waiter) {
+		ml_thread_wake(Waiter, Args[0]);
+	} else {
+		++Semaphore->Value;
+	}
+	pthread_mutex_unlock(Semaphore->Lock);
+	return Args[0];
+}
+
+ML_METHOD("value", MLThreadSemaphoreT) {
+//!semaphore
+//<Semaphore
+//>integer
+	ml_thread_semaphore_t *Semaphore = (ml_thread_semaphore_t *)Args[0];
+	pthread_mutex_lock(Semaphore->Lock);
+	int64_t Value = Semaphore->Value;
+	pthread_mutex_unlock(Semaphore->Lock);
+	return ml_integer(Value);
+}
+
+#endif
+
+// Isolates //
+
+struct ml_isolate_t {
+	ml_context_t *Context;
+	ml_getter_t SharedGet;
+	void *Shared;
+	stringmap_t Globals[1];
+};
+
+#ifdef ML_SCHEDULER
+
+#define ML_ISOLATE_SLICE 1000
+
+#ifdef ML_THREADSAFE
+static __thread unsigned int IsolateCounter = ML_ISOLATE_SLICE;
+#else
+static unsigned int IsolateCounter = ML_ISOLATE_SLICE;
+#endif
+
+static ml_schedule_t ml_isolate_scheduler(ml_context_t *Context) {
+	return (ml_schedule_t){&IsolateCounter, (void *)ml_scheduler_queue_add};
+}
+
+#endif
+
+ml_isolate_t *ml_isolate_new(ml_getter_t SharedGet, void *Shared) {
+	ml_isolate_t *Isolate = new(ml_isolate_t);
+	ml_context_t *Context = Isolate->Context = ml_context_new(&MLRootContext);
+	ml_methods_context_new(Context);
+#ifdef ML_SCHEDULER
+	ml_context_set(Context, ML_SCHEDULER_INDEX, ml_isolate_scheduler);
+#endif
+	Isolate->SharedGet = SharedGet;
+	Isolate->Shared = Shared;
+	return Isolate;
+}
+
+ml_context_t *ml_isolate_context(ml_isolate_t *Isolate) {
+	return Isolate->Context;
+}
+
+ml_value_t *ml_isolate_global_get(ml_isolate_t *Isolate, const char *Name) {
+	ml_value_t *Value = stringmap_search(Isolate->Globals, Name);
+	if (Value || !Isolate->SharedGet) return Value;
+	return Isolate->SharedGet(Isolate->Shared, Name);
+}
+
+void ml_isolate_global_set(ml_isolate_t *Isolate, const char *Name, ml_value_t *Value) {
+	stringmap_insert(Isolate->Globals, Name, Value);
+}
+
+static ml_value_t *ml_isolate_wait(ml_result_state_t *State) {
+#ifdef ML_SCHEDULER
+	while (!State->Value) {
+		ml_queued_state_t QueuedState = ml_scheduler_queue_next();
+		if (!QueuedState.State) {
+			if (ml_scheduler_queue_wait()) continue;
+			break;
+		}
+		IsolateCounter = ML_ISOLATE_SLICE;
+		QueuedState.State->run(QueuedState.State, QueuedState.Value);
+	}
+#endif
+	return State->Value ?: ml_error("IsolateError", "Call did not complete");
+}
+
+static ml_result_state_t *ml_isolate_state(ml_isolate_t *Isolate) {
+#ifdef ML_SCHEDULER
+	if (!ml_scheduler_queue_current()) ml_scheduler_queue_init(4);
+#endif
+	ml_result_state_t *State = ml_result_state_new(Isolate->Context);
+	State->Value = NULL;
+	return State;
+}
+
+ml_value_t *ml_isolate_call(ml_isolate_t *Isolate, ml_value_t *Function, int Count, ml_value_t **Args) {
+	ml_result_state_t *State = ml_isolate_state(Isolate);
+	ml_call(State, Function, Count, Args);
+	return ml_isolate_wait(State);
+}
+
+ml_value_t *ml_isolate_load(ml_isolate_t *Isolate, const char *FileName, const char *Parameters[]) {
+	ml_result_state_t *State = ml_isolate_state(Isolate);
+	ml_load_file((ml_state_t *)State, (ml_getter_t)ml_isolate_global_get, Isolate, FileName, Parameters);
+	return ml_isolate_wait(State);
+}
+
 void ml_runtime_init() {
 #include "ml_runtime_init.c"
+#ifdef ML_THREADSAFE
+	stringmap_insert(MLChannelT->Exports, "threads", MLThreadChannelT);
+	stringmap_insert(MLSemaphoreT->Exports, "threads", MLThreadSemaphoreT);
+#endif
 }
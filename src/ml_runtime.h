@@ -28,10 +28,13 @@ extern ml_value_t *MLArgCache[ML_ARG_CACHE_SIZE];
 
 //#define ml_alloc_args(COUNT) anew(ml_value_t *, COUNT)
 
+// Contexts are copy-on-write, a new context shares its parent's slots until either is changed with ml_context_set().
+// Values must only be written through ml_context_set(), which allocates the copy.
+
 struct ml_context_t {
 	ml_context_t *Parent;
-	int Size;
-	void *Values[];
+	void **Values;
+	int Size, Shared;
 };
 
 extern ml_context_t MLRootContext;
@@ -205,10 +208,81 @@ typedef struct {
 	ml_value_t *Value;
 } ml_queued_state_t;
 
+// Queued states are run in order of the priority of their context, from ML_SCHEDULER_PRIORITIES - 1 down to 0.
+// The priority is stored in the context as Priority + 1 so that unset contexts get ML_SCHEDULER_PRIORITY_DEFAULT.
+
+#define ML_PRIORITY_INDEX 6
+#define ML_SCHEDULER_PRIORITIES 4
+#define ML_SCHEDULER_PRIORITY_DEFAULT 1
+
+static inline int ml_scheduler_priority(ml_context_t *Context) {
+	uintptr_t Priority = (uintptr_t)ml_context_get(Context, ML_PRIORITY_INDEX);
+	return Priority ? Priority - 1 : ML_SCHEDULER_PRIORITY_DEFAULT;
+}
+
+// Each thread that runs queued states calls ml_scheduler_queue_init() once to create its own queue (and timers).
+// The remaining queue functions act on the queue of the calling thread.
+
+typedef struct ml_scheduler_queue_t ml_scheduler_queue_t;
+
 void ml_scheduler_queue_init(int Size);
+ml_scheduler_queue_t *ml_scheduler_queue_current();
 ml_queued_state_t ml_scheduler_queue_next();
 int ml_scheduler_queue_add(ml_state_t *State, ml_value_t *Value);
 
+#ifdef ML_THREADSAFE
+
+// ml_scheduler_queue_park() returns the current thread's queue (or NULL) and records that a state will be resumed on it from another thread,
+// which must then call ml_scheduler_queue_add_signal() exactly once. ml_scheduler_queue_wait() keeps waiting while any parked states are outstanding,
+// event loops that do not block in ml_scheduler_queue_wait() can check ml_scheduler_queue_parked() for the number of outstanding parked states.
+// ml_scheduler_queue_send() resumes a state on another thread's queue without a matching park, the owner must already be waiting for some other reason (such as a poller).
+// ml_scheduler_queue_wakeup() sets a callback, called from the signalling thread, for event loops that do not block in ml_scheduler_queue_wait().
+
+ml_scheduler_queue_t *ml_scheduler_queue_park();
+int ml_scheduler_queue_parked();
+void ml_scheduler_queue_add_signal(ml_scheduler_queue_t *Queue, ml_state_t *State, ml_value_t *Value);
+void ml_scheduler_queue_send(ml_scheduler_queue_t *Queue, ml_state_t *State, ml_value_t *Value);
+void ml_scheduler_queue_wakeup(void (*wakeup)(void *Data), void *Data);
+
+#endif
+
+// Starts (or joins) a background timer that sets *Counter to 1 every Interval microseconds.
+// A scheduler that keeps its counter high between swaps is then preempted by time instead of by count.
+// Each registration is kept, and ticks at its own interval, until ml_scheduler_preempt_remove() is called with the same arguments.
+// The timer thread parks while no counters are registered.
+void ml_scheduler_preempt(unsigned int *Counter, unsigned int Interval);
+void ml_scheduler_preempt_remove(unsigned int *Counter, unsigned int Interval);
+
+// Timers queue State with Value on the current thread's scheduler queue after Delay milliseconds, ml_scheduler_timer() returns NULL if the thread has no queue.
+// A timer cancelled from another thread is dropped when it expires instead of being removed immediately.
+// ml_scheduler_queue_wait() sleeps until the next timer expires (or a parked state is signalled), returning 0 if there is nothing left to wait for.
+
+typedef struct ml_timer_t ml_timer_t;
+
+ml_timer_t *ml_scheduler_timer(ml_state_t *State, ml_value_t *Value, uint64_t Delay);
+void ml_scheduler_timer_cancel(ml_timer_t *Timer);
+int ml_scheduler_queue_wait();
+
+// A poller lets ml_scheduler_queue_wait() block on external events (such as file descriptors) instead of only sleeping until the next timer.
+// poll() waits at most Timeout milliseconds (-1 for no limit) and queues any states that have become ready with ml_scheduler_queue_add().
+// ml_scheduler_queue_wait() only calls poll() while Waiting (the number of states the poller will resume) is non-zero.
+// In ML_THREADSAFE builds, wake() is called from other threads to interrupt poll() when a state is signalled.
+
+typedef struct ml_scheduler_poller_t ml_scheduler_poller_t;
+
+struct ml_scheduler_poller_t {
+	void (*poll)(ml_scheduler_poller_t *Poller, int Timeout);
+	void (*wake)(ml_scheduler_poller_t *Poller);
+	int Waiting;
+};
+
+void ml_scheduler_queue_poller(ml_scheduler_poller_t *Poller);
+ml_scheduler_poller_t *ml_scheduler_queue_get_poller();
+
+extern ml_cfunctionx_t MLSleep[];
+extern ml_cfunctionx_t MLTimeout[];
+extern ml_cfunctionx_t MLPriority[];
+
 // Semaphores
 
 extern ml_type_t MLSemaphoreT[];
@@ -217,6 +291,66 @@ extern ml_type_t MLSemaphoreT[];
 
 extern ml_type_t MLChannelT[];
 
+#ifdef ML_THREADSAFE
+
+// Thread safe channels and semaphores, waiters on threads with a scheduler queue are parked on it, other threads block.
+
+extern ml_type_t MLThreadChannelT[];
+extern ml_type_t MLThreadSemaphoreT[];
+
+#endif
+
+// Isolates //
+
+// An isolate is an independent interpreter instance: a context with its own method table, context variables and scheduler, and its own globals.
+// Globals not found in the isolate are looked up using SharedGet(Shared, Name), which must not be modified while isolates are running.
+// Each isolate must only be used by one thread at a time, different isolates can run concurrently on different threads (in an ML_THREADSAFE build).
+// ml_isolate_call() and ml_isolate_load() run the calling thread's scheduler queue (creating it if necessary) until the result is available.
+
+typedef struct ml_isolate_t ml_isolate_t;
+
+ml_isolate_t *ml_isolate_new(ml_getter_t SharedGet, void *Shared);
+ml_context_t *ml_isolate_context(ml_isolate_t *Isolate);
+ml_value_t *ml_isolate_global_get(ml_isolate_t *Isolate, const char *Name);
+void ml_isolate_global_set(ml_isolate_t *Isolate, const char *Name, ml_value_t *Value);
+ml_value_t *ml_isolate_call(ml_isolate_t *Isolate, ml_value_t *Function, int Count, ml_value_t **Args);
+ml_value_t *ml_isolate_load(ml_isolate_t *Isolate, const char *FileName, const char *Parameters[]);
+
+// Cancellation //
+
+#define ML_CANCEL_INDEX 5
+
+// Returns a CancelError (or DeadlineError) if the cancellation token of Context, or any token it was created under, has been cancelled or has passed its deadline, NULL otherwise.
+// Suspension points, channels, semaphores, tasks and streams call this before doing any further work.
+ml_value_t *ml_cancel_check(ml_context_t *Context);
+
+// Returns the number of milliseconds until the earliest deadline of Context, or UINT64_MAX if it has none.
+uint64_t ml_cancel_remaining(ml_context_t *Context);
+
+extern ml_type_t MLCancelT[];
+extern ml_cfunctionx_t MLDeadline[];
+
+// Quotas //
+
+#ifdef ML_SCHEDULER
+
+#define ML_QUOTA_INDEX 7
+
+// A quota limits the instructions (calls and jumps), wall-clock time and allocated bytes used by code running under it, a limit of 0 is unlimited.
+// Instructions and time are checked at the bytecode scheduler checks, once a limit is reached the running code receives a QuotaError.
+
+typedef struct ml_quota_t ml_quota_t;
+
+ml_quota_t *ml_quota_new(ml_context_t *Context, uint64_t Instructions, double Seconds, size_t Bytes);
+void ml_quota_call(ml_state_t *Caller, ml_quota_t *Quota, ml_value_t *Function, int Count, ml_value_t **Args);
+
+// Returns a QuotaError if the quota of Context, or any quota it was created under, has been exceeded, NULL otherwise.
+ml_value_t *ml_quota_check(ml_context_t *Context);
+
+extern ml_type_t MLQuotaT[];
+
+#endif
+
 #ifdef	__cplusplus
 }
 #endif
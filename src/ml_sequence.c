@@ -3,6 +3,8 @@
 #include <gc.h>
 #include "ml_runtime.h"
 #include <string.h>
+#include <limits.h>
+#include <math.h>
 #include "minilang.h"
 #include "ml_macros.h"
 
@@ -111,10 +113,27 @@ ML_FUNCTION(MLChained) {
 	return ml_chained(Count, Args);
 }
 
+typedef enum {
+	ML_CHAINED_STAGE_END,
+	ML_CHAINED_STAGE_VALUE,
+	ML_CHAINED_STAGE_KEY,
+	ML_CHAINED_STAGE_DUO_VALUE,
+	ML_CHAINED_STAGE_FILTER,
+	ML_CHAINED_STAGE_FILTER_DUO
+} ml_chained_stage_kind_t;
+
+typedef struct {
+	ml_chained_stage_kind_t Kind;
+	ml_value_t *Function;
+	ml_callback_t Callback;
+	void *Data;
+} ml_chained_stage_t;
+
 typedef struct ml_chained_iterator_t {
 	ml_state_t Base;
 	ml_value_t *Iterator;
 	ml_value_t **Current, **Entries;
+	ml_chained_stage_t *Stages, *Stage;
 	ml_value_t *Values[3];
 } ml_chained_iterator_t;
 
@@ -216,10 +235,147 @@ static void ml_chained_iterator_next(ml_chained_iterator_t *State, ml_value_t *I
 	return ml_iter_key((ml_state_t *)State, State->Iterator = Iter);
 }
 
+static ml_chained_stage_t *ml_chained_stages(ml_value_t **Entries) {
+	int Count = 1;
+	for (ml_value_t **Entry = Entries; Entry[0]; ++Entry) ++Count;
+	ml_chained_stage_t *Stages = anew(ml_chained_stage_t, Count), *Stage = Stages;
+	for (ml_value_t **Entry = Entries; Entry[0]; ++Entry, ++Stage) {
+		ml_value_t *Function = Entry[0];
+		if (Function == SoloMethod) {
+			Stage->Kind = ML_CHAINED_STAGE_VALUE;
+		} else if (Function == DuoMethod) {
+			Stage->Kind = ML_CHAINED_STAGE_KEY;
+			if (!Entry[1]) return NULL;
+			Stage->Function = Entry[1];
+			++Entry;
+			++Stage;
+			Stage->Kind = ML_CHAINED_STAGE_DUO_VALUE;
+		} else if (Function == FilterSoloMethod) {
+			Stage->Kind = ML_CHAINED_STAGE_FILTER;
+		} else if (Function == FilterDuoMethod) {
+			Stage->Kind = ML_CHAINED_STAGE_FILTER_DUO;
+		} else {
+			Stage->Kind = ML_CHAINED_STAGE_VALUE;
+			Stage->Function = Function;
+			continue;
+		}
+		if (!Entry[1]) return NULL;
+		Stage->Function = *++Entry;
+	}
+	for (Stage = Stages; Stage->Kind; ++Stage) {
+		ml_value_t *Function = Stage->Function;
+		if (ml_typeof(Function) == MLTypeT) Function = ((ml_type_t *)Function)->Constructor;
+		if (ml_typeof(Function) == MLCFunctionT) {
+			ml_cfunction_t *CFunction = (ml_cfunction_t *)Function;
+			Stage->Callback = CFunction->Callback;
+			Stage->Data = CFunction->Data;
+		}
+	}
+	return Stages;
+}
+
+static void ml_chained_fused_next(ml_chained_iterator_t *State, ml_value_t *Iter);
+
+static void ml_chained_fused_run(ml_chained_iterator_t *State, ml_chained_stage_t *Stage);
+
+static void ml_chained_fused_result(ml_chained_iterator_t *State, ml_value_t *Value) {
+	Value = ml_deref(Value);
+	if (ml_is_error(Value)) ML_CONTINUE(State->Base.Caller, Value);
+	ml_chained_stage_t *Stage = State->Stage;
+	switch (Stage->Kind) {
+	case ML_CHAINED_STAGE_KEY:
+		State->Values[2] = State->Values[1];
+		State->Values[1] = State->Values[0];
+		State->Values[0] = Value;
+		break;
+	case ML_CHAINED_STAGE_FILTER:
+	case ML_CHAINED_STAGE_FILTER_DUO:
+		if (Value == MLNil) {
+			State->Base.run = (void *)ml_chained_fused_next;
+			return ml_iter_next((ml_state_t *)State, State->Iterator);
+		}
+		break;
+	default:
+		State->Values[1] = Value;
+		State->Values[2] = NULL;
+		break;
+	}
+	return ml_chained_fused_run(State, Stage + 1);
+}
+
+static void ml_chained_fused_run(ml_chained_iterator_t *State, ml_chained_stage_t *Stage) {
+	ml_value_t **Values = State->Values;
+	for (; Stage->Kind; ++Stage) {
+		ml_value_t **Args;
+		int Count;
+		switch (Stage->Kind) {
+		case ML_CHAINED_STAGE_KEY:
+		case ML_CHAINED_STAGE_FILTER_DUO:
+			Args = Values; Count = 2;
+			break;
+		case ML_CHAINED_STAGE_DUO_VALUE:
+			Args = Values + 1; Count = 2;
+			break;
+		default:
+			Args = Values + 1; Count = 1;
+			break;
+		}
+		if (!Stage->Callback) {
+			State->Stage = Stage;
+			State->Base.run = (void *)ml_chained_fused_result;
+			return ml_call(State, Stage->Function, Count, Args);
+		}
+		for (int I = 0; I < Count; ++I) Args[I] = ml_deref(Args[I]);
+		ml_value_t *Value = ml_deref(Stage->Callback(Stage->Data, Count, Args));
+		if (ml_is_error(Value)) ML_CONTINUE(State->Base.Caller, Value);
+		switch (Stage->Kind) {
+		case ML_CHAINED_STAGE_KEY:
+			Values[2] = Values[1];
+			Values[1] = Values[0];
+			Values[0] = Value;
+			break;
+		case ML_CHAINED_STAGE_FILTER:
+		case ML_CHAINED_STAGE_FILTER_DUO:
+			if (Value == MLNil) {
+				State->Base.run = (void *)ml_chained_fused_next;
+				return ml_iter_next((ml_state_t *)State, State->Iterator);
+			}
+			break;
+		default:
+			Values[1] = Value;
+			Values[2] = NULL;
+			break;
+		}
+	}
+	ML_CONTINUE(State->Base.Caller, State);
+}
+
+static void ml_chained_fused_value(ml_chained_iterator_t *State, ml_value_t *Value) {
+	Value = ml_deref(Value);
+	if (ml_is_error(Value)) ML_CONTINUE(State->Base.Caller, Value);
+	State->Values[1] = Value;
+	State->Values[2] = NULL;
+	return ml_chained_fused_run(State, State->Stages);
+}
+
+static void ml_chained_fused_key(ml_chained_iterator_t *State, ml_value_t *Value) {
+	if (ml_is_error(Value)) ML_CONTINUE(State->Base.Caller, Value);
+	State->Values[0] = Value;
+	State->Base.run = (void *)ml_chained_fused_value;
+	return ml_iter_value((ml_state_t *)State, State->Iterator);
+}
+
+static void ml_chained_fused_next(ml_chained_iterator_t *State, ml_value_t *Iter) {
+	if (ml_is_error(Iter)) ML_CONTINUE(State->Base.Caller, Iter);
+	if (Iter == MLNil) ML_CONTINUE(State->Base.Caller, Iter);
+	State->Base.run = (void *)ml_chained_fused_key;
+	return ml_iter_key((ml_state_t *)State, State->Iterator = Iter);
+}
+
 static void ML_TYPED_FN(ml_iter_next, MLChainedStateT, ml_state_t *Caller, ml_chained_iterator_t *State) {
 	State->Base.Caller = Caller;
 	State->Base.Context = Caller->Context;
-	State->Base.run = (void *)ml_chained_iterator_next;
+	State->Base.run = State->Stages ? (void *)ml_chained_fused_next : (void *)ml_chained_iterator_next;
 	return ml_iter_next((ml_state_t *)State, State->Iterator);
 }
 
@@ -228,8 +384,11 @@ static void ML_TYPED_FN(ml_iterate, MLChainedT, ml_state_t *Caller, ml_chained_f
 	State->Base.Type =  MLChainedStateT;
 	State->Base.Caller = Caller;
 	State->Base.Context = Caller->Context;
-	State->Base.run = (void *)ml_chained_iterator_next;
 	State->Entries = Chained->Entries + 1;
+	// Stages are resolved once per iteration so that each element runs through all of them in a single loop.
+	// Malformed chains fall back to the stepwise iterator which reports the error lazily.
+	State->Stages = ml_chained_stages(State->Entries);
+	State->Base.run = State->Stages ? (void *)ml_chained_fused_next : (void *)ml_chained_iterator_next;
 	return ml_iterate((ml_state_t *)State, Chained->Entries[0]);
 }
 
@@ -590,6 +749,10 @@ ML_FUNCTIONX(Last) {
 // Returns the last value produced by :mini:`Sequence`.
 	ML_CHECKX_ARG_COUNT(1);
 	ML_CHECKX_ARG_TYPE(0, MLSequenceT);
+	if (Count == 1) {
+		ml_value_t *Result = ml_iter_last(Args[0]);
+		if (Result) ML_RETURN(Result);
+	}
 	ml_iter_state_t *State = xnew(ml_iter_state_t, 1, ml_value_t *);
 	State->Base.Caller = Caller;
 	State->Base.run = (void *)last_iterate;
@@ -636,6 +799,22 @@ ML_FUNCTIONX(Last2) {
 // Returns the last key and value produced by :mini:`Sequence`.
 	ML_CHECKX_ARG_COUNT(1);
 	ML_CHECKX_ARG_TYPE(0, MLSequenceT);
+	if (Count == 1) {
+		ml_iter_cursor_t Cursor[1] = {{NULL, 0}};
+		long Length = ml_iter_seek(Args[0], Cursor, LONG_MAX);
+		if (Length == 0) ML_RETURN(MLNil);
+		if (Length > 0) {
+			*Cursor = (ml_iter_cursor_t){NULL, 0};
+			ml_iter_seek(Args[0], Cursor, Length - 1);
+			ml_value_t *Key, *Value;
+			if (ml_iter_block(Args[0], Cursor, &Key, &Value, 1) == 1) {
+				ml_value_t *Tuple = ml_tuple(2);
+				ml_tuple_set(Tuple, 1, Key);
+				ml_tuple_set(Tuple, 2, Value);
+				ML_RETURN(Tuple);
+			}
+		}
+	}
 	ml_iter_state_t *State = xnew(ml_iter_state_t, 3, ml_value_t *);
 	State->Base.Caller = Caller;
 	State->Base.run = (void *)last2_iterate;
@@ -661,12 +840,21 @@ ML_METHODVX(MLSequenceCount, MLSequenceT) {
 //<Sequence
 //>integer
 // Returns the count of the values produced by :mini:`Sequence`.
+	ml_value_t *Sequence = ml_chained(Count, Args);
+	ml_iter_cursor_t Cursor[1] = {{NULL, 0}};
+	long Length = ml_iter_seek(Sequence, Cursor, LONG_MAX);
+	if (Length >= 0) ML_RETURN(ml_integer(Length));
+	int Size = ml_iter_block(Sequence, Cursor, NULL, NULL, ML_ITER_BLOCK_SIZE);
+	if (Size >= 0) {
+		while (Size > 0) Size = ml_iter_block(Sequence, Cursor, NULL, NULL, ML_ITER_BLOCK_SIZE);
+		ML_RETURN(ml_integer(Cursor->Index));
+	}
 	ml_count_state_t *State = new(ml_count_state_t);
 	State->Base.Caller = Caller;
 	State->Base.run = (void *)count_iterate;
 	State->Base.Context = Caller->Context;
 	State->Count = 0;
-	return ml_iterate((ml_state_t *)State, ml_chained(Count, Args));
+	return ml_iterate((ml_state_t *)State, Sequence);
 }
 
 typedef struct ml_count2_state_t {
@@ -756,6 +944,56 @@ static void reduce_iterate(ml_iter_state_t *State, ml_value_t *Value) {
 	return ml_iter_value((ml_state_t *)State, State->Iter = Value);
 }
 
+typedef struct {
+	ml_state_t Base;
+	ml_value_t *Sequence, *Function, *Result;
+	ml_iter_cursor_t Cursor[1];
+	int Index, Size;
+	ml_value_t *Args[2];
+	ml_value_t *Values[ML_ITER_BLOCK_SIZE];
+} ml_reduce_block_state_t;
+
+static void reduce_block_run(ml_reduce_block_state_t *State) {
+	for (;;) {
+		if (State->Index == State->Size) {
+			int Size = ml_iter_block(State->Sequence, State->Cursor, NULL, State->Values, ML_ITER_BLOCK_SIZE);
+			if (Size <= 0) ML_CONTINUE(State->Base.Caller, State->Result ?: MLNil);
+			State->Index = 0;
+			State->Size = Size;
+		}
+		ml_value_t *Value = ml_deref(State->Values[State->Index++]);
+		if (State->Result) {
+			State->Args[0] = State->Result;
+			State->Args[1] = Value;
+			return ml_call(State, State->Function, 2, State->Args);
+		}
+		State->Result = Value;
+	}
+}
+
+static void reduce_block_call(ml_reduce_block_state_t *State, ml_value_t *Value) {
+	Value = ml_deref(Value);
+	if (ml_is_error(Value)) ML_CONTINUE(State->Base.Caller, Value);
+	if (Value != MLNil) State->Result = Value;
+	return reduce_block_run(State);
+}
+
+static ml_reduce_block_state_t *reduce_block(ml_state_t *Caller, ml_value_t *Sequence, ml_value_t *Function, ml_value_t *Initial) {
+	if (!ml_typed_fn_get(ml_typeof(Sequence), ml_iter_block)) return NULL;
+	ml_reduce_block_state_t *State = new(ml_reduce_block_state_t);
+	int Size = ml_iter_block(Sequence, State->Cursor, NULL, State->Values, ML_ITER_BLOCK_SIZE);
+	if (Size < 0) return NULL;
+	State->Base.Caller = Caller;
+	State->Base.run = (void *)reduce_block_call;
+	State->Base.Context = Caller->Context;
+	State->Sequence = Sequence;
+	State->Function = Function;
+	// Like the stepwise path, an empty sequence reduces to nil even with an initial value.
+	State->Result = Size ? Initial : NULL;
+	State->Size = Size;
+	return State;
+}
+
 ML_FUNCTIONX(Reduce) {
 //<Initial?:any
 //<Sequence:sequence
@@ -767,6 +1005,10 @@ ML_FUNCTIONX(Reduce) {
 	if (Count == 2) {
 		ML_CHECKX_ARG_TYPE(0, MLSequenceT);
 		ML_CHECKX_ARG_TYPE(1, MLFunctionT);
+		ml_value_t *Result = ml_iter_reduce(Args[0], Args[1], NULL);
+		if (Result) ML_RETURN(Result);
+		ml_reduce_block_state_t *Block = reduce_block(Caller, Args[0], Args[1], NULL);
+		if (Block) return reduce_block_run(Block);
 		ml_iter_state_t *State = xnew(ml_iter_state_t, 3, ml_value_t *);
 		State->Base.Caller = Caller;
 		State->Base.run = (void *)reduce_iterate;
@@ -776,6 +1018,10 @@ ML_FUNCTIONX(Reduce) {
 	} else {
 		ML_CHECKX_ARG_TYPE(1, MLSequenceT);
 		ML_CHECKX_ARG_TYPE(2, MLFunctionT);
+		ml_value_t *Result = ml_iter_reduce(Args[1], Args[2], Args[0]);
+		if (Result) ML_RETURN(Result);
+		ml_reduce_block_state_t *Block = reduce_block(Caller, Args[1], Args[2], Args[0]);
+		if (Block) return reduce_block_run(Block);
 		ml_iter_state_t *State = xnew(ml_iter_state_t, 3, ml_value_t *);
 		State->Base.Caller = Caller;
 		State->Base.run = (void *)reduce_iterate;
@@ -849,12 +1095,17 @@ ML_FUNCTIONX(Min) {
 // Returns the smallest value (using :mini:`<`) produced by :mini:`Sequence`.
 	ML_CHECKX_ARG_COUNT(1);
 	ML_CHECKX_ARG_TYPE(0, MLSequenceT);
+	ml_value_t *Sequence = ml_chained(Count, Args);
+	ml_value_t *Result = ml_iter_reduce(Sequence, GreaterMethod, NULL);
+	if (Result) ML_RETURN(Result);
+	ml_reduce_block_state_t *Block = reduce_block(Caller, Sequence, GreaterMethod, NULL);
+	if (Block) return reduce_block_run(Block);
 	ml_iter_state_t *State = xnew(ml_iter_state_t, 3, ml_value_t *);
 	State->Base.Caller = Caller;
 	State->Base.run = (void *)reduce_iterate;
 	State->Base.Context = Caller->Context;
 	State->Values[0] = GreaterMethod;
-	return ml_iterate((ml_state_t *)State, ml_chained(Count, Args));
+	return ml_iterate((ml_state_t *)State, Sequence);
 }
 
 ML_FUNCTIONX(Max) {
@@ -863,12 +1114,17 @@ ML_FUNCTIONX(Max) {
 // Returns the largest value (using :mini:`>`) produced by :mini:`Sequence`.
 	ML_CHECKX_ARG_COUNT(1);
 	ML_CHECKX_ARG_TYPE(0, MLSequenceT);
+	ml_value_t *Sequence = ml_chained(Count, Args);
+	ml_value_t *Result = ml_iter_reduce(Sequence, LessMethod, NULL);
+	if (Result) ML_RETURN(Result);
+	ml_reduce_block_state_t *Block = reduce_block(Caller, Sequence, LessMethod, NULL);
+	if (Block) return reduce_block_run(Block);
 	ml_iter_state_t *State = xnew(ml_iter_state_t, 3, ml_value_t *);
 	State->Base.Caller = Caller;
 	State->Base.run = (void *)reduce_iterate;
 	State->Base.Context = Caller->Context;
 	State->Values[0] = LessMethod;
-	return ml_iterate((ml_state_t *)State, ml_chained(Count, Args));
+	return ml_iterate((ml_state_t *)State, Sequence);
 }
 
 ML_FUNCTIONX(Sum) {
@@ -877,12 +1133,17 @@ ML_FUNCTIONX(Sum) {
 // Returns the sum of the values (using :mini:`+`) produced by :mini:`Sequence`.
 	ML_CHECKX_ARG_COUNT(1);
 	ML_CHECKX_ARG_TYPE(0, MLSequenceT);
+	ml_value_t *Sequence = ml_chained(Count, Args);
+	ml_value_t *Result = ml_iter_reduce(Sequence, AddMethod, NULL);
+	if (Result) ML_RETURN(Result);
+	ml_reduce_block_state_t *Block = reduce_block(Caller, Sequence, AddMethod, NULL);
+	if (Block) return reduce_block_run(Block);
 	ml_iter_state_t *State = xnew(ml_iter_state_t, 3, ml_value_t *);
 	State->Base.Caller = Caller;
 	State->Base.run = (void *)reduce_iterate;
 	State->Base.Context = Caller->Context;
 	State->Values[0] = AddMethod;
-	return ml_iterate((ml_state_t *)State, ml_chained(Count, Args));
+	return ml_iterate((ml_state_t *)State, Sequence);
 }
 
 ML_FUNCTIONX(Prod) {
@@ -891,12 +1152,15 @@ ML_FUNCTIONX(Prod) {
 // Returns the product of the values (using :mini:`*`) produced by :mini:`Sequence`.
 	ML_CHECKX_ARG_COUNT(1);
 	ML_CHECKX_ARG_TYPE(0, MLSequenceT);
+	ml_value_t *Sequence = ml_chained(Count, Args);
+	ml_reduce_block_state_t *Block = reduce_block(Caller, Sequence, MulMethod, NULL);
+	if (Block) return reduce_block_run(Block);
 	ml_iter_state_t *State = xnew(ml_iter_state_t, 3, ml_value_t *);
 	State->Base.Caller = Caller;
 	State->Base.run = (void *)reduce_iterate;
 	State->Base.Context = Caller->Context;
 	State->Values[0] = MulMethod;
-	return ml_iterate((ml_state_t *)State, ml_chained(Count, Args));
+	return ml_iterate((ml_state_t *)State, Sequence);
 }
 
 typedef struct ml_join_state_t {
@@ -910,7 +1174,6 @@ typedef struct ml_join_state_t {
 static void join_append(ml_join_state_t *State, ml_value_t *Value);
 
 static void join_next(ml_join_state_t *State, ml_value_t *Value) {
-	Value = ml_deref(Value);
 	if (ml_is_error(Value)) ML_CONTINUE(State->Base.Caller, Value);
 	if (Value == MLNil) ML_CONTINUE(State->Base.Caller, ml_stringbuffer_value(State->Buffer));
 	ml_stringbuffer_add(State->Buffer, State->Separator, State->SeparatorLength);
@@ -919,6 +1182,7 @@ static void join_next(ml_join_state_t *State, ml_value_t *Value) {
 }
 
 static void join_append(ml_join_state_t *State, ml_value_t *Value) {
+	Value = ml_deref(Value);
 	if (ml_is_error(Value)) ML_CONTINUE(State->Base.Caller, Value);
 	ml_stringbuffer_append(State->Buffer, Value);
 	State->Base.run = (void *)join_next;
@@ -944,6 +1208,21 @@ ML_METHODVX("join", MLSequenceT, MLStringT) {
 	State->Separator = ml_string_value(Args[1]);
 	State->SeparatorLength = ml_string_length(Args[1]);
 	State->Buffer[0] = (ml_stringbuffer_t)ML_STRINGBUFFER_INIT;
+	ml_iter_cursor_t Cursor[1] = {{NULL, 0}};
+	ml_value_t *Values[ML_ITER_BLOCK_SIZE];
+	int Size = ml_iter_block(Args[0], Cursor, NULL, Values, ML_ITER_BLOCK_SIZE);
+	if (Size >= 0) {
+		int First = 1;
+		while (Size > 0) {
+			for (int I = 0; I < Size; ++I) {
+				if (!First) ml_stringbuffer_add(State->Buffer, State->Separator, State->SeparatorLength);
+				ml_stringbuffer_append(State->Buffer, ml_deref(Values[I]));
+				First = 0;
+			}
+			Size = ml_iter_block(Args[0], Cursor, NULL, Values, ML_ITER_BLOCK_SIZE);
+		}
+		ML_RETURN(ml_stringbuffer_value(State->Buffer));
+	}
 	return ml_iterate((ml_state_t *)State, Args[0]);
 }
 
@@ -1314,25 +1593,91 @@ ML_METHOD(">>", MLSequenceT) {
 	return (ml_value_t *)Sequenced;
 }
 
+typedef struct {
+	ml_type_t *Type;
+	ml_value_t *Sequence;
+	ml_iter_cursor_t Cursor[1];
+	int Index, Size;
+	ml_value_t *Keys[ML_ITER_BLOCK_SIZE];
+	ml_value_t *Values[ML_ITER_BLOCK_SIZE];
+} ml_block_iter_t;
+
+ML_TYPE(MLBlockIterT, (), "block-iter");
+//!internal
+
+static void ml_block_iterate(ml_state_t *Caller, ml_value_t *Sequence, ml_iter_cursor_t *Cursor) {
+	// Iterates a sequence through ml_iter_block() starting from an existing cursor (e.g. after ml_iter_seek()).
+	ml_block_iter_t *Iter = new(ml_block_iter_t);
+	Iter->Type = MLBlockIterT;
+	Iter->Sequence = Sequence;
+	*Iter->Cursor = *Cursor;
+	Iter->Size = ml_iter_block(Sequence, Iter->Cursor, Iter->Keys, Iter->Values, ML_ITER_BLOCK_SIZE);
+	if (Iter->Size <= 0) ML_RETURN(MLNil);
+	ML_RETURN(Iter);
+}
+
+static void ML_TYPED_FN(ml_iter_next, MLBlockIterT, ml_state_t *Caller, ml_block_iter_t *Iter) {
+	if (++Iter->Index < Iter->Size) ML_RETURN(Iter);
+	Iter->Size = ml_iter_block(Iter->Sequence, Iter->Cursor, Iter->Keys, Iter->Values, ML_ITER_BLOCK_SIZE);
+	if (Iter->Size <= 0) ML_RETURN(MLNil);
+	Iter->Index = 0;
+	ML_RETURN(Iter);
+}
+
+static void ML_TYPED_FN(ml_iter_key, MLBlockIterT, ml_state_t *Caller, ml_block_iter_t *Iter) {
+	ML_RETURN(Iter->Keys[Iter->Index]);
+}
+
+static void ML_TYPED_FN(ml_iter_value, MLBlockIterT, ml_state_t *Caller, ml_block_iter_t *Iter) {
+	ML_RETURN(Iter->Values[Iter->Index]);
+}
+
 typedef struct ml_limited_t {
 	ml_type_t *Type;
 	ml_value_t *Value;
-	int Remaining;
+	long Remaining;
 } ml_limited_t;
 
 ML_TYPE(MLLimitedT, (MLSequenceT), "limited");
 //!internal
 
+static long ML_TYPED_FN(ml_iter_seek, MLLimitedT, ml_limited_t *Limited, ml_iter_cursor_t *Cursor, long Index) {
+	ml_iter_cursor_t *Inner = new(ml_iter_cursor_t);
+	long Length = ml_iter_seek(Limited->Value, Inner, Index);
+	if (Length < 0) return -1;
+	if (Length > Limited->Remaining) Length = Limited->Remaining;
+	Cursor->Node = Inner;
+	Cursor->Index = Index < Length ? Index : Length;
+	return Length;
+}
+
+static int ML_TYPED_FN(ml_iter_block, MLLimitedT, ml_limited_t *Limited, ml_iter_cursor_t *Cursor, ml_value_t **Keys, ml_value_t **Values, int Size) {
+	ml_iter_cursor_t *Inner = Cursor->Node;
+	if (!Inner) {
+		if (!ml_typed_fn_get(ml_typeof(Limited->Value), ml_iter_block)) return -1;
+		Cursor->Node = Inner = new(ml_iter_cursor_t);
+	}
+	long Remaining = Limited->Remaining - Cursor->Index;
+	if (Remaining <= 0) return 0;
+	if (Size > Remaining) Size = Remaining;
+	int Count = ml_iter_block(Limited->Value, Inner, Keys, Values, Size);
+	if (Count > 0) Cursor->Index += Count;
+	return Count;
+}
+
 ML_METHOD("count", MLLimitedT) {
 //!internal
 	ml_limited_t *Limited = (ml_limited_t *)Args[0];
+	ml_iter_cursor_t Cursor[1] = {{NULL, 0}};
+	long Length = ml_iter_seek(Limited->Value, Cursor, LONG_MAX);
+	if (Length >= 0 && Length < Limited->Remaining) return ml_integer(Length);
 	return ml_integer(Limited->Remaining);
 }
 
 typedef struct ml_limited_state_t {
 	ml_state_t Base;
 	ml_value_t *Iter;
-	int Remaining;
+	long Remaining;
 } ml_limited_state_t;
 
 ML_TYPE(MLLimitedStateT, (), "limited-state");
@@ -1378,16 +1723,22 @@ static void ML_TYPED_FN(ml_iter_next, MLLimitedStateT, ml_state_t *Caller, ml_li
 	}
 }
 
+ml_value_t *ml_limited(ml_value_t *Value, long Limit) {
+	ml_limited_t *Limited = new(ml_limited_t);
+	Limited->Type = MLLimitedT;
+	Limited->Value = Value;
+	Limited->Remaining = Limit;
+	return (ml_value_t *)Limited;
+}
+
 ML_METHOD("limit", MLSequenceT, MLIntegerT) {
 //<Sequence
 //<Limit
 //>sequence
 // Returns an sequence that produces at most :mini:`Limit` values from :mini:`Sequence`.
-	ml_limited_t *Limited = new(ml_limited_t);
-	Limited->Type = MLLimitedT;
-	Limited->Value = Args[0];
-	Limited->Remaining = ml_integer_value_fast(Args[1]);
-	return (ml_value_t *)Limited;
+	int64_t Limit = ml_integer_value_fast(Args[1]);
+	if (Limit < 0) return ml_error("ValueError", "Limit must be non-negative");
+	return ml_limited(Args[0], Limit);
 }
 
 typedef struct ml_skipped_t {
@@ -1415,7 +1766,34 @@ static void skipped_iterate(ml_skipped_state_t *State, ml_value_t *Value) {
 	}
 }
 
+static long ML_TYPED_FN(ml_iter_seek, MLSkippedT, ml_skipped_t *Skipped, ml_iter_cursor_t *Cursor, long Index) {
+	ml_iter_cursor_t *Inner = new(ml_iter_cursor_t);
+	long Skip = Skipped->Remaining;
+	long Length = ml_iter_seek(Skipped->Value, Inner, Index < LONG_MAX - Skip ? Skip + Index : LONG_MAX);
+	if (Length < 0) return -1;
+	Length = Length > Skip ? Length - Skip : 0;
+	Cursor->Node = Inner;
+	Cursor->Index = Index < Length ? Index : Length;
+	return Length;
+}
+
+static int ML_TYPED_FN(ml_iter_block, MLSkippedT, ml_skipped_t *Skipped, ml_iter_cursor_t *Cursor, ml_value_t **Keys, ml_value_t **Values, int Size) {
+	ml_iter_cursor_t *Inner = Cursor->Node;
+	if (!Inner) {
+		Inner = new(ml_iter_cursor_t);
+		if (ml_iter_seek(Skipped->Value, Inner, Skipped->Remaining) < 0) return -1;
+		Cursor->Node = Inner;
+	}
+	int Count = ml_iter_block(Skipped->Value, Inner, Keys, Values, Size);
+	if (Count > 0) Cursor->Index += Count;
+	return Count;
+}
+
 static void ML_TYPED_FN(ml_iterate, MLSkippedT, ml_state_t *Caller, ml_skipped_t *Skipped) {
+	if (Skipped->Remaining) {
+		ml_iter_cursor_t Cursor[1] = {{NULL, 0}};
+		if (ml_iter_seek(Skipped->Value, Cursor, Skipped->Remaining) >= 0) return ml_block_iterate(Caller, Skipped->Value, Cursor);
+	}
 	if (Skipped->Remaining) {
 		ml_skipped_state_t *State = new(ml_skipped_state_t);
 		State->Base.Caller = Caller;
@@ -1433,10 +1811,12 @@ ML_METHOD("skip", MLSequenceT, MLIntegerT) {
 //<Skip
 //>sequence
 // Returns an sequence that skips the first :mini:`Skip` values from :mini:`Sequence` and then produces the rest.
+	int64_t Skip = ml_integer_value_fast(Args[1]);
+	if (Skip < 0) return ml_error("ValueError", "Skip must be non-negative");
 	ml_skipped_t *Skipped = new(ml_skipped_t);
 	Skipped->Type = MLSkippedT;
 	Skipped->Value = Args[0];
-	Skipped->Remaining = ml_integer_value_fast(Args[1]);
+	Skipped->Remaining = Skip;
 	return (ml_value_t *)Skipped;
 }
 
@@ -1451,6 +1831,8 @@ static void ml_tasks_call(ml_state_t *Caller, ml_tasks_t *Tasks, int Count, ml_v
 	if (!Tasks->Waiting) ML_ERROR("TasksError", "Tasks have already completed");
 	if (Tasks->Value != MLNil) ML_RETURN(Tasks->Value);
 	ML_CHECKX_ARG_TYPE(Count - 1, MLFunctionT);
+	ml_value_t *Error = ml_cancel_check(Caller->Context);
+	if (Error) ML_RETURN(Error);
 	ml_value_t *Function = Args[Count - 1];
 	++Tasks->Waiting;
 	ml_call(Tasks, Function, Count - 1, Args);
@@ -1523,6 +1905,8 @@ ML_METHODVX("add", MLTasksT, MLAnyT) {
 	if (!Tasks->Waiting) ML_ERROR("TasksError", "Tasks have already completed");
 	if (Tasks->Value != MLNil) ML_RETURN(Tasks->Value);
 	ML_CHECKX_ARG_TYPE(Count - 1, MLFunctionT);
+	ml_value_t *Error = ml_cancel_check(Caller->Context);
+	if (Error) ML_RETURN(Error);
 	ml_value_t *Function = Args[Count - 1];
 	++Tasks->Waiting;
 	ml_call(Tasks, Function, Count - 2, Args + 1);
@@ -1583,6 +1967,11 @@ static void parallel_iter_value(ml_state_t *State, ml_value_t *Value) {
 	ml_parallel_t *Parallel = (ml_parallel_t *)((char *)State - offsetof(ml_parallel_t, ValueState));
 	if (Parallel->Error) return;
 	Parallel->Args[1] = Value;
+	ml_value_t *Error = ml_cancel_check(Parallel->Base.Context);
+	if (Error) {
+		Parallel->Error = Error;
+		ML_CONTINUE(Parallel->Base.Caller, Error);
+	}
 	Parallel->Calling = 1;
 	ml_call(Parallel, Parallel->Function, 2, Parallel->Args);
 	Parallel->Calling = 0;
@@ -1657,6 +2046,351 @@ ML_FUNCTIONX(Parallel) {
 	return ml_iterate(Parallel->NextState, Args[0]);
 }
 
+#ifdef ML_THREADSAFE
+
+#include <pthread.h>
+#include <unistd.h>
+
+typedef struct ml_thread_group_t ml_thread_group_t;
+typedef struct ml_thread_job_t ml_thread_job_t;
+
+struct ml_thread_job_t {
+	ml_thread_job_t *Next;
+	ml_thread_group_t *Group;
+	ml_value_t *Function, *Result;
+	ml_value_t **Args;
+	size_t Index;
+	int Count;
+};
+
+struct ml_thread_group_t {
+	ml_state_t Base;
+	pthread_mutex_t Lock[1];
+	ml_context_t *Context;
+	ml_thread_job_t *Completed;
+	ml_scheduler_queue_t *Queue;
+	ml_value_t *Error, *Result;
+	size_t Running, Added, ErrorIndex, Resume;
+};
+
+static pthread_once_t ThreadPoolOnce = PTHREAD_ONCE_INIT;
+static pthread_mutex_t ThreadPoolLock[1] = {PTHREAD_MUTEX_INITIALIZER};
+static pthread_cond_t ThreadPoolReady[1] = {PTHREAD_COND_INITIALIZER};
+static ml_thread_job_t *ThreadPoolHead = NULL, **ThreadPoolTail = &ThreadPoolHead;
+
+static __thread unsigned int ThreadCounter = UINT_MAX;
+
+static void ml_thread_swap(ml_state_t *State, ml_value_t *Value) {
+	ThreadCounter = UINT_MAX;
+	return State->run(State, Value);
+}
+
+static ml_schedule_t ml_thread_scheduler(ml_context_t *Context) {
+	return (ml_schedule_t){&ThreadCounter, ml_thread_swap};
+}
+
+static void *ml_thread_worker(void *Arg) {
+	// Each worker has its own scheduler queue so that tasks can sleep or wait on thread channels and semaphores.
+	ml_scheduler_queue_init(4);
+	for (;;) {
+		pthread_mutex_lock(ThreadPoolLock);
+		while (!ThreadPoolHead) pthread_cond_wait(ThreadPoolReady, ThreadPoolLock);
+		ml_thread_job_t *Job = ThreadPoolHead;
+		if (!(ThreadPoolHead = Job->Next)) ThreadPoolTail = &ThreadPoolHead;
+		pthread_mutex_unlock(ThreadPoolLock);
+		ml_thread_group_t *Group = Job->Group;
+		// Jobs queued before their group was cancelled are dropped without being started.
+		if (!(Job->Result = ml_cancel_check(Group->Context))) {
+			ml_result_state_t *State = ml_result_state_new(Group->Context);
+			State->Value = NULL;
+			ml_call(State, Job->Function, Job->Count, Job->Args);
+			// Run this worker's queue until the task completes, the worker is not given another job while it waits.
+			while (!State->Value) {
+				ml_queued_state_t QueuedState = ml_scheduler_queue_next();
+				if (QueuedState.State) {
+					QueuedState.State->run(QueuedState.State, QueuedState.Value);
+				} else if (!ml_scheduler_queue_wait()) {
+					break;
+				}
+			}
+			Job->Result = State->Value ?: ml_error("TasksError", "Task can never complete within its thread");
+		}
+		pthread_mutex_lock(Group->Lock);
+		Job->Next = Group->Completed;
+		Group->Completed = Job;
+		ml_scheduler_queue_t *Queue = Group->Queue;
+		Group->Queue = NULL;
+		pthread_mutex_unlock(Group->Lock);
+		// The waiting state is resumed on its own thread's scheduler queue.
+		if (Queue) ml_scheduler_queue_add_signal(Queue, (ml_state_t *)Group, MLNil);
+	}
+	return NULL;
+}
+
+static void ml_thread_pool_start() {
+	long Size = sysconf(_SC_NPROCESSORS_ONLN);
+	if (Size < 1) Size = 1;
+	for (long I = 0; I < Size; ++I) {
+		pthread_t Thread;
+		pthread_create(&Thread, NULL, ml_thread_worker, NULL);
+		pthread_detach(Thread);
+	}
+}
+
+static void ml_thread_group_continue(ml_thread_group_t *Group, ml_value_t *Value);
+
+static ml_thread_group_t *ml_thread_group_new(ml_context_t *Context) {
+	pthread_once(&ThreadPoolOnce, ml_thread_pool_start);
+	ml_thread_group_t *Group = new(ml_thread_group_t);
+	Group->Base.run = (ml_state_fn)ml_thread_group_continue;
+	pthread_mutex_init(Group->Lock, NULL);
+	Group->Context = ml_context_new(Context);
+	ml_context_set(Group->Context, ML_SCHEDULER_INDEX, ml_thread_scheduler);
+	return Group;
+}
+
+static void ml_thread_group_add(ml_thread_group_t *Group, ml_value_t *Function, int Count, ml_value_t **Args) {
+	ml_thread_job_t *Job = new(ml_thread_job_t);
+	Job->Group = Group;
+	Job->Function = Function;
+	Job->Count = Count;
+	Job->Args = anew(ml_value_t *, Count);
+	for (int I = 0; I < Count; ++I) Job->Args[I] = ml_deref(Args[I]);
+	Job->Index = Group->Added++;
+	++Group->Running;
+	pthread_mutex_lock(ThreadPoolLock);
+	*ThreadPoolTail = Job;
+	ThreadPoolTail = &Job->Next;
+	pthread_cond_signal(ThreadPoolReady);
+	pthread_mutex_unlock(ThreadPoolLock);
+}
+
+static void ml_thread_group_collect(ml_thread_group_t *Group, ml_thread_job_t *Job) {
+	for (; Job; Job = Job->Next) {
+		--Group->Running;
+		// Keep the error from the earliest task so the result does not depend on thread timing.
+		if (ml_is_error(Job->Result) && (!Group->Error || Job->Index < Group->ErrorIndex)) {
+			Group->Error = Job->Result;
+			Group->ErrorIndex = Job->Index;
+		}
+	}
+}
+
+static void ml_thread_group_wait(ml_state_t *Caller, ml_thread_group_t *Group, size_t Resume, ml_value_t *Result) {
+	// Resumes Caller with Result (or the earliest error) once at most Resume tasks are running.
+	// Rather than blocking the thread, the caller is parked on its scheduler queue until a worker signals a completed task.
+	for (;;) {
+		pthread_mutex_lock(Group->Lock);
+		ml_thread_job_t *Job = Group->Completed;
+		Group->Completed = NULL;
+		if (!Job && Group->Running > Resume) {
+			if (Group->Base.Caller) {
+				pthread_mutex_unlock(Group->Lock);
+				ML_ERROR("TasksError", "Tasks are already being waited on");
+			}
+			ml_scheduler_queue_t *Queue = ml_scheduler_queue_park();
+			if (!Queue) {
+				pthread_mutex_unlock(Group->Lock);
+				ML_ERROR("TasksError", "No scheduler queue on this thread");
+			}
+			Group->Base.Caller = Caller;
+			Group->Base.Context = Caller->Context;
+			Group->Queue = Queue;
+			Group->Resume = Resume;
+			Group->Result = Result;
+			pthread_mutex_unlock(Group->Lock);
+			return;
+		}
+		pthread_mutex_unlock(Group->Lock);
+		ml_thread_group_collect(Group, Job);
+		if (Group->Running <= Resume) {
+			if (!ml_is_error(Result) && Group->Error) Result = Group->Error;
+			ML_RETURN(Result);
+		}
+	}
+}
+
+static void ml_thread_group_continue(ml_thread_group_t *Group, ml_value_t *Value) {
+	ml_state_t *Caller = Group->Base.Caller;
+	Group->Base.Caller = NULL;
+	return ml_thread_group_wait(Caller, Group, Group->Resume, Group->Result);
+}
+
+static void ml_thread_group_poll(ml_thread_group_t *Group) {
+	pthread_mutex_lock(Group->Lock);
+	ml_thread_job_t *Job = Group->Completed;
+	Group->Completed = NULL;
+	pthread_mutex_unlock(Group->Lock);
+	ml_thread_group_collect(Group, Job);
+}
+
+typedef struct {
+	ml_type_t *Type;
+	ml_thread_group_t *Group;
+	size_t Limit, Resume;
+} ml_thread_tasks_t;
+
+extern ml_type_t MLThreadTasksT[];
+
+static void ml_thread_tasks_add(ml_state_t *Caller, ml_thread_tasks_t *Tasks, ml_value_t *Function, int Count, ml_value_t **Args) {
+	ml_thread_group_t *Group = Tasks->Group;
+	ml_thread_group_poll(Group);
+	if (Group->Error) ML_RETURN(Group->Error);
+	ml_thread_group_add(Group, Function, Count, Args);
+	if (Group->Running >= Tasks->Limit && !Group->Base.Caller) {
+		return ml_thread_group_wait(Caller, Group, Tasks->Resume, (ml_value_t *)Tasks);
+	}
+	ML_RETURN(Tasks);
+}
+
+static void ml_thread_tasks_call(ml_state_t *Caller, ml_thread_tasks_t *Tasks, int Count, ml_value_t **Args) {
+	ML_CHECKX_ARG_COUNT(1);
+	ML_CHECKX_ARG_TYPE(Count - 1, MLFunctionT);
+	return ml_thread_tasks_add(Caller, Tasks, Args[Count - 1], Count - 1, Args);
+}
+
+ML_FUNCTIONX(ThreadTasks) {
+//@tasks::threads
+//<Max?:integer
+//<Min?:integer
+//>tasks
+// Creates a new :mini:`tasks` set whose functions are called on a shared pool of threads, one per processor.
+// :mini:`Max` and :mini:`Min` limit the number of running tasks as in :mini:`tasks`, suspending the adding state (but not its thread) until enough tasks have returned.
+// Functions can sleep or wait on thread channels and semaphores but hold their thread while suspended, so tasks that wait on each other need enough threads. They must not modify shared values.
+	ml_thread_tasks_t *Tasks = new(ml_thread_tasks_t);
+	Tasks->Type = MLThreadTasksT;
+	Tasks->Group = ml_thread_group_new(Caller->Context);
+	if (Count > 1) {
+		ML_CHECKX_ARG_TYPE(0, MLIntegerT);
+		ML_CHECKX_ARG_TYPE(1, MLIntegerT);
+		Tasks->Limit = ml_integer_value_fast(Args[1]);
+		Tasks->Resume = ml_integer_value_fast(Args[0]);
+	} else if (Count > 0) {
+		ML_CHECKX_ARG_TYPE(0, MLIntegerT);
+		Tasks->Limit = ml_integer_value_fast(Args[0]);
+		Tasks->Resume = Tasks->Limit - 1;
+	} else {
+		Tasks->Limit = SIZE_MAX;
+		Tasks->Resume = SIZE_MAX;
+	}
+	if (!Tasks->Limit) Tasks->Limit = 1;
+	ML_RETURN(Tasks);
+}
+
+ML_TYPE(MLThreadTasksT, (MLFunctionT), "thread-tasks",
+//!tasks
+// A set of tasks (function calls) run on a pool of threads.
+	.call = (void *)ml_thread_tasks_call
+);
+
+ML_METHODVX("add", MLThreadTasksT, MLAnyT) {
+//!tasks
+//<Tasks
+//<Args...:any
+//<Function:function
+//>tasks | error
+// Adds the function call :mini:`Function(Args...)` to a set of threaded tasks.
+	ML_CHECKX_ARG_TYPE(Count - 1, MLFunctionT);
+	ml_thread_tasks_t *Tasks = (ml_thread_tasks_t *)Args[0];
+	return ml_thread_tasks_add(Caller, Tasks, Args[Count - 1], Count - 2, Args + 1);
+}
+
+ML_METHODX("wait", MLThreadTasksT) {
+//!tasks
+//<Tasks
+//>nil | error
+// Waits until all of the tasks in a set of threaded tasks have returned.
+// If any task returned an error, the error from the earliest added task is returned.
+	ml_thread_tasks_t *Tasks = (ml_thread_tasks_t *)Args[0];
+	return ml_thread_group_wait(Caller, Tasks->Group, 0, MLNil);
+}
+
+typedef struct {
+	ml_state_t Base;
+	ml_thread_group_t *Group;
+	ml_value_t *Iter, *Function, *Key;
+	size_t Limit, Resume;
+} ml_thread_parallel_t;
+
+static void thread_parallel_next(ml_thread_parallel_t *State, ml_value_t *Iter);
+
+static void thread_parallel_stop(ml_thread_parallel_t *State, ml_value_t *Value) {
+	return ml_thread_group_wait(State->Base.Caller, State->Group, 0, Value);
+}
+
+static void thread_parallel_resume(ml_thread_parallel_t *State, ml_value_t *Value) {
+	if (ml_is_error(Value)) return thread_parallel_stop(State, Value);
+	State->Base.run = (ml_state_fn)thread_parallel_next;
+	return ml_iter_next((ml_state_t *)State, State->Iter);
+}
+
+static void thread_parallel_value(ml_thread_parallel_t *State, ml_value_t *Value) {
+	ml_thread_group_t *Group = State->Group;
+	if (ml_is_error(Value)) return thread_parallel_stop(State, Value);
+	ml_value_t *Args[2] = {State->Key, Value};
+	ml_thread_group_add(Group, State->Function, 2, Args);
+	ml_thread_group_poll(Group);
+	if (Group->Error) return thread_parallel_stop(State, Group->Error);
+	if (Group->Running >= State->Limit) {
+		State->Base.run = (ml_state_fn)thread_parallel_resume;
+		return ml_thread_group_wait((ml_state_t *)State, Group, State->Resume, MLNil);
+	}
+	State->Base.run = (ml_state_fn)thread_parallel_next;
+	return ml_iter_next((ml_state_t *)State, State->Iter);
+}
+
+static void thread_parallel_key(ml_thread_parallel_t *State, ml_value_t *Value) {
+	if (ml_is_error(Value)) return thread_parallel_stop(State, Value);
+	State->Key = ml_deref(Value);
+	State->Base.run = (ml_state_fn)thread_parallel_value;
+	return ml_iter_value((ml_state_t *)State, State->Iter);
+}
+
+static void thread_parallel_next(ml_thread_parallel_t *State, ml_value_t *Iter) {
+	if (Iter == MLNil) return thread_parallel_stop(State, MLNil);
+	if (ml_is_error(Iter)) return thread_parallel_stop(State, Iter);
+	State->Base.run = (ml_state_fn)thread_parallel_key;
+	return ml_iter_key((ml_state_t *)State, State->Iter = Iter);
+}
+
+ML_FUNCTIONX(ThreadParallel) {
+//@tasks::parallel
+//<Sequence
+//<Max?:integer
+//<Min?:integer
+//<Function:function
+//>nil | error
+// Iterates through :mini:`Sequence` and calls :mini:`Function(Key, Value)` for each :mini:`Key, Value` pair produced on a shared pool of threads, one per processor.
+// :mini:`Max` and :mini:`Min` limit the number of running calls as in :mini:`parallel`.
+// Returns when all calls to :mini:`Function` return. If any call returned an error, the error for the earliest pair in :mini:`Sequence` is returned.
+// :mini:`Function` can suspend as in :mini:`tasks::threads` but must not modify shared values.
+	ML_CHECKX_ARG_COUNT(2);
+	ML_CHECKX_ARG_TYPE(Count - 1, MLFunctionT);
+	ml_thread_parallel_t *State = new(ml_thread_parallel_t);
+	State->Base.Caller = Caller;
+	State->Base.Context = Caller->Context;
+	State->Base.run = (ml_state_fn)thread_parallel_next;
+	State->Group = ml_thread_group_new(Caller->Context);
+	State->Function = Args[Count - 1];
+	if (Count > 3) {
+		ML_CHECKX_ARG_TYPE(1, MLIntegerT);
+		ML_CHECKX_ARG_TYPE(2, MLIntegerT);
+		State->Limit = ml_integer_value_fast(Args[2]);
+		State->Resume = ml_integer_value_fast(Args[1]);
+	} else if (Count > 2) {
+		ML_CHECKX_ARG_TYPE(1, MLIntegerT);
+		State->Limit = ml_integer_value_fast(Args[1]);
+		State->Resume = State->Limit - 1;
+	} else {
+		State->Limit = SIZE_MAX;
+		State->Resume = SIZE_MAX;
+	}
+	if (!State->Limit) State->Limit = 1;
+	return ml_iterate((ml_state_t *)State, Args[0]);
+}
+
+#endif
+
 typedef struct {
 	ml_type_t *Type;
 	ml_value_t *Iter;
@@ -1672,8 +2406,8 @@ typedef struct {
 
 typedef struct {
 	ml_state_t Base;
-	ml_value_t *Iter, *Final;
-	int Read, Write, Ready, Total;
+	ml_value_t *Sequence, *Iter, *Final;
+	int Read, Write, Ready, Total, Fetching;
 	ml_buffered_key_value_t KeyValues[];
 } ml_buffered_state_t;
 
@@ -1682,51 +2416,71 @@ ML_TYPE(MLBufferedStateT, (), "buffered-state");
 
 static void ml_buffered_iterate(ml_buffered_state_t *State, ml_value_t *Value);
 
-static void ml_buffered_value(ml_buffered_state_t *State, ml_value_t *Value) {
+static void ml_buffered_start(ml_buffered_state_t *State, ml_value_t *Value) {
 	State->Base.run = (void *)ml_buffered_iterate;
-	State->KeyValues[State->Write].Value = Value;
-	State->Write = (State->Write + 1) % State->Total;
-	++State->Ready;
-	if (State->Ready < State->Total) {
-		ml_iter_next((ml_state_t *)State, State->Iter);
-	}
+	if (State->Iter) return ml_iter_next((ml_state_t *)State, State->Iter);
+	return ml_iterate((ml_state_t *)State, State->Sequence);
+}
+
+static void ml_buffered_fetch(ml_buffered_state_t *State) {
+	if (State->Fetching || State->Final || State->Ready == State->Total) return;
+	State->Fetching = 1;
+	// The upstream iterator is resumed through the scheduler so that it runs as a separate task, overlapping with the consumer.
+	ml_context_t *Context = State->Base.Context;
+	ml_scheduler_t scheduler = (ml_scheduler_t)Context->Values[ML_SCHEDULER_INDEX];
+	State->Base.run = (void *)ml_buffered_start;
+	return scheduler(Context).swap((ml_state_t *)State, MLNil);
+}
+
+static void ml_buffered_resume(ml_buffered_state_t *State) {
 	ml_state_t *Caller = State->Base.Caller;
-	if (Caller) {
+	if (!Caller) return;
+	if (State->Ready) {
 		State->Base.Caller = NULL;
 		ML_RETURN(State);
+	} else if (State->Final) {
+		State->Base.Caller = NULL;
+		ML_RETURN(State->Final);
 	}
 }
 
+static void ml_buffered_finish(ml_buffered_state_t *State, ml_value_t *Final) {
+	State->Fetching = 0;
+	State->Final = Final;
+	return ml_buffered_resume(State);
+}
+
+static void ml_buffered_value(ml_buffered_state_t *State, ml_value_t *Value) {
+	if (ml_is_error(Value)) return ml_buffered_finish(State, Value);
+	State->KeyValues[State->Write].Value = ml_deref(Value);
+	State->Write = (State->Write + 1) % State->Total;
+	++State->Ready;
+	State->Fetching = 0;
+	ml_buffered_fetch(State);
+	return ml_buffered_resume(State);
+}
+
 static void ml_buffered_key(ml_buffered_state_t *State, ml_value_t *Value) {
-	State->KeyValues[State->Write].Key = Value;
+	if (ml_is_error(Value)) return ml_buffered_finish(State, Value);
+	State->KeyValues[State->Write].Key = ml_deref(Value);
 	State->Base.run = (void *)ml_buffered_value;
 	return ml_iter_value((ml_state_t *)State, State->Iter);
 }
 
 static void ml_buffered_iterate(ml_buffered_state_t *State, ml_value_t *Value) {
-	if (ml_is_error(Value)) {
-		State->Final = Value;
-	} else if (Value == MLNil) {
-		State->Final = MLNil;
-	} else {
-		State->Base.run = (void *)ml_buffered_key;
-		return ml_iter_key((ml_state_t *)State, State->Iter = Value);
-	}
+	if (ml_is_error(Value)) return ml_buffered_finish(State, Value);
+	if (Value == MLNil) return ml_buffered_finish(State, MLNil);
+	State->Base.run = (void *)ml_buffered_key;
+	return ml_iter_key((ml_state_t *)State, State->Iter = Value);
 }
 
 static void ML_TYPED_FN(ml_iter_next, MLBufferedStateT, ml_state_t *Caller, ml_buffered_state_t *State) {
+	State->KeyValues[State->Read].Key = State->KeyValues[State->Read].Value = NULL;
 	State->Read = (State->Read + 1) % State->Total;
 	--State->Ready;
-	if (!State->Final) {
-		ml_iter_next((ml_state_t *)State, State->Iter);
-	}
-	if (State->Ready) {
-		ML_RETURN(State);
-	} else if (State->Final) {
-		ML_RETURN(State->Final);
-	} else {
-		State->Base.Caller = Caller;
-	}
+	ml_buffered_fetch(State);
+	State->Base.Caller = Caller;
+	return ml_buffered_resume(State);
 }
 
 static void ML_TYPED_FN(ml_iter_key, MLBufferedStateT, ml_state_t *Caller, ml_buffered_state_t *State) {
@@ -1740,34 +2494,193 @@ static void ML_TYPED_FN(ml_iter_value, MLBufferedStateT, ml_state_t *Caller, ml_
 static void ML_TYPED_FN(ml_iterate, MLBufferedT, ml_state_t *Caller, ml_buffered_t *Buffered) {
 	ml_buffered_state_t *State = xnew(ml_buffered_state_t, Buffered->Total, ml_buffered_key_value_t);
 	State->Base.Type = MLBufferedStateT;
-	State->Base.run = (void *)ml_buffered_iterate;
 	State->Base.Context = Caller->Context;
+	State->Sequence = Buffered->Iter;
 	State->Total = Buffered->Total;
-	State->Read = State->Write = State->Ready = 0;
-	ml_iterate((ml_state_t *)State, Buffered->Iter);
-	if (State->Ready) {
-		ML_RETURN(State);
-	} else if (State->Final) {
-		ML_RETURN(State->Final);
-	} else {
-		State->Base.Caller = Caller;
-	}
+	ml_buffered_fetch(State);
+	State->Base.Caller = Caller;
+	return ml_buffered_resume(State);
 }
 
 ML_FUNCTION(Buffered) {
 //<Size:integer
 //<Sequence
 //>Sequence
-// Returns an sequence that buffers the keys and values from :mini:`Sequence` in advance, buffering at most :mini:`Size` pairs.
+// Returns an sequence that reads the keys and values from :mini:`Sequence` ahead of time, buffering at most :mini:`Size` pairs.
+// Reading ahead runs as a separate task through the current scheduler, so slow (e.g. asynchronous I/O) steps in :mini:`Sequence` overlap with processing of the values already buffered.
 	ML_CHECK_ARG_COUNT(2);
 	ML_CHECK_ARG_TYPE(0, MLIntegerT);
+	int Total = ml_integer_value(Args[0]);
+	if (Total < 1) return ml_error("ValueError", "Buffer size must be positive");
 	ml_buffered_t *Buffered = new(ml_buffered_t);
 	Buffered->Type = MLBufferedT;
-	Buffered->Total = ml_integer_value(Args[0]);
+	Buffered->Total = Total;
 	Buffered->Iter = ml_chained(Count - 1, Args + 1);
 	return (ml_value_t *)Buffered;
 }
 
+extern ml_value_t *CompareMethod;
+
+typedef struct {
+	ml_value_t *Key, *Value;
+	long Hash, Count;
+} ml_group_entry_t;
+
+typedef struct {
+	ml_group_entry_t *Entries;
+	int *Slots;
+	int Size, Mask;
+} ml_groups_t;
+
+// Tables are preallocated for sequences with a known length, up to a limit since there may be far fewer keys than values.
+#define ML_GROUPS_PREALLOCATE (1 << 16)
+
+static void ml_groups_init(ml_groups_t *Groups, int Capacity) {
+	int Space = 16;
+	while (Space < 2 * Capacity) Space *= 2;
+	Groups->Mask = Space - 1;
+	Groups->Size = 0;
+	Groups->Slots = anew(int, Space);
+	Groups->Entries = anew(ml_group_entry_t, Space / 2);
+}
+
+static void ml_groups_grow(ml_groups_t *Groups) {
+	int Space = 2 * (Groups->Mask + 1);
+	int Mask = Space - 1;
+	int *Slots = anew(int, Space);
+	ml_group_entry_t *Entries = anew(ml_group_entry_t, Space / 2);
+	memcpy(Entries, Groups->Entries, Groups->Size * sizeof(ml_group_entry_t));
+	for (int I = 0; I < Groups->Size; ++I) {
+		int Index = Entries[I].Hash & Mask;
+		while (Slots[Index]) Index = (Index + 1) & Mask;
+		Slots[Index] = I + 1;
+	}
+	Groups->Slots = Slots;
+	Groups->Entries = Entries;
+	Groups->Mask = Mask;
+}
+
+static ml_group_entry_t *ml_groups_insert(ml_groups_t *Groups, ml_value_t *Key, int *Created) {
+	long Hash = ml_typeof(Key)->hash(Key, NULL);
+	int Mask = Groups->Mask, Index = Hash & Mask;
+	while (Groups->Slots[Index]) {
+		ml_group_entry_t *Entry = Groups->Entries + Groups->Slots[Index] - 1;
+		if (Entry->Key == Key) goto found;
+		if (Entry->Hash == Hash) {
+			ml_value_t *Args[2] = {Key, Entry->Key};
+			ml_value_t *Result = ml_simple_call(CompareMethod, 2, Args);
+			if (!ml_is_error(Result) && !ml_integer_value(Result)) goto found;
+		}
+		Index = (Index + 1) & Mask;
+		continue;
+	found:
+		*Created = 0;
+		return Entry;
+	}
+	ml_group_entry_t *Entry = Groups->Entries + Groups->Size;
+	Groups->Slots[Index] = ++Groups->Size;
+	Entry->Key = Key;
+	Entry->Hash = Hash;
+	*Created = 1;
+	if (2 * Groups->Size > Mask) {
+		ml_groups_grow(Groups);
+		Entry = Groups->Entries + Groups->Size - 1;
+	}
+	return Entry;
+}
+
+typedef enum {ML_GROUP_LIST, ML_GROUP_COUNT} ml_group_kind_t;
+
+typedef struct {
+	ml_state_t Base;
+	ml_value_t *Iter, *Function, *Value;
+	ml_group_kind_t Kind;
+	ml_groups_t Groups[1];
+} ml_group_state_t;
+
+static void ml_group_iterate(ml_group_state_t *State, ml_value_t *Value);
+
+static void ml_group_key(ml_group_state_t *State, ml_value_t *Key) {
+	Key = ml_deref(Key);
+	if (ml_is_error(Key)) ML_CONTINUE(State->Base.Caller, Key);
+	int Created;
+	ml_group_entry_t *Entry = ml_groups_insert(State->Groups, Key, &Created);
+	if (State->Kind == ML_GROUP_LIST) {
+		if (Created) Entry->Value = ml_list();
+		ml_list_put(Entry->Value, State->Value);
+	} else {
+		++Entry->Count;
+	}
+	State->Base.run = (void *)ml_group_iterate;
+	return ml_iter_next((ml_state_t *)State, State->Iter);
+}
+
+static void ml_group_value(ml_group_state_t *State, ml_value_t *Value) {
+	Value = ml_deref(Value);
+	if (ml_is_error(Value)) ML_CONTINUE(State->Base.Caller, Value);
+	State->Value = Value;
+	if (!State->Function) return ml_group_key(State, Value);
+	State->Base.run = (void *)ml_group_key;
+	return ml_call(State, State->Function, 1, &State->Value);
+}
+
+static void ml_group_iterate(ml_group_state_t *State, ml_value_t *Value) {
+	if (ml_is_error(Value)) ML_CONTINUE(State->Base.Caller, Value);
+	if (Value == MLNil) {
+		// Keys are already distinct with known hashes, so the map is built directly instead of by repeated insertion.
+		int Size = State->Groups->Size;
+		ml_map_node_t **Nodes = anew(ml_map_node_t *, Size);
+		ml_group_entry_t *Entry = State->Groups->Entries;
+		for (int I = 0; I < Size; ++I, ++Entry) {
+			ml_map_node_t *Node = Nodes[I] = new(ml_map_node_t);
+			Node->Key = Entry->Key;
+			Node->Hash = Entry->Hash;
+			Node->Value = State->Kind == ML_GROUP_LIST ? Entry->Value : ml_integer(Entry->Count);
+		}
+		ML_CONTINUE(State->Base.Caller, ml_map_from_nodes(Nodes, Size));
+	}
+	State->Base.run = (void *)ml_group_value;
+	return ml_iter_value((ml_state_t *)State, State->Iter = Value);
+}
+
+static void ml_group(ml_state_t *Caller, ml_group_kind_t Kind, int Count, ml_value_t **Args) {
+	ml_group_state_t *State = new(ml_group_state_t);
+	State->Base.Caller = Caller;
+	State->Base.run = (void *)ml_group_iterate;
+	State->Base.Context = Caller->Context;
+	State->Kind = Kind;
+	ml_iter_cursor_t Cursor[1] = {{NULL, 0}};
+	long Length = ml_iter_seek(Args[0], Cursor, LONG_MAX);
+	ml_groups_init(State->Groups, Length < 0 ? 0 : Length < ML_GROUPS_PREALLOCATE ? Length : ML_GROUPS_PREALLOCATE);
+	if (Count > 1) {
+		ML_CHECKX_ARG_TYPE(Count - 1, MLFunctionT);
+		State->Function = Args[Count - 1];
+		return ml_iterate((ml_state_t *)State, ml_chained(Count - 1, Args));
+	}
+	return ml_iterate((ml_state_t *)State, Args[0]);
+}
+
+ML_FUNCTIONX(Group) {
+//<Sequence
+//<Fn?:function
+//>map
+// Returns a map of lists, grouping the values produced by :mini:`Sequence` by :mini:`Fn(Value)` (or by the value itself if :mini:`Fn` is omitted).
+// Groups appear in the order their keys are first produced and each list keeps its values in order.
+	ML_CHECKX_ARG_COUNT(1);
+	ML_CHECKX_ARG_TYPE(0, MLSequenceT);
+	return ml_group(Caller, ML_GROUP_LIST, Count, Args);
+}
+
+ML_FUNCTIONX(CountBy) {
+//<Sequence
+//<Fn?:function
+//>map
+// Returns a map from each distinct :mini:`Fn(Value)` (or value if :mini:`Fn` is omitted) for the values produced by :mini:`Sequence` to the number of times it occurs.
+	ML_CHECKX_ARG_COUNT(1);
+	ML_CHECKX_ARG_TYPE(0, MLSequenceT);
+	return ml_group(Caller, ML_GROUP_COUNT, Count, Args);
+}
+
 typedef struct ml_unique_t {
 	ml_type_t *Type;
 	ml_value_t *Iter;
@@ -1779,8 +2692,8 @@ ML_TYPE(MLUniqueT, (MLSequenceT), "unique");
 typedef struct ml_unique_state_t {
 	ml_state_t Base;
 	ml_value_t *Iter;
-	ml_value_t *History;
 	ml_value_t *Value;
+	ml_groups_t History[1];
 	int Iteration;
 } ml_unique_state_t;
 
@@ -1792,7 +2705,9 @@ static void ml_unique_fnx_iterate(ml_unique_state_t *State, ml_value_t *Value);
 static void ml_unique_fnx_value(ml_unique_state_t *State, ml_value_t *Value) {
 	Value = ml_deref(Value);
 	if (ml_is_error(Value)) ML_CONTINUE(State->Base.Caller, Value);
-	if (ml_map_insert(State->History, Value, MLSome) == MLNil) {
+	int Created;
+	ml_groups_insert(State->History, Value, &Created);
+	if (Created) {
 		State->Value = Value;
 		++State->Iteration;
 		ML_CONTINUE(State->Base.Caller, State);
@@ -1814,7 +2729,9 @@ static void ML_TYPED_FN(ml_iterate, MLUniqueT, ml_state_t *Caller, ml_unique_t *
 	State->Base.Caller = Caller;
 	State->Base.run = (void *)ml_unique_fnx_iterate;
 	State->Base.Context = Caller->Context;
-	State->History = ml_map();
+	ml_iter_cursor_t Cursor[1] = {{NULL, 0}};
+	long Length = ml_iter_seek(Unique->Iter, Cursor, LONG_MAX);
+	ml_groups_init(State->History, Length < 0 ? 0 : Length < ML_GROUPS_PREALLOCATE ? Length : ML_GROUPS_PREALLOCATE);
 	State->Iteration = 0;
 	return ml_iterate((ml_state_t *)State, Unique->Iter);
 }
@@ -1836,7 +2753,7 @@ static void ML_TYPED_FN(ml_iter_next, MLUniqueStateT, ml_state_t *Caller, ml_uni
 ML_FUNCTION(Unique) {
 //<Sequence
 //>sequence
-// Returns an sequence that returns the unique values produced by :mini:`Sequence`. Uniqueness is determined by using a :mini:`map`.
+// Returns an sequence that returns the unique values produced by :mini:`Sequence`. Uniqueness is determined the same way as for :mini:`map` keys.
 	ML_CHECK_ARG_COUNT(1);
 	ml_unique_t *Unique = new(ml_unique_t);
 	Unique->Type = MLUniqueT;
@@ -2446,6 +3363,223 @@ ML_FUNCTION(Batch) {
 	return (ml_value_t *)Batched;
 }
 
+typedef enum {
+	ML_WINDOW_SUM,
+	ML_WINDOW_MEAN,
+	ML_WINDOW_MIN,
+	ML_WINDOW_MAX
+} ml_window_kind_t;
+
+typedef struct {
+	ml_type_t *Type;
+	ml_value_t *Iter;
+	int Size, Step;
+	ml_window_kind_t Kind;
+} ml_windowed_t;
+
+ML_TYPE(MLWindowedT, (MLSequenceT), "windowed");
+//!internal
+
+typedef struct {
+	ml_state_t Base;
+	ml_value_t *Iter;
+	ml_value_t **Ring;
+	long *Deque;
+	long Count, Iteration;
+	__int128 Sum;
+	double Real, Compensation;
+	int Size, Step, Reals, Head, Length;
+	ml_window_kind_t Kind;
+} ml_windowed_state_t;
+
+ML_TYPE(MLWindowedStateT, (), "windowed-state");
+//!internal
+
+static inline int ml_window_less(ml_value_t *A, ml_value_t *B) {
+	if (ml_is(A, MLIntegerT) && ml_is(B, MLIntegerT)) return ml_integer_value(A) < ml_integer_value(B);
+	return ml_real_value(A) < ml_real_value(B);
+}
+
+static inline void ml_window_add_real(ml_windowed_state_t *State, double Value) {
+	// Neumaier summation, the rounding error of each step is kept in Compensation.
+	double Real = State->Real, Total = Real + Value;
+	if (fabs(Real) >= fabs(Value)) {
+		State->Compensation += (Real - Total) + Value;
+	} else {
+		State->Compensation += (Value - Total) + Real;
+	}
+	State->Real = Total;
+}
+
+static void windowed_iterate(ml_windowed_state_t *State, ml_value_t *Value);
+
+static void windowed_iter_value(ml_windowed_state_t *State, ml_value_t *Value) {
+	Value = ml_deref(Value);
+	if (ml_is_error(Value)) ML_CONTINUE(State->Base.Caller, Value);
+	if (!ml_is(Value, MLNumberT)) {
+		ML_CONTINUE(State->Base.Caller, ml_error("TypeError", "Expected number not %s", ml_typeof(Value)->Name));
+	}
+	int Size = State->Size;
+	long Position = State->Count++;
+	ml_value_t **Slot = State->Ring + Position % Size;
+	if (State->Kind <= ML_WINDOW_MEAN) {
+		// Running sums, integers are kept exact (in 128 bits so they cannot overflow) while any reals are summed separately.
+		ml_value_t *Old = *Slot;
+		if (!Old) {
+		} else if (ml_is(Old, MLIntegerT)) {
+			State->Sum -= ml_integer_value(Old);
+		} else if (--State->Reals) {
+			ml_window_add_real(State, -ml_real_value(Old));
+		} else {
+			State->Real = State->Compensation = 0;
+		}
+		if (ml_is(Value, MLIntegerT)) {
+			State->Sum += ml_integer_value(Value);
+		} else {
+			ml_window_add_real(State, ml_real_value(Value));
+			++State->Reals;
+		}
+		if (State->Reals && Position % Size == 0 && Position) {
+			// The window has been completely replaced, resum the reals so errors cannot build up over long sequences.
+			State->Real = State->Compensation = 0;
+			*Slot = Value;
+			for (int I = 0; I < Size; ++I) {
+				ml_value_t *Entry = State->Ring[I];
+				if (!ml_is(Entry, MLIntegerT)) ml_window_add_real(State, ml_real_value(Entry));
+			}
+		}
+	} else {
+		// Monotonic deque of positions, the front is always the current minimum / maximum.
+		long *Deque = State->Deque;
+		if (State->Length && Deque[State->Head] <= Position - Size) {
+			State->Head = (State->Head + 1) % Size;
+			--State->Length;
+		}
+		int Max = State->Kind == ML_WINDOW_MAX;
+		while (State->Length) {
+			int Tail = (State->Head + State->Length - 1) % Size;
+			ml_value_t *Last = State->Ring[Deque[Tail] % Size];
+			if (Max ? ml_window_less(Value, Last) : ml_window_less(Last, Value)) break;
+			--State->Length;
+		}
+		Deque[(State->Head + State->Length++) % Size] = Position;
+	}
+	*Slot = Value;
+	long Filled = State->Count - Size;
+	if (Filled >= 0 && Filled % State->Step == 0) {
+		++State->Iteration;
+		ML_CONTINUE(State->Base.Caller, State);
+	}
+	State->Base.run = (void *)windowed_iterate;
+	return ml_iter_next((ml_state_t *)State, State->Iter);
+}
+
+static void windowed_iterate(ml_windowed_state_t *State, ml_value_t *Value) {
+	if (ml_is_error(Value)) ML_CONTINUE(State->Base.Caller, Value);
+	if (Value == MLNil) ML_CONTINUE(State->Base.Caller, MLNil);
+	State->Base.run = (void *)windowed_iter_value;
+	return ml_iter_value((ml_state_t *)State, State->Iter = Value);
+}
+
+static void ML_TYPED_FN(ml_iterate, MLWindowedT, ml_state_t *Caller, ml_windowed_t *Windowed) {
+	ml_windowed_state_t *State = new(ml_windowed_state_t);
+	State->Base.Type = MLWindowedStateT;
+	State->Base.Caller = Caller;
+	State->Base.run = (void *)windowed_iterate;
+	State->Base.Context = Caller->Context;
+	State->Size = Windowed->Size;
+	State->Step = Windowed->Step;
+	State->Kind = Windowed->Kind;
+	State->Ring = anew(ml_value_t *, Windowed->Size);
+	if (Windowed->Kind >= ML_WINDOW_MIN) State->Deque = anew(long, Windowed->Size);
+	return ml_iterate((ml_state_t *)State, Windowed->Iter);
+}
+
+static void ML_TYPED_FN(ml_iter_key, MLWindowedStateT, ml_state_t *Caller, ml_windowed_state_t *State) {
+	ML_RETURN(ml_integer(State->Iteration));
+}
+
+static void ML_TYPED_FN(ml_iter_value, MLWindowedStateT, ml_state_t *Caller, ml_windowed_state_t *State) {
+	switch (State->Kind) {
+	case ML_WINDOW_SUM:
+		if (State->Reals) ML_RETURN(ml_real((double)State->Sum + (State->Real + State->Compensation)));
+		if (State->Sum < INT64_MIN || State->Sum > INT64_MAX) ML_RETURN(ml_real((double)State->Sum));
+		ML_RETURN(ml_integer(State->Sum));
+	case ML_WINDOW_MEAN:
+		ML_RETURN(ml_real(((double)State->Sum + (State->Real + State->Compensation)) / State->Size));
+	default:
+		ML_RETURN(State->Ring[State->Deque[State->Head] % State->Size]);
+	}
+}
+
+static void ML_TYPED_FN(ml_iter_next, MLWindowedStateT, ml_state_t *Caller, ml_windowed_state_t *State) {
+	State->Base.Caller = Caller;
+	State->Base.run = (void *)windowed_iterate;
+	return ml_iter_next((ml_state_t *)State, State->Iter);
+}
+
+static ml_value_t *ml_windowed(int Count, ml_value_t **Args, ml_window_kind_t Kind) {
+	ML_CHECK_ARG_COUNT(2);
+	ML_CHECK_ARG_TYPE(0, MLSequenceT);
+	ML_CHECK_ARG_TYPE(1, MLIntegerT);
+	int64_t Size = ml_integer_value(Args[1]), Step = 1;
+	if (Count > 2) {
+		ML_CHECK_ARG_TYPE(2, MLIntegerT);
+		Step = ml_integer_value(Args[2]);
+	}
+	if (Size <= 0 || Size > INT_MAX) return ml_error("ValueError", "Window size must be positive");
+	if (Step <= 0 || Step > INT_MAX) return ml_error("ValueError", "Window step must be positive");
+	ml_windowed_t *Windowed = new(ml_windowed_t);
+	Windowed->Type = MLWindowedT;
+	Windowed->Iter = Args[0];
+	Windowed->Size = Size;
+	Windowed->Step = Step;
+	Windowed->Kind = Kind;
+	return (ml_value_t *)Windowed;
+}
+
+ML_FUNCTION(WindowSum) {
+//@window_sum
+//<Sequence:sequence
+//<Size:integer
+//<Step?:integer
+//>sequence
+// Returns a new sequence that produces the sum of each window of :mini:`Size` consecutive values produced by :mini:`Sequence`, advancing by :mini:`Step` values (default :mini:`1`) between windows. A :mini:`Step` equal to :mini:`Size` gives tumbling windows.
+// The sum is updated incrementally as values enter and leave the window. Integers are summed exactly, producing a real if the sum does not fit in an integer, and reals use compensated summation.
+	return ml_windowed(Count, Args, ML_WINDOW_SUM);
+}
+
+ML_FUNCTION(WindowMean) {
+//@window_mean
+//<Sequence:sequence
+//<Size:integer
+//<Step?:integer
+//>sequence
+// Returns a new sequence that produces the mean of each window of :mini:`Size` consecutive values produced by :mini:`Sequence`, advancing by :mini:`Step` values (default :mini:`1`) between windows.
+	return ml_windowed(Count, Args, ML_WINDOW_MEAN);
+}
+
+ML_FUNCTION(WindowMin) {
+//@window_min
+//<Sequence:sequence
+//<Size:integer
+//<Step?:integer
+//>sequence
+// Returns a new sequence that produces the minimum of each window of :mini:`Size` consecutive values produced by :mini:`Sequence`, advancing by :mini:`Step` values (default :mini:`1`) between windows.
+// Uses a monotonic queue so each value is compared an amortized constant number of times.
+	return ml_windowed(Count, Args, ML_WINDOW_MIN);
+}
+
+ML_FUNCTION(WindowMax) {
+//@window_max
+//<Sequence:sequence
+//<Size:integer
+//<Step?:integer
+//>sequence
+// Returns a new sequence that produces the maximum of each window of :mini:`Size` consecutive values produced by :mini:`Sequence`, advancing by :mini:`Step` values (default :mini:`1`) between windows.
+	return ml_windowed(Count, Args, ML_WINDOW_MAX);
+}
+
 void ml_sequence_init(stringmap_t *Globals) {
 	MLFunctionT->Constructor = (ml_value_t *)MLChained;
 	MLSequenceT->Constructor = (ml_value_t *)MLChained;
@@ -2474,6 +3608,8 @@ void ml_sequence_init(stringmap_t *Globals) {
 		stringmap_insert(Globals, "parallel", Parallel);
 		stringmap_insert(Globals, "buffered", Buffered);
 		stringmap_insert(Globals, "unique", Unique);
+		stringmap_insert(Globals, "group", Group);
+		stringmap_insert(Globals, "count_by", CountBy);
 		stringmap_insert(Globals, "tasks", MLTasksT);
 		stringmap_insert(Globals, "zip", Zip);
 		stringmap_insert(Globals, "pair", Pair);
@@ -2483,5 +3619,13 @@ void ml_sequence_init(stringmap_t *Globals) {
 		stringmap_insert(Globals, "swap", Swap);
 		stringmap_insert(Globals, "key", Key);
 		stringmap_insert(Globals, "batch", Batch);
+		stringmap_insert(Globals, "window_sum", WindowSum);
+		stringmap_insert(Globals, "window_mean", WindowMean);
+		stringmap_insert(Globals, "window_min", WindowMin);
+		stringmap_insert(Globals, "window_max", WindowMax);
 	}
+#ifdef ML_THREADSAFE
+	stringmap_insert(MLTasksT->Exports, "threads", ThreadTasks);
+	stringmap_insert(MLTasksT->Exports, "parallel", ThreadParallel);
+#endif
 }
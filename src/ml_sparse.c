@@ -0,0 +1,762 @@
+#include "ml_sparse.h"
+#include "ml_macros.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+typedef struct {
+	ml_type_t *Type;
+	int Rows, Cols;
+	int *Starts;
+	int *Indices;
+	double *Values;
+} ml_sparse_t;
+
+ML_TYPE(MLSparseT, (), "sparse");
+// A two dimensional sparse matrix with :mini:`float64` values.
+// Entries are stored in compressed sparse row (CSR) form: only nonzero entries take up space, so matrices with millions of rows and columns can be used as long as few entries are nonzero.
+
+static ml_sparse_t *sparse_new(int Rows, int Cols, int Capacity) {
+	ml_sparse_t *Sparse = new(ml_sparse_t);
+	Sparse->Type = MLSparseT;
+	Sparse->Rows = Rows;
+	Sparse->Cols = Cols;
+	Sparse->Starts = (int *)GC_MALLOC_ATOMIC((Rows + 1) * sizeof(int));
+	if (!Capacity) Capacity = 1;
+	Sparse->Indices = (int *)GC_MALLOC_ATOMIC(Capacity * sizeof(int));
+	Sparse->Values = (double *)GC_MALLOC_ATOMIC(Capacity * sizeof(double));
+	return Sparse;
+}
+
+int ml_sparse_rows(ml_value_t *Sparse) {
+	return ((ml_sparse_t *)Sparse)->Rows;
+}
+
+int ml_sparse_cols(ml_value_t *Sparse) {
+	return ((ml_sparse_t *)Sparse)->Cols;
+}
+
+int ml_sparse_count(ml_value_t *Sparse) {
+	ml_sparse_t *A = (ml_sparse_t *)Sparse;
+	return A->Starts[A->Rows];
+}
+
+ml_value_t *ml_sparse_coo(int Rows, int Cols, int Count, const int *RowIndices, const int *ColIndices, const double *Values) {
+	for (int K = 0; K < Count; ++K) {
+		if (RowIndices[K] < 0 || RowIndices[K] >= Rows) return ml_error("IndexError", "Row index out of bounds");
+		if (ColIndices[K] < 0 || ColIndices[K] >= Cols) return ml_error("IndexError", "Column index out of bounds");
+	}
+	// Bucket the entries by column first, then stably by row, so that each row ends up sorted by column.
+	int *ColStarts = (int *)GC_MALLOC_ATOMIC((Cols + 1) * sizeof(int));
+	memset(ColStarts, 0, (Cols + 1) * sizeof(int));
+	for (int K = 0; K < Count; ++K) ++ColStarts[ColIndices[K] + 1];
+	for (int J = 0; J < Cols; ++J) ColStarts[J + 1] += ColStarts[J];
+	int *Order = (int *)GC_MALLOC_ATOMIC((Count + 1) * sizeof(int));
+	for (int K = 0; K < Count; ++K) Order[ColStarts[ColIndices[K]]++] = K;
+	ml_sparse_t *Sparse = sparse_new(Rows, Cols, Count);
+	int *Starts = Sparse->Starts;
+	memset(Starts, 0, (Rows + 1) * sizeof(int));
+	for (int K = 0; K < Count; ++K) ++Starts[RowIndices[K] + 1];
+	for (int I = 0; I < Rows; ++I) Starts[I + 1] += Starts[I];
+	int *Next = ColStarts;
+	if (Rows > Cols) Next = (int *)GC_MALLOC_ATOMIC(Rows * sizeof(int));
+	memcpy(Next, Starts, Rows * sizeof(int));
+	int *Indices = Sparse->Indices;
+	double *Target = Sparse->Values;
+	for (int I = 0; I < Count; ++I) {
+		int K = Order[I];
+		int Slot = Next[RowIndices[K]]++;
+		Indices[Slot] = ColIndices[K];
+		Target[Slot] = Values[K];
+	}
+	// Sum duplicate entries and drop explicit zeros.
+	int Slot = 0;
+	for (int I = 0; I < Rows; ++I) {
+		int Start = Starts[I], End = Starts[I + 1];
+		Starts[I] = Slot;
+		for (int K = Start; K < End;) {
+			int Col = Indices[K];
+			double Value = Target[K];
+			while (++K < End && Indices[K] == Col) Value += Target[K];
+			if (Value != 0) {
+				Indices[Slot] = Col;
+				Target[Slot] = Value;
+				++Slot;
+			}
+		}
+	}
+	Starts[Rows] = Slot;
+	return (ml_value_t *)Sparse;
+}
+
+ml_value_t *ml_sparse_from_array(ml_array_t *Source) {
+	if (Source->Degree != 2) return ml_error("ShapeError", "Sparse matrix requires two dimensional array");
+	int Rows = Source->Dimensions[0].Size, Cols = Source->Dimensions[1].Size;
+	size_t Total = (size_t)Rows * Cols;
+	if (Source->Format == ML_ARRAY_FORMAT_ANY) {
+		ml_array_t *Boxed = ml_array_copy(Source, ML_ARRAY_FORMAT_ANY);
+		ml_value_t **Boxes = (ml_value_t **)Boxed->Base.Value;
+		for (size_t K = 0; K < Total; ++K) {
+			if (!ml_is(Boxes[K], MLRealT)) return ml_error("TypeError", "Expected real value");
+		}
+	} else if (Source->Format > ML_ARRAY_FORMAT_F64) {
+		return ml_error("TypeError", "Expected real array");
+	}
+	ml_array_t *Dense = ml_array_copy(Source, ML_ARRAY_FORMAT_F64);
+	double *Values = (double *)Dense->Base.Value;
+	int Count = 0;
+	for (size_t K = 0; K < Total; ++K) if (Values[K] != 0) ++Count;
+	ml_sparse_t *Sparse = sparse_new(Rows, Cols, Count);
+	int Slot = 0;
+	for (int I = 0; I < Rows; ++I) {
+		Sparse->Starts[I] = Slot;
+		for (int J = 0; J < Cols; ++J) {
+			double Value = *Values++;
+			if (Value != 0) {
+				Sparse->Indices[Slot] = J;
+				Sparse->Values[Slot] = Value;
+				++Slot;
+			}
+		}
+	}
+	Sparse->Starts[Rows] = Slot;
+	return (ml_value_t *)Sparse;
+}
+
+ml_array_t *ml_sparse_to_array(ml_value_t *Value) {
+	ml_sparse_t *Sparse = (ml_sparse_t *)Value;
+	ml_array_t *Dense = ml_array(ML_ARRAY_FORMAT_F64, 2, Sparse->Rows, Sparse->Cols);
+	double *Values = (double *)Dense->Base.Value;
+	memset(Values, 0, Dense->Base.Length);
+	for (int I = 0; I < Sparse->Rows; ++I) {
+		double *Row = Values + (size_t)I * Sparse->Cols;
+		for (int K = Sparse->Starts[I]; K < Sparse->Starts[I + 1]; ++K) Row[Sparse->Indices[K]] = Sparse->Values[K];
+	}
+	return Dense;
+}
+
+static int sparse_length(ml_value_t *Value) {
+	if (ml_is(Value, MLListT)) return ml_list_length(Value);
+	if (ml_is(Value, MLArrayT) && ml_array_degree(Value) == 1) return ml_array_size(Value, 0);
+	return -1;
+}
+
+static ml_value_t *sparse_indices(ml_value_t *Value, int *Target) {
+	if (ml_is(Value, MLListT)) {
+		ML_LIST_FOREACH(Value, Iter) {
+			if (!ml_is(Iter->Value, MLIntegerT)) return ml_error("TypeError", "Expected integer index");
+			int64_t Index = ml_integer_value(Iter->Value);
+			if (Index < INT_MIN || Index > INT_MAX) return ml_error("IndexError", "Index out of bounds");
+			*Target++ = Index - 1;
+		}
+	} else {
+		ml_array_t *Array = ml_array_copy((ml_array_t *)Value, ML_ARRAY_FORMAT_I64);
+		int64_t *Source = (int64_t *)Array->Base.Value;
+		for (int I = Array->Dimensions[0].Size; --I >= 0;) {
+			int64_t Index = *Source++;
+			if (Index < INT_MIN || Index > INT_MAX) return ml_error("IndexError", "Index out of bounds");
+			*Target++ = Index - 1;
+		}
+	}
+	return NULL;
+}
+
+static ml_value_t *sparse_values(ml_value_t *Value, double *Target) {
+	if (ml_is(Value, MLListT)) {
+		ML_LIST_FOREACH(Value, Iter) {
+			if (!ml_is(Iter->Value, MLRealT)) return ml_error("TypeError", "Expected real value");
+			*Target++ = ml_real_value(Iter->Value);
+		}
+	} else {
+		ml_array_t *Array = ml_array_copy((ml_array_t *)Value, ML_ARRAY_FORMAT_F64);
+		memcpy(Target, Array->Base.Value, Array->Dimensions[0].Size * sizeof(double));
+	}
+	return NULL;
+}
+
+static ml_value_t *sparse_shape(ml_value_t *Shape, int *Rows, int *Cols) {
+	if (ml_list_length(Shape) != 2) return ml_error("ShapeError", "Sparse matrix requires two dimensions");
+	ml_value_t *Row = ml_list_get(Shape, 1), *Col = ml_list_get(Shape, 2);
+	if (!ml_is(Row, MLIntegerT) || !ml_is(Col, MLIntegerT)) return ml_error("TypeError", "Expected integer size");
+	int64_t RowCount = ml_integer_value(Row), ColCount = ml_integer_value(Col);
+	if (RowCount <= 0 || ColCount <= 0) return ml_error("ShapeError", "Invalid size");
+	if (RowCount >= INT_MAX || ColCount >= INT_MAX) return ml_error("ShapeError", "Size too large");
+	*Rows = RowCount;
+	*Cols = ColCount;
+	return NULL;
+}
+
+static ml_value_t *sparse_triplets(ml_value_t **Args, ml_value_t *Shape) {
+	int Count = sparse_length(Args[0]);
+	if (Count < 0) return ml_error("TypeError", "Expected list or one dimensional array of row indices");
+	if (sparse_length(Args[1]) != Count) return ml_error("ShapeError", "Column indices do not match row indices");
+	if (sparse_length(Args[2]) != Count) return ml_error("ShapeError", "Values do not match row indices");
+	int *RowIndices = (int *)GC_MALLOC_ATOMIC((Count + 1) * sizeof(int));
+	int *ColIndices = (int *)GC_MALLOC_ATOMIC((Count + 1) * sizeof(int));
+	double *Values = (double *)GC_MALLOC_ATOMIC((Count + 1) * sizeof(double));
+	ml_value_t *Error;
+	if ((Error = sparse_indices(Args[0], RowIndices))) return Error;
+	if ((Error = sparse_indices(Args[1], ColIndices))) return Error;
+	if ((Error = sparse_values(Args[2], Values))) return Error;
+	int Rows = 0, Cols = 0;
+	if (Shape) {
+		if ((Error = sparse_shape(Shape, &Rows, &Cols))) return Error;
+	} else {
+		for (int K = 0; K < Count; ++K) {
+			if (Rows <= RowIndices[K]) Rows = RowIndices[K] + 1;
+			if (Cols <= ColIndices[K]) Cols = ColIndices[K] + 1;
+		}
+		if (!Rows || !Cols) return ml_error("ShapeError", "Cannot infer shape of empty sparse matrix");
+	}
+	return ml_sparse_coo(Rows, Cols, Count, RowIndices, ColIndices, Values);
+}
+
+ML_METHOD(MLSparseT, MLArrayT) {
+//<Array
+//>sparse
+// Returns a sparse matrix with the nonzero entries of the two dimensional array :mini:`Array`.
+	return ml_sparse_from_array((ml_array_t *)Args[0]);
+}
+
+ML_METHOD(MLSparseT, MLAnyT, MLAnyT, MLAnyT) {
+//<Rows:list|array
+//<Cols:list|array
+//<Values:list|array
+//>sparse
+// Returns a sparse matrix from coordinate (COO) triplets, with entry :mini:`Values[K]` at row :mini:`Rows[K]` and column :mini:`Cols[K]`. Duplicate entries are summed. The shape is the smallest that contains every entry.
+//$= sparse([1, 2, 3], [1, 2, 1], [1, 2, 3])
+	return sparse_triplets(Args, NULL);
+}
+
+ML_METHOD(MLSparseT, MLAnyT, MLAnyT, MLAnyT, MLListT) {
+//<Rows:list|array
+//<Cols:list|array
+//<Values:list|array
+//<Shape
+//>sparse
+// Returns a sparse matrix with shape :mini:`Shape` from coordinate (COO) triplets, with entry :mini:`Values[K]` at row :mini:`Rows[K]` and column :mini:`Cols[K]`. Duplicate entries are summed.
+//$= sparse([1, 2, 3], [1, 2, 1], [1, 2, 3], [1000000, 1000000])
+	return sparse_triplets(Args, Args[3]);
+}
+
+static ml_value_t *ml_sparse_csr_fn(void *Data, int Count, ml_value_t **Args) {
+//<Starts:list|array
+//<Cols:list|array
+//<Values:list|array
+//<Shape:list
+//>sparse
+// Returns a sparse matrix from compressed sparse row (CSR) data. The entries of row :mini:`I` are at positions :mini:`Starts[I]` to :mini:`Starts[I + 1] - 1` of :mini:`Cols` and :mini:`Values`.
+	ML_CHECK_ARG_COUNT(4);
+	ML_CHECK_ARG_TYPE(3, MLListT);
+	int Rows, Cols;
+	ml_value_t *Error;
+	if ((Error = sparse_shape(Args[3], &Rows, &Cols))) return Error;
+	if (sparse_length(Args[0]) != Rows + 1) return ml_error("ShapeError", "Row starts do not match shape");
+	int Total = sparse_length(Args[1]);
+	if (Total < 0) return ml_error("TypeError", "Expected list or one dimensional array of column indices");
+	if (sparse_length(Args[2]) != Total) return ml_error("ShapeError", "Values do not match column indices");
+	ml_sparse_t *Sparse = sparse_new(Rows, Cols, Total);
+	if ((Error = sparse_indices(Args[0], Sparse->Starts))) return Error;
+	if ((Error = sparse_indices(Args[1], Sparse->Indices))) return Error;
+	if ((Error = sparse_values(Args[2], Sparse->Values))) return Error;
+	if (Sparse->Starts[0] != 0 || Sparse->Starts[Rows] != Total) return ml_error("ValueError", "Invalid row starts");
+	for (int I = 0; I < Rows; ++I) {
+		int Start = Sparse->Starts[I], End = Sparse->Starts[I + 1];
+		if (Start > End) return ml_error("ValueError", "Invalid row starts");
+		int Last = -1;
+		for (int K = Start; K < End; ++K) {
+			int Col = Sparse->Indices[K];
+			if (Col >= Cols) return ml_error("IndexError", "Column index out of bounds");
+			if (Col <= Last) return ml_error("ValueError", "Column indices must be increasing within each row");
+			Last = Col;
+		}
+	}
+	return (ml_value_t *)Sparse;
+}
+
+ML_METHOD("shape", MLSparseT) {
+//<Sparse
+//>list
+// Returns the number of rows and columns of :mini:`Sparse`.
+	ml_sparse_t *Sparse = (ml_sparse_t *)Args[0];
+	ml_value_t *Shape = ml_list();
+	ml_list_put(Shape, ml_integer(Sparse->Rows));
+	ml_list_put(Shape, ml_integer(Sparse->Cols));
+	return Shape;
+}
+
+ML_METHOD("nnz", MLSparseT) {
+//<Sparse
+//>integer
+// Returns the number of stored (nonzero) entries in :mini:`Sparse`.
+	return ml_integer(ml_sparse_count(Args[0]));
+}
+
+ML_METHOD("dense", MLSparseT) {
+//<Sparse
+//>array::float64
+// Returns :mini:`Sparse` as a dense two dimensional array.
+	return (ml_value_t *)ml_sparse_to_array(Args[0]);
+}
+
+static ml_array_t *sparse_export_indices(const int *Source, int Count) {
+	ml_array_t *Array = ml_array(ML_ARRAY_FORMAT_I64, 1, Count);
+	int64_t *Target = (int64_t *)Array->Base.Value;
+	for (int I = 0; I < Count; ++I) Target[I] = Source[I] + 1;
+	return Array;
+}
+
+static ml_array_t *sparse_export_values(const double *Source, int Count) {
+	ml_array_t *Array = ml_array(ML_ARRAY_FORMAT_F64, 1, Count);
+	memcpy(Array->Base.Value, Source, Count * sizeof(double));
+	return Array;
+}
+
+ML_METHOD("coo", MLSparseT) {
+//<Sparse
+//>list
+// Returns the coordinate (COO) triplets :mini:`[Rows, Cols, Values]` of :mini:`Sparse` as arrays, in row major order.
+	ml_sparse_t *Sparse = (ml_sparse_t *)Args[0];
+	int Total = Sparse->Starts[Sparse->Rows];
+	ml_array_t *Rows = ml_array(ML_ARRAY_FORMAT_I64, 1, Total);
+	int64_t *Target = (int64_t *)Rows->Base.Value;
+	for (int I = 0; I < Sparse->Rows; ++I) {
+		for (int K = Sparse->Starts[I]; K < Sparse->Starts[I + 1]; ++K) *Target++ = I + 1;
+	}
+	ml_value_t *Result = ml_list();
+	ml_list_put(Result, (ml_value_t *)Rows);
+	ml_list_put(Result, (ml_value_t *)sparse_export_indices(Sparse->Indices, Total));
+	ml_list_put(Result, (ml_value_t *)sparse_export_values(Sparse->Values, Total));
+	return Result;
+}
+
+ML_METHOD("csr", MLSparseT) {
+//<Sparse
+//>list
+// Returns the compressed sparse row (CSR) data :mini:`[Starts, Cols, Values]` of :mini:`Sparse` as arrays. This is the inverse of :mini:`sparse::csr()`.
+	ml_sparse_t *Sparse = (ml_sparse_t *)Args[0];
+	int Total = Sparse->Starts[Sparse->Rows];
+	ml_value_t *Result = ml_list();
+	ml_list_put(Result, (ml_value_t *)sparse_export_indices(Sparse->Starts, Sparse->Rows + 1));
+	ml_list_put(Result, (ml_value_t *)sparse_export_indices(Sparse->Indices, Total));
+	ml_list_put(Result, (ml_value_t *)sparse_export_values(Sparse->Values, Total));
+	return Result;
+}
+
+ML_METHOD("[]", MLSparseT, MLIntegerT, MLIntegerT) {
+//<Sparse
+//<Row
+//<Col
+//>real
+// Returns the entry of :mini:`Sparse` at :mini:`Row`, :mini:`Col`. Negative indices count from the end.
+	ml_sparse_t *Sparse = (ml_sparse_t *)Args[0];
+	int Row = ml_integer_value(Args[1]), Col = ml_integer_value(Args[2]);
+	if (Row <= 0) Row += Sparse->Rows + 1;
+	if (Col <= 0) Col += Sparse->Cols + 1;
+	if (Row <= 0 || Row > Sparse->Rows) return MLNil;
+	if (Col <= 0 || Col > Sparse->Cols) return MLNil;
+	--Col;
+	int Lo = Sparse->Starts[Row - 1], Hi = Sparse->Starts[Row];
+	while (Lo < Hi) {
+		int Mid = Lo + (Hi - Lo) / 2;
+		int Index = Sparse->Indices[Mid];
+		if (Index == Col) return ml_real(Sparse->Values[Mid]);
+		if (Index < Col) Lo = Mid + 1; else Hi = Mid;
+	}
+	return ml_real(0);
+}
+
+static ml_sparse_t *sparse_transpose(ml_sparse_t *A) {
+	int Count = A->Starts[A->Rows];
+	ml_sparse_t *B = sparse_new(A->Cols, A->Rows, Count);
+	int *Starts = B->Starts;
+	memset(Starts, 0, (B->Rows + 1) * sizeof(int));
+	for (int K = 0; K < Count; ++K) ++Starts[A->Indices[K] + 1];
+	for (int I = 0; I < B->Rows; ++I) Starts[I + 1] += Starts[I];
+	int *Next = (int *)GC_MALLOC_ATOMIC((B->Rows + 1) * sizeof(int));
+	memcpy(Next, Starts, B->Rows * sizeof(int));
+	for (int I = 0; I < A->Rows; ++I) {
+		for (int K = A->Starts[I]; K < A->Starts[I + 1]; ++K) {
+			int Slot = Next[A->Indices[K]]++;
+			B->Indices[Slot] = I;
+			B->Values[Slot] = A->Values[K];
+		}
+	}
+	return B;
+}
+
+ML_METHOD("^", MLSparseT) {
+//<Sparse
+//>sparse
+// Returns the transpose of :mini:`Sparse`.
+	return (ml_value_t *)sparse_transpose((ml_sparse_t *)Args[0]);
+}
+
+static ml_sparse_t *sparse_scale(ml_sparse_t *A, double Factor, int Divide) {
+	int Count = A->Starts[A->Rows];
+	ml_sparse_t *B = sparse_new(A->Rows, A->Cols, Count);
+	int Slot = 0;
+	for (int I = 0; I < A->Rows; ++I) {
+		B->Starts[I] = Slot;
+		for (int K = A->Starts[I]; K < A->Starts[I + 1]; ++K) {
+			double Value = Divide ? A->Values[K] / Factor : A->Values[K] * Factor;
+			if (Value != 0) {
+				B->Indices[Slot] = A->Indices[K];
+				B->Values[Slot] = Value;
+				++Slot;
+			}
+		}
+	}
+	B->Starts[A->Rows] = Slot;
+	return B;
+}
+
+ML_METHOD("-", MLSparseT) {
+//<Sparse
+//>sparse
+// Returns :mini:`-Sparse`.
+	return (ml_value_t *)sparse_scale((ml_sparse_t *)Args[0], -1, 0);
+}
+
+ML_METHOD("*", MLSparseT, MLRealT) {
+//<Sparse
+//<Scalar
+//>sparse
+// Returns :mini:`Sparse` with each entry multiplied by :mini:`Scalar`.
+	return (ml_value_t *)sparse_scale((ml_sparse_t *)Args[0], ml_real_value(Args[1]), 0);
+}
+
+ML_METHOD("*", MLRealT, MLSparseT) {
+//<Scalar
+//<Sparse
+//>sparse
+// Returns :mini:`Sparse` with each entry multiplied by :mini:`Scalar`.
+	return (ml_value_t *)sparse_scale((ml_sparse_t *)Args[1], ml_real_value(Args[0]), 0);
+}
+
+ML_METHOD("/", MLSparseT, MLRealT) {
+//<Sparse
+//<Scalar
+//>sparse
+// Returns :mini:`Sparse` with each entry divided by :mini:`Scalar`.
+	return (ml_value_t *)sparse_scale((ml_sparse_t *)Args[0], ml_real_value(Args[1]), 1);
+}
+
+typedef enum {SPARSE_ADD, SPARSE_SUB, SPARSE_MUL} sparse_op_t;
+
+static ml_value_t *sparse_merge(ml_sparse_t *A, ml_sparse_t *B, sparse_op_t Op) {
+	if (A->Rows != B->Rows || A->Cols != B->Cols) return ml_error("ShapeError", "Sparse matrix shapes do not match");
+	int CountA = A->Starts[A->Rows], CountB = B->Starts[B->Rows];
+	int Capacity;
+	if (Op == SPARSE_MUL) {
+		Capacity = CountA < CountB ? CountA : CountB;
+	} else {
+		Capacity = CountA + CountB;
+	}
+	ml_sparse_t *C = sparse_new(A->Rows, A->Cols, Capacity);
+	int Slot = 0;
+	for (int I = 0; I < A->Rows; ++I) {
+		C->Starts[I] = Slot;
+		int KA = A->Starts[I], EndA = A->Starts[I + 1];
+		int KB = B->Starts[I], EndB = B->Starts[I + 1];
+		while (KA < EndA || KB < EndB) {
+			int ColA = KA < EndA ? A->Indices[KA] : INT_MAX;
+			int ColB = KB < EndB ? B->Indices[KB] : INT_MAX;
+			int Col;
+			double Value;
+			if (ColA == ColB) {
+				Col = ColA;
+				double ValueA = A->Values[KA++], ValueB = B->Values[KB++];
+				switch (Op) {
+				case SPARSE_ADD: Value = ValueA + ValueB; break;
+				case SPARSE_SUB: Value = ValueA - ValueB; break;
+				default: Value = ValueA * ValueB; break;
+				}
+			} else if (ColA < ColB) {
+				Col = ColA;
+				Value = A->Values[KA++];
+				if (Op == SPARSE_MUL) continue;
+			} else {
+				Col = ColB;
+				Value = B->Values[KB++];
+				if (Op == SPARSE_MUL) continue;
+				if (Op == SPARSE_SUB) Value = -Value;
+			}
+			if (Value != 0) {
+				C->Indices[Slot] = Col;
+				C->Values[Slot] = Value;
+				++Slot;
+			}
+		}
+	}
+	C->Starts[A->Rows] = Slot;
+	return (ml_value_t *)C;
+}
+
+ML_METHOD("+", MLSparseT, MLSparseT) {
+//<A
+//<B
+//>sparse
+// Returns the elementwise sum of :mini:`A` and :mini:`B`.
+	return sparse_merge((ml_sparse_t *)Args[0], (ml_sparse_t *)Args[1], SPARSE_ADD);
+}
+
+ML_METHOD("-", MLSparseT, MLSparseT) {
+//<A
+//<B
+//>sparse
+// Returns the elementwise difference of :mini:`A` and :mini:`B`.
+	return sparse_merge((ml_sparse_t *)Args[0], (ml_sparse_t *)Args[1], SPARSE_SUB);
+}
+
+ML_METHOD("*", MLSparseT, MLSparseT) {
+//<A
+//<B
+//>sparse
+// Returns the elementwise product of :mini:`A` and :mini:`B`.
+	return sparse_merge((ml_sparse_t *)Args[0], (ml_sparse_t *)Args[1], SPARSE_MUL);
+}
+
+static ml_array_t *sparse_dense_arg(ml_sparse_t *A, ml_array_t *B) {
+	if (B->Degree != 2) return NULL;
+	if (B->Dimensions[0].Size != A->Rows || B->Dimensions[1].Size != A->Cols) return NULL;
+	return ml_array_copy(B, ML_ARRAY_FORMAT_F64);
+}
+
+static ml_value_t *sparse_add_dense(ml_sparse_t *A, ml_array_t *B, double SignA, double SignB) {
+	ml_array_t *C = sparse_dense_arg(A, B);
+	if (!C) return ml_error("ShapeError", "Array shape does not match sparse matrix");
+	double *Values = (double *)C->Base.Value;
+	if (SignB != 1) {
+		size_t Total = (size_t)A->Rows * A->Cols;
+		for (size_t K = 0; K < Total; ++K) Values[K] = -Values[K];
+	}
+	for (int I = 0; I < A->Rows; ++I) {
+		double *Row = Values + (size_t)I * A->Cols;
+		for (int K = A->Starts[I]; K < A->Starts[I + 1]; ++K) Row[A->Indices[K]] += SignA * A->Values[K];
+	}
+	return (ml_value_t *)C;
+}
+
+ML_METHOD("+", MLSparseT, MLArrayT) {
+//<A
+//<B
+//>array::float64
+// Returns the elementwise sum of :mini:`A` and :mini:`B` as a dense array.
+	return sparse_add_dense((ml_sparse_t *)Args[0], (ml_array_t *)Args[1], 1, 1);
+}
+
+ML_METHOD("+", MLArrayT, MLSparseT) {
+//<A
+//<B
+//>array::float64
+// Returns the elementwise sum of :mini:`A` and :mini:`B` as a dense array.
+	return sparse_add_dense((ml_sparse_t *)Args[1], (ml_array_t *)Args[0], 1, 1);
+}
+
+ML_METHOD("-", MLSparseT, MLArrayT) {
+//<A
+//<B
+//>array::float64
+// Returns the elementwise difference of :mini:`A` and :mini:`B` as a dense array.
+	return sparse_add_dense((ml_sparse_t *)Args[0], (ml_array_t *)Args[1], 1, -1);
+}
+
+ML_METHOD("-", MLArrayT, MLSparseT) {
+//<A
+//<B
+//>array::float64
+// Returns the elementwise difference of :mini:`A` and :mini:`B` as a dense array.
+	return sparse_add_dense((ml_sparse_t *)Args[1], (ml_array_t *)Args[0], -1, 1);
+}
+
+static ml_value_t *sparse_mul_dense(ml_sparse_t *A, ml_array_t *B) {
+	ml_array_t *Dense = sparse_dense_arg(A, B);
+	if (!Dense) return ml_error("ShapeError", "Array shape does not match sparse matrix");
+	double *Values = (double *)Dense->Base.Value;
+	ml_sparse_t *C = sparse_new(A->Rows, A->Cols, A->Starts[A->Rows]);
+	int Slot = 0;
+	for (int I = 0; I < A->Rows; ++I) {
+		C->Starts[I] = Slot;
+		double *Row = Values + (size_t)I * A->Cols;
+		for (int K = A->Starts[I]; K < A->Starts[I + 1]; ++K) {
+			double Value = A->Values[K] * Row[A->Indices[K]];
+			if (Value != 0) {
+				C->Indices[Slot] = A->Indices[K];
+				C->Values[Slot] = Value;
+				++Slot;
+			}
+		}
+	}
+	C->Starts[A->Rows] = Slot;
+	return (ml_value_t *)C;
+}
+
+ML_METHOD("*", MLSparseT, MLArrayT) {
+//<A
+//<B
+//>sparse
+// Returns the elementwise product of :mini:`A` and :mini:`B`. The result is sparse.
+	return sparse_mul_dense((ml_sparse_t *)Args[0], (ml_array_t *)Args[1]);
+}
+
+ML_METHOD("*", MLArrayT, MLSparseT) {
+//<A
+//<B
+//>sparse
+// Returns the elementwise product of :mini:`A` and :mini:`B`. The result is sparse.
+	return sparse_mul_dense((ml_sparse_t *)Args[1], (ml_array_t *)Args[0]);
+}
+
+ML_METHOD(".", MLSparseT, MLArrayT) {
+//<A
+//<B
+//>array::float64
+// Returns the matrix product of :mini:`A` with the vector or matrix :mini:`B`.
+	ml_sparse_t *A = (ml_sparse_t *)Args[0];
+	ml_array_t *B = (ml_array_t *)Args[1];
+	if (B->Degree < 1 || B->Degree > 2 || B->Dimensions[0].Size != A->Cols) {
+		return ml_error("ShapeError", "Incompatible shapes for product");
+	}
+	double *Source = (double *)ml_array_copy(B, ML_ARRAY_FORMAT_F64)->Base.Value;
+	if (B->Degree == 1) {
+		ml_array_t *C = ml_array(ML_ARRAY_FORMAT_F64, 1, A->Rows);
+		double *Target = (double *)C->Base.Value;
+		for (int I = 0; I < A->Rows; ++I) {
+			double Sum = 0;
+			for (int K = A->Starts[I]; K < A->Starts[I + 1]; ++K) Sum += A->Values[K] * Source[A->Indices[K]];
+			Target[I] = Sum;
+		}
+		return (ml_value_t *)C;
+	}
+	int Width = B->Dimensions[1].Size;
+	ml_array_t *C = ml_array(ML_ARRAY_FORMAT_F64, 2, A->Rows, Width);
+	double *Target = (double *)C->Base.Value;
+	memset(Target, 0, C->Base.Length);
+	for (int I = 0; I < A->Rows; ++I) {
+		double *TargetRow = Target + (size_t)I * Width;
+		for (int K = A->Starts[I]; K < A->Starts[I + 1]; ++K) {
+			double Value = A->Values[K];
+			double *SourceRow = Source + (size_t)A->Indices[K] * Width;
+			for (int J = 0; J < Width; ++J) TargetRow[J] += Value * SourceRow[J];
+		}
+	}
+	return (ml_value_t *)C;
+}
+
+ML_METHOD(".", MLArrayT, MLSparseT) {
+//<A
+//<B
+//>array::float64
+// Returns the matrix product of the vector or matrix :mini:`A` with :mini:`B`.
+	ml_array_t *A = (ml_array_t *)Args[0];
+	ml_sparse_t *B = (ml_sparse_t *)Args[1];
+	if (A->Degree < 1 || A->Degree > 2 || A->Dimensions[A->Degree - 1].Size != B->Rows) {
+		return ml_error("ShapeError", "Incompatible shapes for product");
+	}
+	double *Source = (double *)ml_array_copy(A, ML_ARRAY_FORMAT_F64)->Base.Value;
+	int Height = A->Degree == 2 ? A->Dimensions[0].Size : 1;
+	ml_array_t *C;
+	if (A->Degree == 1) {
+		C = ml_array(ML_ARRAY_FORMAT_F64, 1, B->Cols);
+	} else {
+		C = ml_array(ML_ARRAY_FORMAT_F64, 2, Height, B->Cols);
+	}
+	double *Target = (double *)C->Base.Value;
+	memset(Target, 0, C->Base.Length);
+	for (int P = 0; P < Height; ++P) {
+		double *SourceRow = Source + (size_t)P * B->Rows;
+		double *TargetRow = Target + (size_t)P * B->Cols;
+		for (int I = 0; I < B->Rows; ++I) {
+			double Value = SourceRow[I];
+			if (Value == 0) continue;
+			for (int K = B->Starts[I]; K < B->Starts[I + 1]; ++K) TargetRow[B->Indices[K]] += Value * B->Values[K];
+		}
+	}
+	return (ml_value_t *)C;
+}
+
+static int sparse_compare_int(const void *A, const void *B) {
+	return *(const int *)A - *(const int *)B;
+}
+
+ML_METHOD(".", MLSparseT, MLSparseT) {
+//<A
+//<B
+//>sparse
+// Returns the matrix product of :mini:`A` and :mini:`B`.
+	ml_sparse_t *A = (ml_sparse_t *)Args[0];
+	ml_sparse_t *B = (ml_sparse_t *)Args[1];
+	if (A->Cols != B->Rows) return ml_error("ShapeError", "Incompatible shapes for product");
+	int Cols = B->Cols;
+	int *Marker = (int *)GC_MALLOC_ATOMIC(Cols * sizeof(int));
+	for (int J = 0; J < Cols; ++J) Marker[J] = -1;
+	double *Accum = (double *)GC_MALLOC_ATOMIC(Cols * sizeof(double));
+	int *Touched = (int *)GC_MALLOC_ATOMIC(Cols * sizeof(int));
+	int Capacity = A->Starts[A->Rows] + B->Starts[B->Rows];
+	ml_sparse_t *C = sparse_new(A->Rows, Cols, Capacity);
+	int Slot = 0;
+	for (int I = 0; I < A->Rows; ++I) {
+		C->Starts[I] = Slot;
+		int Size = 0;
+		for (int KA = A->Starts[I]; KA < A->Starts[I + 1]; ++KA) {
+			double Value = A->Values[KA];
+			int Row = A->Indices[KA];
+			for (int KB = B->Starts[Row]; KB < B->Starts[Row + 1]; ++KB) {
+				int Col = B->Indices[KB];
+				if (Marker[Col] != I) {
+					Marker[Col] = I;
+					Accum[Col] = 0;
+					Touched[Size++] = Col;
+				}
+				Accum[Col] += Value * B->Values[KB];
+			}
+		}
+		if (Slot + Size > Capacity) {
+			do Capacity *= 2; while (Slot + Size > Capacity);
+			int *Indices = (int *)GC_MALLOC_ATOMIC(Capacity * sizeof(int));
+			memcpy(Indices, C->Indices, Slot * sizeof(int));
+			C->Indices = Indices;
+			double *Values = (double *)GC_MALLOC_ATOMIC(Capacity * sizeof(double));
+			memcpy(Values, C->Values, Slot * sizeof(double));
+			C->Values = Values;
+		}
+		qsort(Touched, Size, sizeof(int), sparse_compare_int);
+		for (int K = 0; K < Size; ++K) {
+			int Col = Touched[K];
+			double Value = Accum[Col];
+			if (Value != 0) {
+				C->Indices[Slot] = Col;
+				C->Values[Slot] = Value;
+				++Slot;
+			}
+		}
+	}
+	C->Starts[A->Rows] = Slot;
+	return (ml_value_t *)C;
+}
+
+ML_METHOD("append", MLStringBufferT, MLSparseT) {
+//<Buffer
+//<Sparse
+// Appends a summary of :mini:`Sparse` to :mini:`Buffer`.
+	ml_stringbuffer_t *Buffer = (ml_stringbuffer_t *)Args[0];
+	ml_sparse_t *Sparse = (ml_sparse_t *)Args[1];
+	ml_stringbuffer_addf(Buffer, "<sparse %d x %d: %d>", Sparse->Rows, Sparse->Cols, Sparse->Starts[Sparse->Rows]);
+	return MLSome;
+}
+
+ML_METHOD(MLStringT, MLSparseT) {
+//<Sparse
+//>string
+// Returns a summary of :mini:`Sparse` as a string.
+	ml_sparse_t *Sparse = (ml_sparse_t *)Args[0];
+	return ml_string_format("<sparse %d x %d: %d>", Sparse->Rows, Sparse->Cols, Sparse->Starts[Sparse->Rows]);
+}
+
+void ml_sparse_init(stringmap_t *Globals) {
+#include "ml_sparse_init.c"
+	stringmap_insert(MLSparseT->Exports, "csr", ml_cfunction(NULL, ml_sparse_csr_fn));
+	stringmap_insert(Globals, "sparse", MLSparseT);
+}
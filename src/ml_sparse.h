@@ -0,0 +1,25 @@
+#ifndef ML_SPARSE_H
+#define ML_SPARSE_H
+
+#include "minilang.h"
+#include "ml_array.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+extern ml_type_t MLSparseT[];
+
+void ml_sparse_init(stringmap_t *Globals);
+ml_value_t *ml_sparse_coo(int Rows, int Cols, int Count, const int *RowIndices, const int *ColIndices, const double *Values);
+ml_value_t *ml_sparse_from_array(ml_array_t *Source);
+ml_array_t *ml_sparse_to_array(ml_value_t *Sparse);
+int ml_sparse_rows(ml_value_t *Sparse);
+int ml_sparse_cols(ml_value_t *Sparse);
+int ml_sparse_count(ml_value_t *Sparse);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif
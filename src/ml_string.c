@@ -723,6 +723,25 @@ static void ML_TYPED_FN(ml_iterate, MLStringT, ml_state_t *Caller, ml_value_t *S
 	ML_RETURN(Iter);
 }
 
+static int ML_TYPED_FN(ml_iter_block, MLStringT, ml_value_t *String, ml_iter_cursor_t *Cursor, ml_value_t **Keys, ml_value_t **Values, int Size) {
+	long Index = Cursor->Index;
+	int Count = ml_string_length(String) - Index;
+	if (Count > Size) Count = Size;
+	const char *Value = ml_string_value(String) + Index;
+	for (int I = 0; I < Count; ++I) {
+		if (Keys) Keys[I] = ml_integer(Index + I + 1);
+		if (Values) Values[I] = ml_string(Value + I, 1);
+	}
+	Cursor->Index = Index + Count;
+	return Count;
+}
+
+static long ML_TYPED_FN(ml_iter_seek, MLStringT, ml_value_t *String, ml_iter_cursor_t *Cursor, long Index) {
+	long Length = ml_string_length(String);
+	Cursor->Index = Index < Length ? Index : Length;
+	return Length;
+}
+
 typedef struct ml_regex_t ml_regex_t;
 
 typedef struct ml_regex_t {
@@ -41,6 +41,8 @@ ML_METHOD_DECL(IndexMethod, "[]");
 ML_METHOD_DECL(SymbolMethod, "::");
 ML_METHOD_DECL(LessMethod, "<");
 ML_METHOD_DECL(CallMethod, "()");
+static ML_METHOD_DECL(GreaterMethod, ">");
+static ML_METHOD_DECL(AddMethod, "+");
 ML_METHOD_ANON(MLSequenceCount, "sequence::count");
 
 static inline uintptr_t rotl(uintptr_t X, unsigned int N) {
@@ -912,6 +914,44 @@ void ml_iter_next(ml_state_t *Caller, ml_value_t *Iter) {
 	return function(Caller, Iter);
 }
 
+int ml_iter_pair(ml_value_t *Iter, ml_value_t **Key, ml_value_t **Value) {
+	typeof(ml_iter_pair) *function = ml_typed_fn_get(ml_typeof(Iter), ml_iter_pair);
+	if (!function) return 0;
+	return function(Iter, Key, Value);
+}
+
+int ml_iter_block(ml_value_t *Value, ml_iter_cursor_t *Cursor, ml_value_t **Keys, ml_value_t **Values, int Size) {
+	typeof(ml_iter_block) *function = ml_typed_fn_get(ml_typeof(Value), ml_iter_block);
+	if (!function) return -1;
+	return function(Value, Cursor, Keys, Values, Size);
+}
+
+ml_value_t *ml_iter_reduce(ml_value_t *Value, ml_value_t *Function, ml_value_t *Initial) {
+	typeof(ml_iter_reduce) *function = ml_typed_fn_get(ml_typeof(Value), ml_iter_reduce);
+	if (!function) return NULL;
+	return function(Value, Function, Initial);
+}
+
+long ml_iter_seek(ml_value_t *Value, ml_iter_cursor_t *Cursor, long Index) {
+	typeof(ml_iter_seek) *function = ml_typed_fn_get(ml_typeof(Value), ml_iter_seek);
+	if (!function) return -1;
+	return function(Value, Cursor, Index);
+}
+
+ml_value_t *ml_iter_last(ml_value_t *Value) {
+	typeof(ml_iter_last) *function = ml_typed_fn_get(ml_typeof(Value), ml_iter_last);
+	if (function) return function(Value);
+	ml_iter_cursor_t Cursor[1] = {{NULL, 0}};
+	long Length = ml_iter_seek(Value, Cursor, LONG_MAX);
+	if (Length < 0) return NULL;
+	if (Length == 0) return MLNil;
+	*Cursor = (ml_iter_cursor_t){NULL, 0};
+	ml_iter_seek(Value, Cursor, Length - 1);
+	ml_value_t *Last;
+	if (ml_iter_block(Value, Cursor, NULL, &Last, 1) != 1) return NULL;
+	return Last;
+}
+
 // Functions //
 
 ML_METHODX("!", MLFunctionT, MLTupleT) {
@@ -1370,6 +1410,23 @@ static void ML_TYPED_FN(ml_iterate, MLTupleT, ml_state_t *Caller, ml_tuple_t *Tu
 	ML_RETURN(Iter);
 }
 
+static int ML_TYPED_FN(ml_iter_block, MLTupleT, ml_tuple_t *Tuple, ml_iter_cursor_t *Cursor, ml_value_t **Keys, ml_value_t **Values, int Size) {
+	long Index = Cursor->Index;
+	int Count = Tuple->Size - Index;
+	if (Count > Size) Count = Size;
+	for (int I = 0; I < Count; ++I) {
+		if (Keys) Keys[I] = ml_integer(Index + I + 1);
+		if (Values) Values[I] = ml_deref(Tuple->Values[Index + I]);
+	}
+	Cursor->Index = Index + Count;
+	return Count;
+}
+
+static long ML_TYPED_FN(ml_iter_seek, MLTupleT, ml_tuple_t *Tuple, ml_iter_cursor_t *Cursor, long Index) {
+	Cursor->Index = Index < Tuple->Size ? Index : Tuple->Size;
+	return Tuple->Size;
+}
+
 ML_METHOD(MLStringT, MLTupleT) {
 //!tuple
 //<Tuple
@@ -2282,17 +2339,77 @@ static void ML_TYPED_FN(ml_iterate, MLIntegerRangeT, ml_state_t *Caller, ml_valu
 ML_TYPE(MLIntegerRangeT, (MLSequenceT), "integer-range");
 //!range
 
+static uint64_t ml_integer_range_length(ml_integer_range_t *Range) {
+	if (Range->Step > 0) {
+		if (Range->Start > Range->Limit) return 0;
+		return ((uint64_t)Range->Limit - (uint64_t)Range->Start) / Range->Step + 1;
+	} else if (Range->Step < 0) {
+		if (Range->Start < Range->Limit) return 0;
+		return ((uint64_t)Range->Start - (uint64_t)Range->Limit) / -(uint64_t)Range->Step + 1;
+	} else {
+		return 0;
+	}
+}
+
+static int ML_TYPED_FN(ml_iter_block, MLIntegerRangeT, ml_integer_range_t *Range, ml_iter_cursor_t *Cursor, ml_value_t **Keys, ml_value_t **Values, int Size) {
+	long Index = Cursor->Index, Step = Range->Step;
+	int Count = Size;
+	if (Step) {
+		uint64_t Remaining = ml_integer_range_length(Range) - Index;
+		if (Count > Remaining) Count = Remaining;
+	}
+	long Current = Range->Start + Index * Step;
+	for (int I = 0; I < Count; ++I, Current += Step) {
+		if (Keys) Keys[I] = ml_integer(Index + I + 1);
+		if (Values) Values[I] = ml_integer(Current);
+	}
+	Cursor->Index = Index + Count;
+	return Count;
+}
+
+static long ML_TYPED_FN(ml_iter_seek, MLIntegerRangeT, ml_integer_range_t *Range, ml_iter_cursor_t *Cursor, long Index) {
+	if (!Range->Step) return -1;
+	uint64_t Length = ml_integer_range_length(Range);
+	if (Length > LONG_MAX) return -1;
+	Cursor->Index = Index < Length ? Index : Length;
+	return Length;
+}
+
+static ml_value_t *ML_TYPED_FN(ml_iter_reduce, MLIntegerRangeT, ml_integer_range_t *Range, ml_value_t *Function, ml_value_t *Initial) {
+	if (!Range->Step) return NULL;
+	if (Initial && !ml_is(Initial, MLIntegerT)) return NULL;
+	uint64_t Length = ml_integer_range_length(Range);
+	if (!Length) return MLNil;
+	int64_t First = Range->Start;
+	int64_t Last = (uint64_t)First + (Length - 1) * (uint64_t)Range->Step;
+	if (Function == AddMethod) {
+		// Unsigned arithmetic wraps the same way as adding the values one at a time.
+		uint64_t Sum = Length * (uint64_t)First + (uint64_t)(((unsigned __int128)Length * (Length - 1)) / 2) * (uint64_t)Range->Step;
+		if (Initial) Sum += (uint64_t)ml_integer_value_fast(Initial);
+		return ml_integer(Sum);
+	} else if (Function == GreaterMethod) {
+		int64_t Min = Range->Step > 0 ? First : Last;
+		if (Initial && ml_integer_value_fast(Initial) <= Min) return Initial;
+		return ml_integer(Min);
+	} else if (Function == LessMethod) {
+		int64_t Max = Range->Step > 0 ? Last : First;
+		if (Initial && ml_integer_value_fast(Initial) >= Max) return Initial;
+		return ml_integer(Max);
+	}
+	return NULL;
+}
+
+static ml_value_t *ML_TYPED_FN(ml_iter_last, MLIntegerRangeT, ml_integer_range_t *Range) {
+	if (!Range->Step) return NULL;
+	uint64_t Length = ml_integer_range_length(Range);
+	if (!Length) return MLNil;
+	return ml_integer((uint64_t)Range->Start + (Length - 1) * (uint64_t)Range->Step);
+}
+
 ML_METHOD(MLSequenceCount, MLIntegerRangeT) {
 //!internal
 	ml_integer_range_t *Range = (ml_integer_range_t *)Args[0];
-	int64_t Diff = Range->Limit - Range->Start;
-	if (!Range->Step) {
-		return (ml_value_t *)Zero;
-	} else if (Range->Limit < Range->Start) {
-		return (ml_value_t *)Zero;
-	} else {
-		return ml_integer(Diff / Range->Step + 1);
-	}
+	return ml_integer(ml_integer_range_length(Range));
 }
 
 ML_METHOD("..", MLIntegerT, MLIntegerT) {
@@ -2347,14 +2464,56 @@ ML_METHOD("count", MLIntegerRangeT) {
 //<X
 //>integer
 	ml_integer_range_t *Range = (ml_integer_range_t *)Args[0];
-	int64_t Diff = Range->Limit - Range->Start;
-	if (!Range->Step) {
-		return (ml_value_t *)Zero;
-	} else if (Range->Limit < Range->Start) {
-		return (ml_value_t *)Zero;
+	return ml_integer(ml_integer_range_length(Range));
+}
+
+ML_METHOD("limit", MLIntegerRangeT, MLIntegerT) {
+//!range
+//<Range
+//<Limit
+//>integerrange
+// Returns a range with the first :mini:`Limit` values of :mini:`Range`.
+	ml_integer_range_t *Range0 = (ml_integer_range_t *)Args[0];
+	int64_t Limit = ml_integer_value_fast(Args[1]);
+	if (Limit < 0) return ml_error("ValueError", "Limit must be non-negative");
+	if (!Range0->Step) return ml_limited(Args[0], Limit);
+	uint64_t Length = ml_integer_range_length(Range0);
+	if (Limit >= Length) return Args[0];
+	ml_integer_range_t *Range = new(ml_integer_range_t);
+	Range->Type = MLIntegerRangeT;
+	Range->Step = Range0->Step;
+	if (Limit) {
+		Range->Start = Range0->Start;
+		Range->Limit = (uint64_t)Range->Start + (Limit - 1) * (uint64_t)Range->Step;
 	} else {
-		return ml_integer(Diff / Range->Step + 1);
+		Range->Start = Range->Step > 0 ? 1 : 0;
+		Range->Limit = Range->Step > 0 ? 0 : 1;
 	}
+	return (ml_value_t *)Range;
+}
+
+ML_METHOD("skip", MLIntegerRangeT, MLIntegerT) {
+//!range
+//<Range
+//<Skip
+//>integerrange
+// Returns a range with the values of :mini:`Range` after the first :mini:`Skip`.
+	ml_integer_range_t *Range0 = (ml_integer_range_t *)Args[0];
+	int64_t Skip = ml_integer_value_fast(Args[1]);
+	if (Skip < 0) return ml_error("ValueError", "Skip must be non-negative");
+	if (!Range0->Step || !Skip) return Args[0];
+	uint64_t Length = ml_integer_range_length(Range0);
+	ml_integer_range_t *Range = new(ml_integer_range_t);
+	Range->Type = MLIntegerRangeT;
+	Range->Step = Range0->Step;
+	Range->Limit = Range0->Limit;
+	if (Skip >= Length) {
+		Range->Start = Range->Step > 0 ? 1 : 0;
+		Range->Limit = Range->Step > 0 ? 0 : 1;
+	} else {
+		Range->Start = (uint64_t)Range0->Start + Skip * (uint64_t)Range->Step;
+	}
+	return (ml_value_t *)Range;
 }
 
 ML_METHOD("in", MLIntegerT, MLIntegerRangeT) {
@@ -2413,6 +2572,7 @@ typedef struct ml_real_range_t {
 
 static void ML_TYPED_FN(ml_iterate, MLRealRangeT, ml_state_t *Caller, ml_value_t *Value) {
 	ml_real_range_t *Range = (ml_real_range_t *)Value;
+	if (Range->Count <= 0) ML_RETURN(MLNil);
 	if (Range->Step > 0 && Range->Start > Range->Limit) ML_RETURN(MLNil);
 	if (Range->Step < 0 && Range->Start < Range->Limit) ML_RETURN(MLNil);
 	ml_real_iter_t *Iter = new(ml_real_iter_t);
@@ -2434,6 +2594,45 @@ ML_METHOD(MLSequenceCount, MLRealRangeT) {
 	return ml_integer(Range->Count);
 }
 
+ML_METHOD("limit", MLRealRangeT, MLIntegerT) {
+//!range
+//<Range
+//<Limit
+//>realrange
+// Returns a range with the first :mini:`Limit` values of :mini:`Range`.
+	ml_real_range_t *Range0 = (ml_real_range_t *)Args[0];
+	long Limit = ml_integer_value_fast(Args[1]);
+	if (Limit < 0) return ml_error("ValueError", "Limit must be non-negative");
+	if (Limit >= Range0->Count) return Args[0];
+	ml_real_range_t *Range = new(ml_real_range_t);
+	*Range = *Range0;
+	Range->Limit = Range->Start + (Limit - 1) * Range->Step;
+	Range->Count = Limit;
+	return (ml_value_t *)Range;
+}
+
+ML_METHOD("skip", MLRealRangeT, MLIntegerT) {
+//!range
+//<Range
+//<Skip
+//>realrange
+// Returns a range with the values of :mini:`Range` after the first :mini:`Skip`.
+	ml_real_range_t *Range0 = (ml_real_range_t *)Args[0];
+	long Skip = ml_integer_value_fast(Args[1]);
+	if (Skip < 0) return ml_error("ValueError", "Skip must be non-negative");
+	if (!Skip) return Args[0];
+	ml_real_range_t *Range = new(ml_real_range_t);
+	*Range = *Range0;
+	if (Skip >= Range0->Count) {
+		Range->Start += Range0->Count * Range->Step;
+		Range->Count = 0;
+	} else {
+		Range->Start += Skip * Range->Step;
+		Range->Count -= Skip;
+	}
+	return (ml_value_t *)Range;
+}
+
 ML_METHOD("..", MLNumberT, MLNumberT) {
 //!range
 //<Start
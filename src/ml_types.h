@@ -266,7 +266,39 @@ void ml_iter_value(ml_state_t *Caller, ml_value_t *Iter);
 void ml_iter_key(ml_state_t *Caller, ml_value_t *Iter);
 void ml_iter_next(ml_state_t *Caller, ml_value_t *Iter);
 
+// ml_iter_pair() fetches the current key and value (either may be NULL) of an iterator that holds them directly, e.g. a suspended generator.
+// It returns 0 if the iterator needs ml_iter_key() / ml_iter_value() instead.
+
+int ml_iter_pair(ml_value_t *Iter, ml_value_t **Key, ml_value_t **Value);
+
+// Block iteration lets native sequences hand out many elements per call without going through the iterator protocol.
+// ml_iter_block() fills up to Size keys and values (either may be NULL) starting from a zero initialized cursor.
+// It returns the number of elements produced, 0 at the end or -1 if the sequence does not support block iteration.
+// Values may be references (as from ml_iter_value()) and must be passed through ml_deref() by consumers.
+// Lists and maps produce their nodes so that iterators built from blocks (such as skip) can still be assigned through.
+
+#define ML_ITER_BLOCK_SIZE 64
+
+typedef struct {
+	void *Node;
+	long Index;
+} ml_iter_cursor_t;
+
+int ml_iter_block(ml_value_t *Value, ml_iter_cursor_t *Cursor, ml_value_t **Keys, ml_value_t **Values, int Size);
+
+// ml_iter_seek() moves a zero initialized cursor to the element at Index (from 0) so that ml_iter_block() continues from there.
+// It returns the total number of elements or -1 if the sequence cannot seek.
+
+long ml_iter_seek(ml_value_t *Value, ml_iter_cursor_t *Cursor, long Index);
+
+// Aggregates that some sequences can compute without iterating, each returns NULL if the sequence does not support it.
+// ml_iter_reduce() returns Fn(... Fn(Initial, V/1) ..., V/n) (Initial may be NULL) and ml_iter_last() returns the last value.
+
+ml_value_t *ml_iter_reduce(ml_value_t *Value, ml_value_t *Function, ml_value_t *Initial);
+ml_value_t *ml_iter_last(ml_value_t *Value);
+
 ml_value_t *ml_chained(int Count, ml_value_t **Functions);
+ml_value_t *ml_limited(ml_value_t *Value, long Limit);
 
 // Functions //
 
@@ -732,6 +764,9 @@ ml_map_node_t *ml_map_slot(ml_value_t *Map, ml_value_t *Key);
 ml_value_t *ml_map_insert(ml_value_t *Map, ml_value_t *Key, ml_value_t *Value);
 ml_value_t *ml_map_delete(ml_value_t *Map, ml_value_t *Key);
 
+// Builds a map from Size nodes with distinct keys (with Key, Value and Hash set) in the given order, without rebalancing.
+ml_value_t *ml_map_from_nodes(ml_map_node_t **Nodes, int Size);
+
 static inline int ml_map_size(ml_value_t *Map) {
 	return ((ml_map_t *)Map)->Size;
 }
@@ -0,0 +1,59 @@
+#include <stdio.h>
+#include <pthread.h>
+#include "minilang.h"
+#include "ml_sequence.h"
+
+// Runs the same script in one isolate per thread. Each isolate sees its own Id and methods and the shared globals,
+// and each thread runs its own scheduler queue and frame cache, which are released when the thread exits.
+
+#define THREADS 4
+#define ROUNDS 3
+
+static stringmap_t Shared[1] = {STRINGMAP_INIT};
+static const char *ScriptName;
+
+typedef struct {
+	int Id;
+	const char *Result;
+} isolate_job_t;
+
+static const char *isolate_result(ml_value_t *Value) {
+	if (ml_is_error(Value)) Value = ml_string_format("%s: %s", ml_error_type(Value), ml_error_message(Value));
+	return ml_string_value(Value);
+}
+
+static void *isolate_thread(void *Data) {
+	isolate_job_t *Job = (isolate_job_t *)Data;
+	ml_isolate_t *Isolate = ml_isolate_new((ml_getter_t)stringmap_search, Shared);
+	ml_isolate_global_set(Isolate, "Id", ml_integer(Job->Id));
+	ml_value_t *Function = ml_isolate_load(Isolate, ScriptName, NULL);
+	if (!ml_is_error(Function)) Function = ml_isolate_call(Isolate, Function, 0, NULL);
+	if (!ml_is_error(Function)) {
+		ml_value_t *Arg = ml_integer(Job->Id * 10);
+		Function = ml_isolate_call(Isolate, Function, 1, &Arg);
+	}
+	Job->Result = isolate_result(Function);
+	return NULL;
+}
+
+int main(int Argc, const char *Argv[]) {
+	ml_init();
+	ml_types_init(Shared);
+	ml_sequence_init(Shared);
+	stringmap_insert(Shared, "sleep", MLSleep);
+	stringmap_insert(Shared, "Shared", ml_integer(7));
+	ScriptName = Argc > 1 ? Argv[1] : "isolates1.mini";
+	for (int Round = 1; Round <= ROUNDS; ++Round) {
+		isolate_job_t Jobs[THREADS];
+		pthread_t Threads[THREADS];
+		for (int I = 0; I < THREADS; ++I) {
+			Jobs[I].Id = Round * THREADS + I;
+			pthread_create(&Threads[I], NULL, isolate_thread, &Jobs[I]);
+		}
+		for (int I = 0; I < THREADS; ++I) {
+			pthread_join(Threads[I], NULL);
+			printf("%d: %s\n", Jobs[I].Id, Jobs[I].Result);
+		}
+	}
+	return 0;
+}